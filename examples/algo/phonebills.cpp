@@ -14,9 +14,11 @@
 
 //! [prolog]
 #include <algorithm>
+#include <cstdlib>
 #include <ctime>
 #include <fstream>
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include <stxxl.h>      // STXXL header
@@ -42,6 +44,28 @@ std::istream& operator >> (std::istream& i, LogEntry& entry)
     return i;
 }
 
+#ifdef USE_STXXL
+// line parser used by stxxl::stream::parse_lines for reading from the file
+struct ParseLogEntry
+{
+    using value_type = LogEntry;
+
+    bool operator () (const char* begin, const char* end, LogEntry& entry) const
+    {
+        if (begin == end)
+            return false;
+
+        std::string line(begin, end);
+        char* pos;
+        entry.from = strtoll(line.c_str(), &pos, 10);
+        entry.to = strtoll(pos, &pos, 10);
+        entry.timestamp = static_cast<time_t>(strtoll(pos, &pos, 10));
+        entry.event = static_cast<int>(strtol(pos, &pos, 10));
+        return true;
+    }
+};
+#endif
+
 // output operator used for writing to file
 std::ostream& operator << (std::ostream& i, const LogEntry& entry)
 {
@@ -145,12 +169,26 @@ int main(int argc, char* argv[])
     }
 
     // read from the file
-    std::fstream in(argv[1], std::ios::in);
     vector_type v;
 
+#ifndef USE_STXXL
+    std::fstream in(argv[1], std::ios::in);
+
     std::copy(std::istream_iterator<LogEntry>(in),
               std::istream_iterator<LogEntry>(),
               std::back_inserter(v));
+#else
+    {
+        // parse the log in parallel chunks using large asynchronous reads
+        foxxll::file_ptr in = tlx::make_counting<foxxll::syscall_file>(
+            argv[1], foxxll::file::RDONLY);
+        stxxl::stream::parse_lines<ParseLogEntry> entries(in);
+
+        vector_type::bufwriter_type writer(v);
+        for ( ; !entries.empty(); ++entries)
+            writer << *entries;
+    }
+#endif
 
     // sort by callers
 #ifndef USE_STXXL
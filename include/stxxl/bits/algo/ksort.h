@@ -750,6 +750,7 @@ void ksort(ExtIterator first, ExtIterator last, KeyExtractorWithMinMax keyobj, s
     foxxll::block_manager* mng = foxxll::block_manager::get_instance();
 
     first.flush();
+    first.parent_vector()->unshare(first, last);
 
     if ((last - first) * sizeof(value_type) < M)
     {
@@ -276,6 +276,7 @@ void random_shuffle(
     using buf_ostream_type = foxxll::buf_ostream<block_type, bids_container_iterator>;
 
     first.flush();     // flush container
+    first.parent_vector()->unshare(first, last);
 
     // create prefetching stream,
     buf_istream_type in(first.bid(), last.bid() + ((last.block_offset()) ? 1 : 0), 2);
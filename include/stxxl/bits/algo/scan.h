@@ -140,6 +140,7 @@ UnaryFunction for_each_m(ExtIterator begin, ExtIterator end,
               >;
 
     begin.flush();     // flush container
+    begin.parent_vector()->unshare(begin, end);
 
     if (nbuffers == 0)
         nbuffers = 2 * foxxll::config::get_instance()->disks_number();
@@ -222,6 +223,7 @@ void generate(ExtIterator begin, ExtIterator end,
     }
 
     begin.flush();     // flush container
+    begin.parent_vector()->unshare(begin, end);
 
     if (nbuffers == 0)
         nbuffers = 2 * foxxll::config::get_instance()->disks_number();
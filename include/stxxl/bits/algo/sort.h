@@ -702,6 +702,7 @@ void sort(ExtIterator first, ExtIterator last, StrictWeakOrderingWithMinMax cmp,
     foxxll::block_manager* mng = foxxll::block_manager::get_instance();
 
     first.flush();
+    first.parent_vector()->unshare(first, last);
 
     if ((last - first) * sizeof(value_type) * sort_memory_usage_factor() < M)
     {
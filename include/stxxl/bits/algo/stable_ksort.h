@@ -239,6 +239,7 @@ void stable_ksort(ExtIterator first, ExtIterator last, KeyExtract key_extract, s
     using request_ptr = foxxll::request_ptr;
 
     first.flush();     // flush container
+    first.parent_vector()->unshare(first, last);
 
     double begin = foxxll::timestamp();
 
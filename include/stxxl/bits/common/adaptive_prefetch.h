@@ -0,0 +1,228 @@
+/***************************************************************************
+ *  include/stxxl/bits/common/adaptive_prefetch.h
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#ifndef STXXL_COMMON_ADAPTIVE_PREFETCH_HEADER
+#define STXXL_COMMON_ADAPTIVE_PREFETCH_HEADER
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <mutex>
+
+#include <tlx/logger/core.hpp>
+
+#include <foxxll/common/timer.hpp>
+
+namespace stxxl {
+
+/*!
+ * Number of prefetch blocks shared by the adaptive_prefetch controllers of
+ * several containers, usually the prefetch blocks of a shared
+ * read_write_pool. Controllers acquire blocks when their container stalls and
+ * return them when prefetching is not needed anymore. The budget must outlive
+ * all controllers using it.
+ */
+class prefetch_budget
+{
+    //! protects m_used
+    std::mutex m_mutex;
+    //! total number of blocks
+    size_t m_total;
+    //! number of blocks acquired by controllers
+    size_t m_used;
+
+public:
+    //! Constructs a budget of total blocks.
+    explicit prefetch_budget(size_t total)
+        : m_total(total), m_used(0)
+    { }
+
+    //! Constructs a budget of all prefetch blocks of a read_write_pool.
+    template <typename PoolType>
+    explicit prefetch_budget(const PoolType& pool)
+        : m_total(pool.size_prefetch()), m_used(0)
+    { }
+
+    //! non-copyable: delete copy-constructor
+    prefetch_budget(const prefetch_budget&) = delete;
+    //! non-copyable: delete assignment operator
+    prefetch_budget& operator = (const prefetch_budget&) = delete;
+
+    //! Acquire up to n blocks, returns the number of blocks granted.
+    size_t acquire(size_t n)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        n = std::min(n, m_total - m_used);
+        m_used += n;
+        return n;
+    }
+
+    //! Return n previously acquired blocks.
+    void release(size_t n)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        assert(n <= m_used);
+        m_used -= n;
+    }
+
+    //! Total number of blocks.
+    size_t total() const { return m_total; }
+
+    //! Number of blocks currently acquired by controllers.
+    size_t used()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_used;
+    }
+};
+
+/*!
+ * Controller of the prefetch depth of a single container.
+ *
+ * The container reports each block it reads when it is consumed, and whether
+ * the read stalled, i.e. the block had not arrived yet. The controller keeps
+ * an average of the time between two consumed blocks and of the stall time,
+ * and evaluates them every window of reads: if reads stalled, the depth grows
+ * by the number of blocks consumed in the average stall time, as far as the
+ * budget allows. After several windows without stalls the depth shrinks by
+ * one block and returns it to the budget.
+ */
+class adaptive_prefetch
+{
+    static constexpr bool debug = false;
+
+    //! number of block reads between two adjustments
+    static constexpr size_t window = 8;
+    //! number of windows without stalls before shrinking
+    static constexpr size_t shrink_windows = 4;
+
+    //! shared budget or nullptr
+    prefetch_budget* m_budget;
+    //! maximum depth if there is no budget
+    size_t m_limit;
+    //! current depth, acquired from m_budget
+    size_t m_depth;
+
+    //! block reads and stalls in the current window
+    size_t m_reads, m_stalls;
+    //! number of consecutive windows without stalls
+    size_t m_quiet;
+
+    //! time of the last read
+    double m_last_read;
+    //! averages of time between reads and of stall time
+    double m_interval, m_stall_time;
+
+public:
+    //! Constructs a controller taking its depth from a shared budget.
+    explicit adaptive_prefetch(prefetch_budget& budget, size_t initial_depth = 1)
+        : m_budget(&budget), m_limit(budget.total()),
+          m_depth(budget.acquire(initial_depth)),
+          m_reads(0), m_stalls(0), m_quiet(0),
+          m_last_read(0), m_interval(0), m_stall_time(0)
+    { }
+
+    //! Constructs a controller with a private limit, e.g. the number of
+    //! prefetch blocks of a pool not shared with other containers.
+    explicit adaptive_prefetch(size_t limit, size_t initial_depth = 1)
+        : m_budget(nullptr), m_limit(limit),
+          m_depth(std::min(initial_depth, limit)),
+          m_reads(0), m_stalls(0), m_quiet(0),
+          m_last_read(0), m_interval(0), m_stall_time(0)
+    { }
+
+    //! non-copyable: delete copy-constructor
+    adaptive_prefetch(const adaptive_prefetch&) = delete;
+    //! non-copyable: delete assignment operator
+    adaptive_prefetch& operator = (const adaptive_prefetch&) = delete;
+
+    ~adaptive_prefetch()
+    {
+        if (m_budget)
+            m_budget->release(m_depth);
+    }
+
+    //! Current prefetch depth in blocks.
+    size_t depth() const
+    {
+        return m_depth;
+    }
+
+    //! Report a consumed block read. Returns true if the depth changed.
+    //! \param stalled whether the read had not completed when needed
+    //! \param stall_time seconds waited for the read
+    bool on_read(bool stalled, double stall_time)
+    {
+        const double now = foxxll::timestamp();
+        if (m_last_read != 0)
+            m_interval = average(m_interval, std::max(now - m_last_read - stall_time, 0.0));
+        m_last_read = now;
+
+        ++m_reads;
+        if (stalled) {
+            ++m_stalls;
+            m_stall_time = average(m_stall_time, stall_time);
+        }
+
+        if (m_reads < window)
+            return false;
+
+        const size_t old_depth = m_depth;
+
+        if (m_stalls > 0)
+        {
+            // blocks consumed while waiting for one read
+            const double blocks = (m_interval > 0)
+                                  ? std::ceil(m_stall_time / m_interval) : 1.0;
+            const size_t want = static_cast<size_t>(
+                std::min<double>(std::max(blocks, 1.0), static_cast<double>(m_limit)));
+            grow(want);
+            m_quiet = 0;
+        }
+        else if (++m_quiet >= shrink_windows && m_depth > 0)
+        {
+            shrink(1);
+            m_quiet = 0;
+        }
+
+        TLX_LOG << "adaptive_prefetch[" << this << "]: " << m_stalls << " of "
+                << m_reads << " reads stalled, depth " << old_depth << " -> " << m_depth;
+
+        m_reads = m_stalls = 0;
+        return m_depth != old_depth;
+    }
+
+private:
+    //! exponentially weighted moving average
+    static double average(double avg, double value)
+    {
+        return (avg == 0) ? value : 0.75 * avg + 0.25 * value;
+    }
+
+    void grow(size_t n)
+    {
+        n = std::min(n, m_limit - m_depth);
+        if (m_budget)
+            n = m_budget->acquire(n);
+        m_depth += n;
+    }
+
+    void shrink(size_t n)
+    {
+        n = std::min(n, m_depth);
+        if (m_budget)
+            m_budget->release(n);
+        m_depth -= n;
+    }
+};
+
+} // namespace stxxl
+
+#endif // !STXXL_COMMON_ADAPTIVE_PREFETCH_HEADER
@@ -0,0 +1,340 @@
+/***************************************************************************
+ *  include/stxxl/bits/common/manifest.h
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#ifndef STXXL_COMMON_MANIFEST_HEADER
+#define STXXL_COMMON_MANIFEST_HEADER
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <tlx/counting_ptr.hpp>
+#include <tlx/logger/core.hpp>
+#include <tlx/simple_vector.hpp>
+
+#include <foxxll/common/error_handling.hpp>
+#include <foxxll/io/request_operations.hpp>
+#include <foxxll/io/syscall_file.hpp>
+#include <foxxll/mng/block_manager.hpp>
+#include <foxxll/mng/config.hpp>
+
+#include <stxxl/types>
+
+namespace stxxl {
+
+/*!
+ * Description of a container saved to a data file, such that another process
+ * can reopen the container without re-streaming its elements.
+ *
+ * A container's save() writes its blocks into the data file and records
+ * their offsets and the container's metadata in the manifest, which is then
+ * stored with write(). The next process loads the manifest with read() and
+ * passes it to the open() method of an empty container of the same type. The
+ * reopened container reads the blocks in place from the data file, which must
+ * not be changed or removed while the container exists.
+ *
+ * \code
+ * stxxl::manifest m("stage1.dat");
+ * queue.save(m);
+ * m.write("stage1.manifest");
+ * // in the next process
+ * stxxl::manifest m;
+ * m.read("stage1.manifest");
+ * queue.open(m);
+ * \endcode
+ */
+class manifest
+{
+    static constexpr bool debug = false;
+
+    //! magic first word of a manifest file
+    static constexpr const char* magic = "stxxl-manifest";
+
+    //! format version
+    static constexpr unsigned version = 1;
+
+    //! path of the data file
+    std::string m_data_path;
+
+    //! type of the saved container
+    std::string m_kind;
+
+    //! raw size of the blocks in the data file
+    size_t m_block_size;
+
+    //! container metadata
+    std::map<std::string, external_size_type> m_meta;
+
+    //! offsets of the blocks in the data file
+    std::vector<external_size_type> m_offsets;
+
+    //! data file while saving or opening
+    foxxll::file_ptr m_file;
+
+public:
+    //! Constructs an empty manifest whose blocks will be stored in the file
+    //! data_path.
+    explicit manifest(const std::string& data_path = std::string())
+        : m_data_path(data_path), m_block_size(0)
+    { }
+
+    //! \name Manifest Files
+    //! \{
+
+    //! Store the manifest in a text file.
+    void write(const std::string& path) const
+    {
+        std::ofstream out(path.c_str());
+        out << magic << ' ' << version << '\n'
+            << "data " << m_data_path << '\n'
+            << "kind " << m_kind << '\n'
+            << "block_size " << m_block_size << '\n';
+        for (const auto& m : m_meta)
+            out << "meta " << m.first << ' ' << m.second << '\n';
+        out << "blocks " << m_offsets.size() << '\n';
+        for (const external_size_type& o : m_offsets)
+            out << o << '\n';
+        if (!out.good())
+            throw foxxll::io_error("stxxl::manifest: error writing " + path);
+    }
+
+    //! Load a manifest stored by write().
+    void read(const std::string& path)
+    {
+        std::ifstream in(path.c_str());
+        std::string word;
+        unsigned ver = 0;
+        if (!(in >> word >> ver) || word != magic || ver != version)
+            throw foxxll::io_error("stxxl::manifest: " + path + " is not a manifest");
+
+        m_meta.clear();
+        m_offsets.clear();
+        m_file = foxxll::file_ptr();
+
+        bool complete = false;
+        while (!complete && in >> word)
+        {
+            if (word == "data") {
+                in >> std::ws;
+                std::getline(in, m_data_path);
+            }
+            else if (word == "kind") {
+                in >> m_kind;
+            }
+            else if (word == "block_size") {
+                in >> m_block_size;
+            }
+            else if (word == "meta") {
+                std::string key;
+                external_size_type value;
+                in >> key >> value;
+                m_meta[key] = value;
+            }
+            else if (word == "blocks") {
+                size_t blocks = 0;
+                in >> blocks;
+                m_offsets.resize(blocks);
+                for (size_t i = 0; i < blocks; ++i)
+                    in >> m_offsets[i];
+                complete = !in.fail();
+            }
+        }
+        if (!complete)
+            throw foxxll::io_error("stxxl::manifest: error reading " + path);
+    }
+
+    //! \}
+
+    //! \name Accessors
+    //! \{
+
+    //! Path of the data file.
+    const std::string & data_path() const { return m_data_path; }
+
+    //! Type of the saved container.
+    const std::string & kind() const { return m_kind; }
+
+    //! Number of blocks in the data file.
+    size_t num_blocks() const { return m_offsets.size(); }
+
+    //! Set a metadata entry.
+    void set(const std::string& key, external_size_type value)
+    {
+        m_meta[key] = value;
+    }
+
+    //! Get a metadata entry, throws if it does not exist.
+    external_size_type get(const std::string& key) const
+    {
+        auto it = m_meta.find(key);
+        if (it == m_meta.end())
+            throw foxxll::bad_parameter("stxxl::manifest: missing entry " + key);
+        return it->second;
+    }
+
+    //! \}
+
+    //! \name Saving Containers
+    //! \{
+
+    //! Begin saving a container: truncate the data file and clear the
+    //! metadata and blocks.
+    void start_save(const std::string& kind, size_t block_size)
+    {
+        if (m_data_path.empty())
+            throw foxxll::bad_parameter("stxxl::manifest: no data file given");
+
+        m_kind = kind;
+        m_block_size = block_size;
+        m_meta.clear();
+        m_offsets.clear();
+        m_file = tlx::make_counting<foxxll::syscall_file>(
+            m_data_path, foxxll::file::RDWR | foxxll::file::CREAT | foxxll::file::TRUNC);
+    }
+
+    //! Append a block from internal memory to the data file.
+    template <typename BlockType>
+    void append(BlockType& block)
+    {
+        assert(m_file && BlockType::raw_size == m_block_size);
+        typename BlockType::bid_type bid = next_bid<typename BlockType::bid_type>();
+        block.write(bid)->wait();
+    }
+
+    //! Append copies of the external blocks [begin,end) to the data file. The
+    //! blocks are copied in batches of 2 * D blocks, reading the next batch
+    //! while the last one is written.
+    template <typename BlockType, typename BidIterator>
+    void append(BidIterator begin, BidIterator end)
+    {
+        assert(m_file && BlockType::raw_size == m_block_size);
+
+        const size_t batch = 2 * foxxll::config::get_instance()->disks_number();
+        tlx::simple_vector<BlockType> buffers(2 * batch);
+        tlx::simple_vector<foxxll::request_ptr> reqs(2 * batch);
+
+        for (size_t round = 0; begin != end; ++round)
+        {
+            BlockType* blocks = &buffers[(round % 2) * batch];
+            foxxll::request_ptr* r = &reqs[(round % 2) * batch];
+
+            // wait for the writes of this buffer set from two rounds ago
+            for (size_t i = 0; i < batch; ++i)
+                if (r[i].valid()) r[i]->wait();
+
+            size_t n = 0;
+            for ( ; n < batch && begin != end; ++n, ++begin)
+                r[n] = blocks[n].read(*begin);
+
+            for (size_t i = 0; i < n; ++i) {
+                r[i]->wait();
+                r[i] = blocks[i].write(next_bid<typename BlockType::bid_type>());
+            }
+            for (size_t i = n; i < batch; ++i)
+                r[i] = foxxll::request_ptr();
+        }
+
+        for (foxxll::request_ptr& r : reqs)
+            if (r.valid()) r->wait();
+    }
+
+    //! Finish saving a container and close the data file.
+    void finish_save()
+    {
+        m_file = foxxll::file_ptr();
+        TLX_LOG << "manifest: saved " << m_kind << " with " << m_offsets.size()
+                << " blocks to " << m_data_path;
+    }
+
+    //! \}
+
+    //! \name Opening Containers
+    //! \{
+
+    //! Begin opening a container: check its type and block size and open the
+    //! data file, which the container keeps referencing.
+    foxxll::file_ptr start_open(const std::string& kind, size_t block_size)
+    {
+        if (kind != m_kind || block_size != m_block_size)
+            throw foxxll::bad_parameter(
+                "stxxl::manifest: " + m_data_path + " does not contain a " + kind +
+                " with this block size");
+
+        m_file = tlx::make_counting<foxxll::syscall_file>(
+            m_data_path, foxxll::file::RDONLY);
+        return m_file;
+    }
+
+    //! Get the BID of block i in the data file opened by start_open().
+    template <typename BidType>
+    BidType bid(size_t i) const
+    {
+        assert(m_file && i < m_offsets.size());
+        BidType b;
+        b.storage = m_file.get();
+        b.offset = m_offsets[i];
+        return b;
+    }
+
+    //! Read block i of the data file into internal memory.
+    template <typename BlockType>
+    void read_block(size_t i, BlockType& block) const
+    {
+        block.read(bid<typename BlockType::bid_type>(i))->wait();
+    }
+
+    //! Finish opening a container.
+    void finish_open()
+    {
+        m_file = foxxll::file_ptr();
+    }
+
+    //! \}
+
+private:
+    //! allocate the next block at the end of the data file
+    template <typename BidType>
+    BidType next_bid()
+    {
+        const external_size_type offset =
+            external_size_type(m_offsets.size()) * m_block_size;
+        m_file->set_size(offset + m_block_size);
+        m_offsets.push_back(offset);
+
+        BidType b;
+        b.storage = m_file.get();
+        b.offset = offset;
+        return b;
+    }
+};
+
+//! Delete the blocks in [begin,end) via the block manager, except those
+//! stored in the data file of a reopened container.
+template <typename BidIterator>
+void delete_blocks_except(const foxxll::file_ptr& file, BidIterator begin, BidIterator end)
+{
+    foxxll::block_manager* bm = foxxll::block_manager::get_instance();
+    if (!file) {
+        bm->delete_blocks(begin, end);
+        return;
+    }
+    for ( ; begin != end; ++begin) {
+        if ((*begin).storage != file.get())
+            bm->delete_block(*begin);
+    }
+}
+
+} // namespace stxxl
+
+#endif // !STXXL_COMMON_MANIFEST_HEADER
@@ -0,0 +1,61 @@
+/***************************************************************************
+ *  include/stxxl/bits/common/span.h
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#ifndef STXXL_COMMON_SPAN_HEADER
+#define STXXL_COMMON_SPAN_HEADER
+
+#include <cassert>
+#include <cstddef>
+
+namespace stxxl {
+
+/*!
+ * A contiguous range of elements inside a container, e.g. the rest of the
+ * current block returned by queue::front_span() or normal_stack::top_span().
+ * The span does not own the elements and is invalidated by the next
+ * modification of the container.
+ */
+template <typename ValueType>
+class span
+{
+public:
+    using value_type = ValueType;
+    using iterator = ValueType *;
+
+    span() : m_data(nullptr), m_size(0) { }
+
+    span(ValueType* data, size_t size) : m_data(data), m_size(size) { }
+
+    //! Pointer to the first element.
+    ValueType * data() const { return m_data; }
+
+    //! Number of elements.
+    size_t size() const { return m_size; }
+
+    //! Returns true if there are no elements.
+    bool empty() const { return m_size == 0; }
+
+    iterator begin() const { return m_data; }
+    iterator end() const { return m_data + m_size; }
+
+    ValueType& operator [] (size_t i) const
+    {
+        assert(i < m_size);
+        return m_data[i];
+    }
+
+private:
+    ValueType* m_data;
+    size_t m_size;
+};
+
+} // namespace stxxl
+
+#endif // !STXXL_COMMON_SPAN_HEADER
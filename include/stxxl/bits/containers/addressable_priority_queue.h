@@ -0,0 +1,271 @@
+/***************************************************************************
+ *  include/stxxl/bits/containers/addressable_priority_queue.h
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#ifndef STXXL_CONTAINERS_ADDRESSABLE_PRIORITY_QUEUE_HEADER
+#define STXXL_CONTAINERS_ADDRESSABLE_PRIORITY_QUEUE_HEADER
+
+#include <cassert>
+#include <cstdint>
+
+#include <tlx/logger/core.hpp>
+
+#include <stxxl/bits/containers/priority_queue.h>
+#include <stxxl/bits/containers/vector.h>
+#include <stxxl/types>
+
+namespace stxxl {
+
+//! \addtogroup stlcont
+//! \{
+
+/*!
+ * External priority queue whose items can be addressed by handles, which
+ * supports decrease_key() and erase() in addition to push, top and pop.
+ *
+ * The queue is a stxxl::priority_queue of entries (key, handle, version) and
+ * uses lazy deletion: each handle has a current version in a compact external
+ * index of four bytes per handle. decrease_key() bumps the version and pushes
+ * a new entry, erase() marks the handle as deleted. Entries whose version is
+ * not current anymore are stale and dropped when they surface at the top of
+ * the sequence heap, so no entry is ever searched for.
+ *
+ * Handles are assigned consecutively by push(), e.g. a graph search can push
+ * all nodes in order and use node ids as handles.
+ *
+ * \code
+ * stxxl::addressable_priority_queue<int, stxxl::comparator<int>, 16*1024*1024, 1024*1024> q;
+ * auto h = q.push(42);
+ * q.decrease_key(h, 7);
+ * \endcode
+ *
+ * \tparam KeyType type of the keys (POD with no references to internal memory)
+ * \tparam CompareTypeWithMin comparator with min_value(), as for PRIORITY_QUEUE_GENERATOR
+ * \tparam IntMemory internal memory of the priority queue in bytes, see PRIORITY_QUEUE_GENERATOR
+ * \tparam MaxItems maximum number of entries, including stale ones, see PRIORITY_QUEUE_GENERATOR
+ */
+template <class KeyType,
+          class CompareTypeWithMin,
+          size_t IntMemory,
+          external_size_type MaxItems>
+class addressable_priority_queue
+{
+    static constexpr bool debug = false;
+
+public:
+    using key_type = KeyType;
+    using comparator_type = CompareTypeWithMin;
+    using size_type = external_size_type;
+    using handle_type = uint64_t;
+
+private:
+    using version_type = uint32_t;
+
+    //! version bit of handles which are not in the queue anymore
+    static constexpr version_type deleted = version_type(1) << 31;
+
+    //! an entry of the sequence heap, valid while its version is current
+    struct entry
+    {
+        key_type key;
+        handle_type handle;
+        version_type version;
+    };
+
+    //! compares entries by their keys
+    struct entry_cmp
+    {
+        comparator_type cmp;
+
+        explicit entry_cmp(const comparator_type& c = comparator_type()) : cmp(c) { }
+
+        bool operator () (const entry& a, const entry& b) const
+        {
+            return cmp(a.key, b.key);
+        }
+
+        entry min_value() const
+        {
+            return entry { cmp.min_value(), 0, 0 };
+        }
+    };
+
+public:
+    using pq_type = typename PRIORITY_QUEUE_GENERATOR<
+              entry, entry_cmp, IntMemory, MaxItems>::result;
+    using pool_type = typename pq_type::pool_type;
+    using version_vector_type = stxxl::vector<version_type>;
+
+private:
+    //! sequence heap of current and stale entries
+    pq_type m_pq;
+
+    //! current version of each handle, with the deleted bit if the handle is
+    //! not in the queue
+    version_vector_type m_versions;
+
+    //! number of handles in the queue
+    size_type m_size;
+
+    //! current version of handle h, read through a const reference such
+    //! that the vector's page is not marked dirty
+    version_type version(handle_type h) const
+    {
+        return static_cast<const version_vector_type&>(m_versions)[h];
+    }
+
+    //! drop stale entries from the top of m_pq
+    void drop_stale()
+    {
+        while (!m_pq.empty())
+        {
+            const entry& e = m_pq.top();
+            if (version(e.handle) == e.version)
+                return;
+            TLX_LOG << "addressable_priority_queue: drop stale entry of " << e.handle;
+            m_pq.pop();
+        }
+    }
+
+public:
+    //! \name Constructors/Destructors
+    //! \{
+
+    //! Constructs an empty queue using the given pool for the sequence heap.
+    explicit addressable_priority_queue(
+        pool_type& pool, const comparator_type& cmp = comparator_type())
+        : m_pq(pool, entry_cmp(cmp)), m_size(0)
+    { }
+
+    //! Constructs an empty queue whose sequence heap has its own pools of the
+    //! given sizes in bytes.
+    addressable_priority_queue(
+        const size_t p_pool_mem, const size_t w_pool_mem,
+        const comparator_type& cmp = comparator_type())
+        : m_pq(p_pool_mem, w_pool_mem, entry_cmp(cmp)), m_size(0)
+    { }
+
+    //! non-copyable: delete copy-constructor
+    addressable_priority_queue(const addressable_priority_queue&) = delete;
+    //! non-copyable: delete assignment operator
+    addressable_priority_queue& operator = (const addressable_priority_queue&) = delete;
+
+    //! \}
+
+    //! \name Capacity
+    //! \{
+
+    //! Returns the number of items in the queue.
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    //! Returns true if the queue has no items.
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    //! Returns the number of stale entries not dropped yet.
+    size_type stale() const
+    {
+        return m_pq.size() - m_size;
+    }
+
+    //! Returns the number of handles assigned so far.
+    size_type num_handles() const
+    {
+        return m_versions.size();
+    }
+
+    //! Returns true if the item of handle h is in the queue, i.e. it was
+    //! neither popped nor erased.
+    bool contains(handle_type h) const
+    {
+        return h < m_versions.size() && !(version(h) & deleted);
+    }
+
+    //! \}
+
+    //! \name Operators
+    //! \{
+
+    //! Returns the key of the "largest" item. Precondition: \c empty() is
+    //! false.
+    const key_type & top()
+    {
+        assert(!empty());
+        drop_stale();
+        return m_pq.top().key;
+    }
+
+    //! Returns the handle of the "largest" item. Precondition: \c empty() is
+    //! false.
+    handle_type top_handle()
+    {
+        assert(!empty());
+        drop_stale();
+        return m_pq.top().handle;
+    }
+
+    //! \}
+
+    //! \name Modifiers
+    //! \{
+
+    //! Inserts an item with the given key and returns its handle.
+    handle_type push(const key_type& key)
+    {
+        const handle_type h = m_versions.size();
+        m_versions.push_back(0);
+        m_pq.push(entry { key, h, 0 });
+        ++m_size;
+        return h;
+    }
+
+    //! Removes the "largest" item. Precondition: \c empty() is false.
+    void pop()
+    {
+        assert(!empty());
+        drop_stale();
+        const entry& e = m_pq.top();
+        m_versions[e.handle] = (e.version + 1) | deleted;
+        m_pq.pop();
+        --m_size;
+    }
+
+    //! Changes the key of the item h, which must be in the queue. The new
+    //! key is usually "larger" than the old one, but any key is allowed: the
+    //! old entry becomes stale in either case.
+    void decrease_key(handle_type h, const key_type& new_key)
+    {
+        assert(contains(h));
+        const version_type v = (version(h) + 1) & ~deleted;
+        m_versions[h] = v;
+        m_pq.push(entry { new_key, h, v });
+    }
+
+    //! Removes the item h, which must be in the queue. Its entry becomes
+    //! stale and is dropped when it reaches the top.
+    void erase(handle_type h)
+    {
+        assert(contains(h));
+        m_versions[h] = (version(h) + 1) | deleted;
+        --m_size;
+    }
+
+    //! \}
+};
+
+//! \}
+
+} // namespace stxxl
+
+#endif // !STXXL_CONTAINERS_ADDRESSABLE_PRIORITY_QUEUE_HEADER
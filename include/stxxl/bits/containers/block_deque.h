@@ -0,0 +1,567 @@
+/***************************************************************************
+ *  include/stxxl/bits/containers/block_deque.h
+ *
+ *  based on include/stxxl/bits/containers/sequence.h
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#ifndef STXXL_CONTAINERS_BLOCK_DEQUE_HEADER
+#define STXXL_CONTAINERS_BLOCK_DEQUE_HEADER
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <utility>
+
+#include <tlx/define.hpp>
+#include <tlx/logger/core.hpp>
+
+#include <foxxll/mng/block_manager.hpp>
+#include <foxxll/mng/config.hpp>
+#include <foxxll/mng/read_write_pool.hpp>
+#include <foxxll/mng/typed_block.hpp>
+
+#include <stxxl/bits/defines.h>
+#include <stxxl/types>
+
+namespace stxxl {
+
+//! \addtogroup stlcont
+//! \{
+
+/**
+ * External deque built from a sequence of blocks, like stxxl::sequence, but
+ * with random access.
+ *
+ * In contrast to stxxl::deque, which wraps around a stxxl::vector and hence
+ * accesses the vector's pages at both ends, block_deque keeps the blocks at
+ * its ends in internal memory and the blocks in between in external memory.
+ * Blocks which leave an end are written asynchronously through a
+ * read_write_pool, blocks which come back to an end are read with prefetch
+ * hints for the following blocks. The deque grows by adding blocks at either
+ * end, elements are never copied.
+ *
+ * Each end keeps up to end_blocks blocks in internal memory, hence pushes and
+ * pops which alternate around a block boundary cause no I/O. Random access to
+ * blocks between the ends goes through a cache of one block.
+ *
+ * \tparam ValueType type of the contained objects (POD with no references to internal memory)
+ * \tparam BlockSize size of the external memory block in bytes, default is \c STXXL_DEFAULT_BLOCK_SIZE(ValTp)
+ * \tparam AllocStr parallel disk block allocation strategy, default is \c foxxll::default_alloc_strategy
+ * \tparam SizeType size data type, default is \c external_size_type
+ */
+template <class ValueType,
+          size_t BlockSize = STXXL_DEFAULT_BLOCK_SIZE(ValueType),
+          class AllocStr = foxxll::default_alloc_strategy,
+          class SizeType = external_size_type>
+class block_deque
+{
+    static constexpr bool debug = false;
+
+public:
+    using value_type = ValueType;
+    using alloc_strategy_type = AllocStr;
+    using size_type = SizeType;
+    using reference = value_type &;
+    using const_reference = const value_type &;
+    enum {
+        block_size = BlockSize
+    };
+
+    using block_type = foxxll::typed_block<block_size, value_type>;
+    using bid_type = foxxll::BID<block_size>;
+    using pool_type = foxxll::read_write_pool<block_type>;
+
+    //! number of blocks kept in internal memory at each end
+    static constexpr size_t end_blocks = 2;
+
+private:
+    //! a block of the deque, either in internal memory or on disk
+    struct slot_type
+    {
+        block_type* block;
+        bid_type bid;
+    };
+
+    using slot_deque_type = std::deque<slot_type>;
+
+    /// current number of items in the deque
+    size_type m_size;
+
+    /// position of the front element in the first block
+    size_t m_offset;
+
+    /// blocks of the deque, covering the elements
+    slot_deque_type m_slots;
+
+    /// number of the first block, decremented when adding blocks at the front
+    size_type m_first_no;
+
+    /// whether the m_pool object is own and should be deleted.
+    bool m_owns_pool;
+
+    /// read_write_pool of blocks
+    pool_type* m_pool;
+
+    /// cached copy of an external block for random access
+    mutable block_type* m_cache;
+
+    /// number of the cached block
+    mutable size_type m_cache_no;
+
+    /// whether the cached block was modified
+    mutable bool m_cache_dirty;
+
+    /// block allocation strategy
+    alloc_strategy_type m_alloc_strategy;
+
+    /// block allocation counter
+    size_t m_alloc_count;
+
+    /// block manager used
+    foxxll::block_manager* m_bm;
+
+    /// number of blocks to prefetch
+    size_t m_blocks2prefetch;
+
+public:
+    //! \name Constructors/Destructors
+    //! \{
+
+    //! Constructs empty deque with own write and prefetch block pool
+    //!
+    //! \param D  number of parallel disks, defaulting to the configured number of scratch disks,
+    //!           memory consumption will be 2 * D + 2 * end_blocks + 1 blocks
+    explicit block_deque(const int D = -1)
+        : m_owns_pool(true),
+          m_alloc_count(0),
+          m_bm(foxxll::block_manager::get_instance())
+    {
+        const size_t disks = (D < 1)
+                             ? foxxll::config::get_instance()->disks_number()
+                             : static_cast<size_t>(D);
+
+        TLX_LOG << "block_deque[" << this << "]::block_deque(D)";
+        m_pool = new pool_type(disks, disks + 2 * end_blocks + 1);
+        init();
+    }
+
+    //! Constructs empty deque with own write and prefetch block pool
+    //!
+    //! \param w_pool_size  number of blocks in the write pool, at least 2 * end_blocks + 2
+    //! \param p_pool_size  number of blocks in the prefetch pool, recommended at least 1
+    //! \param blocks2prefetch  defines the number of blocks to prefetch at each end,
+    //!                          default is number of block in the prefetch pool
+    block_deque(const size_t w_pool_size, const size_t p_pool_size, int blocks2prefetch = -1)
+        : m_owns_pool(true),
+          m_alloc_count(0),
+          m_bm(foxxll::block_manager::get_instance())
+    {
+        TLX_LOG << "block_deque[" << this << "]::block_deque(sizes)";
+        m_pool = new pool_type(p_pool_size, w_pool_size);
+        init(blocks2prefetch);
+    }
+
+    //! Constructs empty deque
+    //!
+    //! \param pool block write/prefetch pool
+    //! \param blocks2prefetch  defines the number of blocks to prefetch at each end,
+    //!                          default is number of blocks in the prefetch pool
+    //!  \warning Number of blocks in the write pool must be at least 2 * end_blocks + 2
+    explicit block_deque(pool_type& pool, int blocks2prefetch = -1)
+        : m_owns_pool(false),
+          m_pool(&pool),
+          m_alloc_count(0),
+          m_bm(foxxll::block_manager::get_instance())
+    {
+        TLX_LOG << "block_deque[" << this << "]::block_deque(pool)";
+        init(blocks2prefetch);
+    }
+
+    //! non-copyable: delete copy-constructor
+    block_deque(const block_deque&) = delete;
+    //! non-copyable: delete assignment operator
+    block_deque& operator = (const block_deque&) = delete;
+
+    ~block_deque()
+    {
+        release();
+
+        if (m_owns_pool)
+            delete m_pool;
+    }
+
+    //! \}
+
+private:
+    void init(int blocks2prefetch = -1)
+    {
+        // the ends and the cache hold blocks stolen from the write pool
+        const size_t min_write = 2 * end_blocks + 2;
+        if (m_pool->size_write() < min_write) {
+            TLX_LOG1 << "block_deque: invalid configuration, not enough blocks (" << m_pool->size_write() <<
+                ") in write pool, at least " << min_write << " are needed, resizing";
+            m_pool->resize_write(min_write);
+        }
+
+        if (m_pool->size_prefetch() < 1) {
+            TLX_LOG1 << "block_deque: inefficient configuration, no blocks for prefetching available";
+        }
+
+        m_cache = nullptr;
+        m_cache_dirty = false;
+        reset();
+        set_prefetch_aggr(blocks2prefetch);
+    }
+
+    //! initialize an empty deque with one block
+    void reset()
+    {
+        m_size = 0;
+        m_offset = 0;
+        m_first_no = 0;
+        m_slots.push_back(slot_type { m_pool->steal(), bid_type() });
+    }
+
+    //! give all blocks back to the pool and free the external ones
+    void release()
+    {
+        // the cached block is discarded along with its external block
+        if (m_cache) {
+            m_pool->add(m_cache);
+            m_cache = nullptr;
+            m_cache_dirty = false;
+        }
+
+        for (slot_type& s : m_slots) {
+            if (s.block)
+                m_pool->add(s.block);
+            else
+                m_bm->delete_block(s.bid);
+        }
+        m_slots.clear();
+    }
+
+    //! write back the cached block if it was modified
+    void release_cache() const
+    {
+        if (!m_cache) return;
+
+        if (m_cache_dirty)
+            m_pool->write(m_cache, m_slots[m_cache_no - m_first_no].bid);
+        else
+            m_pool->add(m_cache);
+
+        m_cache = nullptr;
+        m_cache_dirty = false;
+    }
+
+    //! write the block at index i to disk asynchronously, if it is in
+    //! internal memory
+    void evict(size_t i)
+    {
+        slot_type& s = m_slots[i];
+        if (!s.block) return;
+
+        m_bm->new_block(m_alloc_strategy, s.bid, m_alloc_count++);
+        TLX_LOG << "block_deque[" << this << "]: evict block " << i << " @ " << s.bid;
+        m_pool->write(s.block, s.bid);
+        s.block = nullptr;
+    }
+
+    //! read the block at index i into internal memory, if it is on disk, and
+    //! give prefetch hints on the external blocks in direction dir
+    void load(size_t i, int dir)
+    {
+        slot_type& s = m_slots[i];
+        if (s.block) return;
+
+        // the cached copy is the newest content of the block, take it over
+        if (m_cache && m_cache_no == m_first_no + i)
+        {
+            TLX_LOG << "block_deque[" << this << "]: load block " << i << " from cache";
+            s.block = m_cache;
+            m_cache = nullptr;
+            m_cache_dirty = false;
+            m_bm->delete_block(s.bid);
+            s.bid = bid_type();
+            return;
+        }
+
+        s.block = m_pool->steal();
+        foxxll::request_ptr req = m_pool->read(s.block, s.bid);
+        TLX_LOG << "block_deque[" << this << "]: load block " << i << " @ " << s.bid;
+
+        // give prefetching hints, except on the cached block which may be
+        // newer than the block on disk
+        size_t h = i + dir;
+        for (size_t k = 0; k < m_blocks2prefetch && h < m_slots.size() && !m_slots[h].block;
+             ++k, h += dir)
+        {
+            if (!m_cache || m_cache_no != m_first_no + h)
+                m_pool->hint(m_slots[h].bid);
+        }
+
+        req->wait();
+        m_bm->delete_block(s.bid);
+        s.bid = bid_type();
+    }
+
+    //! element at position pos of the blocks, reading external blocks into
+    //! the cache. Writes must mark the cached block dirty.
+    value_type& element(size_type pos) const
+    {
+        const size_t i = static_cast<size_t>(pos / block_type::size);
+        const size_t offset = static_cast<size_t>(pos % block_type::size);
+        const slot_type& s = m_slots[i];
+
+        if (TLX_LIKELY(s.block != nullptr))
+            return (*s.block)[offset];
+
+        if (!m_cache || m_cache_no != m_first_no + i)
+        {
+            release_cache();
+            m_cache = m_pool->steal();
+            m_pool->read(m_cache, s.bid)->wait();
+            m_cache_no = m_first_no + i;
+        }
+
+        return (*m_cache)[offset];
+    }
+
+public:
+    //! \name Miscellaneous
+    //! \{
+
+    //! Defines the number of blocks to prefetch at each end.
+    //! This method should be called whenever the prefetch pool is resized
+    //! \param blocks2prefetch  defines the number of blocks to prefetch,
+    //!                         a negative value means to use the number of blocks in the prefetch pool
+    void set_prefetch_aggr(int blocks2prefetch)
+    {
+        if (blocks2prefetch < 0)
+            m_blocks2prefetch = m_pool->size_prefetch();
+        else
+            m_blocks2prefetch = blocks2prefetch;
+    }
+
+    //! Returns the number of blocks prefetched at each end
+    const size_t & get_prefetch_aggr() const
+    {
+        return m_blocks2prefetch;
+    }
+
+    //! \}
+
+    //! \name Modifiers
+    //! \{
+
+    //! Adds an element to the front of the deque
+    void push_front(const value_type& val)
+    {
+        if (TLX_UNLIKELY(m_offset == 0))
+        {
+            if (m_size != 0)
+            {
+                TLX_LOG << "block_deque::push_front new block";
+                m_slots.push_front(slot_type { m_pool->steal(), bid_type() });
+                --m_first_no;
+
+                // write the block which left the front end
+                if (2 * end_blocks < m_slots.size())
+                    evict(end_blocks);
+            }
+            m_offset = block_type::size;
+        }
+
+        --m_offset;
+        (*m_slots.front().block)[m_offset] = val;
+        ++m_size;
+    }
+
+    //! Adds an element to the end of the deque
+    void push_back(const value_type& val)
+    {
+        const size_type pos = m_offset + m_size;
+
+        if (TLX_UNLIKELY(pos == m_slots.size() * block_type::size))
+        {
+            TLX_LOG << "block_deque::push_back new block";
+            m_slots.push_back(slot_type { m_pool->steal(), bid_type() });
+
+            // write the block which left the back end
+            if (2 * end_blocks < m_slots.size())
+                evict(m_slots.size() - 1 - end_blocks);
+        }
+
+        (*m_slots.back().block)[pos % block_type::size] = val;
+        ++m_size;
+    }
+
+    //! Removes element from the front of the deque
+    void pop_front()
+    {
+        assert(!empty());
+
+        ++m_offset;
+        if (--m_size == 0)
+        {
+            assert(m_slots.size() == 1);
+            m_offset = 0;
+        }
+        else if (TLX_UNLIKELY(m_offset == block_type::size))
+        {
+            TLX_LOG << "block_deque::pop_front remove block";
+            m_pool->add(m_slots.front().block);
+            m_slots.pop_front();
+            ++m_first_no;
+            m_offset = 0;
+            load(0, +1);
+        }
+    }
+
+    //! Removes element from the back of the deque
+    void pop_back()
+    {
+        assert(!empty());
+
+        if (--m_size == 0)
+        {
+            assert(m_slots.size() == 1);
+            m_offset = 0;
+        }
+        else if (TLX_UNLIKELY(m_offset + m_size == (m_slots.size() - 1) * block_type::size))
+        {
+            TLX_LOG << "block_deque::pop_back remove block";
+            m_pool->add(m_slots.back().block);
+            m_slots.pop_back();
+            load(m_slots.size() - 1, -1);
+        }
+    }
+
+    //! Removes all elements and frees the external blocks
+    void clear()
+    {
+        release();
+        reset();
+    }
+
+    void swap(block_deque& obj)
+    {
+        std::swap(m_size, obj.m_size);
+        std::swap(m_offset, obj.m_offset);
+        std::swap(m_slots, obj.m_slots);
+        std::swap(m_first_no, obj.m_first_no);
+        std::swap(m_owns_pool, obj.m_owns_pool);
+        std::swap(m_pool, obj.m_pool);
+        std::swap(m_cache, obj.m_cache);
+        std::swap(m_cache_no, obj.m_cache_no);
+        std::swap(m_cache_dirty, obj.m_cache_dirty);
+        std::swap(m_alloc_strategy, obj.m_alloc_strategy);
+        std::swap(m_alloc_count, obj.m_alloc_count);
+        std::swap(m_bm, obj.m_bm);
+        std::swap(m_blocks2prefetch, obj.m_blocks2prefetch);
+    }
+
+    //! \}
+
+    //! \name Capacity
+    //! \{
+
+    //! Returns the size of the deque
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    //! Returns \c true if deque is empty
+    bool empty() const
+    {
+        return (m_size == 0);
+    }
+
+    //! Returns the number of blocks in external memory
+    size_t external_blocks() const
+    {
+        return static_cast<size_t>(std::count_if(
+                                       m_slots.begin(), m_slots.end(),
+                                       [](const slot_type& s) { return s.block == nullptr; }));
+    }
+
+    //! \}
+
+    //! \name Operators
+    //! \{
+
+    //! Returns a const reference to the n-th element. Elements between the
+    //! end blocks are accessed via a one block cache, the reference is valid
+    //! until the next operation on the deque. Use set() to modify elements,
+    //! such that only modified blocks are written back.
+    const_reference operator [] (size_type n) const
+    {
+        assert(n < size());
+        return element(m_offset + n);
+    }
+
+    //! Replaces the n-th element, see operator[].
+    void set(size_type n, const value_type& val)
+    {
+        assert(n < size());
+        const size_type pos = m_offset + n;
+        element(pos) = val;
+        if (!m_slots[static_cast<size_t>(pos / block_type::size)].block)
+            m_cache_dirty = true;
+    }
+
+    //! Returns a mutable reference at the front of the deque
+    reference front()
+    {
+        assert(!empty());
+        return (*m_slots.front().block)[m_offset];
+    }
+
+    //! Returns a const reference at the front of the deque
+    const_reference front() const
+    {
+        assert(!empty());
+        return (*m_slots.front().block)[m_offset];
+    }
+
+    //! Returns a mutable reference at the back of the deque
+    reference back()
+    {
+        assert(!empty());
+        return (*m_slots.back().block)[(m_offset + m_size - 1) % block_type::size];
+    }
+
+    //! Returns a const reference at the back of the deque
+    const_reference back() const
+    {
+        assert(!empty());
+        return (*m_slots.back().block)[(m_offset + m_size - 1) % block_type::size];
+    }
+
+    //! \}
+};
+
+//! \}
+
+} // namespace stxxl
+
+namespace std {
+
+template <class ValueType, size_t BlockSize, class AllocStr, class SizeType>
+void swap(stxxl::block_deque<ValueType, BlockSize, AllocStr, SizeType>& a,
+          stxxl::block_deque<ValueType, BlockSize, AllocStr, SizeType>& b)
+{
+    a.swap(b);
+}
+
+} // namespace std
+
+#endif // !STXXL_CONTAINERS_BLOCK_DEQUE_HEADER
@@ -35,7 +35,8 @@ template <class KeyType,
           class KeyCompareWithMaxType,
           unsigned RawNodeSize,
           unsigned RawLeafSize,
-          class PDAllocStrategy
+          class PDAllocStrategy,
+          class PagerType = stxxl::lru_pager<>
           >
 class btree
 {
@@ -47,9 +48,10 @@ public:
     using key_compare = KeyCompareWithMaxType;
 
     using self_type = btree<KeyType, DataType, KeyCompareWithMaxType,
-                            RawNodeSize, RawLeafSize, PDAllocStrategy>;
+                            RawNodeSize, RawLeafSize, PDAllocStrategy, PagerType>;
 
     using alloc_strategy_type = PDAllocStrategy;
+    using pager_type = PagerType;
 
     using size_type = external_size_type;
     using difference_type = external_diff_type;
@@ -1115,13 +1117,14 @@ template <class KeyType,
           class KeyCompareWithMaxType,
           unsigned LogNodeSize,
           unsigned LogLeafSize,
-          class PDAllocStrategy
+          class PDAllocStrategy,
+          class PagerType
           >
 inline bool operator ==
     (const btree<KeyType, DataType, KeyCompareWithMaxType,
-                 LogNodeSize, LogLeafSize, PDAllocStrategy>& a,
+                 LogNodeSize, LogLeafSize, PDAllocStrategy, PagerType>& a,
     const btree<KeyType, DataType, KeyCompareWithMaxType,
-                LogNodeSize, LogLeafSize, PDAllocStrategy>& b)
+                LogNodeSize, LogLeafSize, PDAllocStrategy, PagerType>& b)
 {
     return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
 }
@@ -1131,13 +1134,14 @@ template <class KeyType,
           class KeyCompareWithMaxType,
           unsigned LogNodeSize,
           unsigned LogLeafSize,
-          class PDAllocStrategy
+          class PDAllocStrategy,
+          class PagerType
           >
 inline bool operator !=
     (const btree<KeyType, DataType, KeyCompareWithMaxType,
-                 LogNodeSize, LogLeafSize, PDAllocStrategy>& a,
+                 LogNodeSize, LogLeafSize, PDAllocStrategy, PagerType>& a,
     const btree<KeyType, DataType, KeyCompareWithMaxType,
-                LogNodeSize, LogLeafSize, PDAllocStrategy>& b)
+                LogNodeSize, LogLeafSize, PDAllocStrategy, PagerType>& b)
 {
     return !(a == b);
 }
@@ -1147,13 +1151,14 @@ template <class KeyType,
           class KeyCompareWithMaxType,
           unsigned LogNodeSize,
           unsigned LogLeafSize,
-          class PDAllocStrategy
+          class PDAllocStrategy,
+          class PagerType
           >
 inline bool operator <
     (const btree<KeyType, DataType, KeyCompareWithMaxType,
-                 LogNodeSize, LogLeafSize, PDAllocStrategy>& a,
+                 LogNodeSize, LogLeafSize, PDAllocStrategy, PagerType>& a,
     const btree<KeyType, DataType, KeyCompareWithMaxType,
-                LogNodeSize, LogLeafSize, PDAllocStrategy>& b)
+                LogNodeSize, LogLeafSize, PDAllocStrategy, PagerType>& b)
 {
     return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
 }
@@ -1163,13 +1168,14 @@ template <class KeyType,
           class KeyCompareWithMaxType,
           unsigned LogNodeSize,
           unsigned LogLeafSize,
-          class PDAllocStrategy
+          class PDAllocStrategy,
+          class PagerType
           >
 inline bool operator >
     (const btree<KeyType, DataType, KeyCompareWithMaxType,
-                 LogNodeSize, LogLeafSize, PDAllocStrategy>& a,
+                 LogNodeSize, LogLeafSize, PDAllocStrategy, PagerType>& a,
     const btree<KeyType, DataType, KeyCompareWithMaxType,
-                LogNodeSize, LogLeafSize, PDAllocStrategy>& b)
+                LogNodeSize, LogLeafSize, PDAllocStrategy, PagerType>& b)
 {
     return b < a;
 }
@@ -1179,13 +1185,14 @@ template <class KeyType,
           class KeyCompareWithMaxType,
           unsigned LogNodeSize,
           unsigned LogLeafSize,
-          class PDAllocStrategy
+          class PDAllocStrategy,
+          class PagerType
           >
 inline bool operator <=
     (const btree<KeyType, DataType, KeyCompareWithMaxType,
-                 LogNodeSize, LogLeafSize, PDAllocStrategy>& a,
+                 LogNodeSize, LogLeafSize, PDAllocStrategy, PagerType>& a,
     const btree<KeyType, DataType, KeyCompareWithMaxType,
-                LogNodeSize, LogLeafSize, PDAllocStrategy>& b)
+                LogNodeSize, LogLeafSize, PDAllocStrategy, PagerType>& b)
 {
     return !(b < a);
 }
@@ -1195,13 +1202,14 @@ template <class KeyType,
           class KeyCompareWithMaxType,
           unsigned LogNodeSize,
           unsigned LogLeafSize,
-          class PDAllocStrategy
+          class PDAllocStrategy,
+          class PagerType
           >
 inline bool operator >=
     (const btree<KeyType, DataType, KeyCompareWithMaxType,
-                 LogNodeSize, LogLeafSize, PDAllocStrategy>& a,
+                 LogNodeSize, LogLeafSize, PDAllocStrategy, PagerType>& a,
     const btree<KeyType, DataType, KeyCompareWithMaxType,
-                LogNodeSize, LogLeafSize, PDAllocStrategy>& b)
+                LogNodeSize, LogLeafSize, PDAllocStrategy, PagerType>& b)
 {
     return !(a < b);
 }
@@ -1216,12 +1224,13 @@ template <class KeyType,
           class KeyCompareWithMaxType,
           unsigned LogNodeSize,
           unsigned LogLeafSize,
-          class PDAllocStrategy
+          class PDAllocStrategy,
+          class PagerType
           >
 void swap(stxxl::btree::btree<KeyType, DataType, KeyCompareWithMaxType,
-                              LogNodeSize, LogLeafSize, PDAllocStrategy>& a,
+                              LogNodeSize, LogLeafSize, PDAllocStrategy, PagerType>& a,
           stxxl::btree::btree<KeyType, DataType, KeyCompareWithMaxType,
-                              LogNodeSize, LogLeafSize, PDAllocStrategy>& b)
+                              LogNodeSize, LogLeafSize, PDAllocStrategy, PagerType>& b)
 {
     if (&a != &b)
         a.swap(b);
@@ -47,7 +47,7 @@ public:
     using key_compare = typename btree_type::key_compare;
 
     using alloc_strategy_type = typename btree_type::alloc_strategy_type;
-    using pager_type = stxxl::lru_pager<>;
+    using pager_type = typename btree_type::pager_type;
 
 private:
     btree_type* m_btree;
@@ -211,6 +211,7 @@ public:
             m_bm->new_block(m_alloc_strategy, new_bid);
 
             m_bid2node[new_bid] = node2kick;
+            pager_load(m_pager, node2kick, bid_hash()(new_bid));
 
             node.init(new_bid);
 
@@ -229,6 +230,7 @@ public:
 
         m_bm->new_block(m_alloc_strategy, new_bid);
         m_bid2node[new_bid] = free_node;
+        pager_load(m_pager, free_node, bid_hash()(new_bid));
         node_type& node = *(m_nodes[free_node]);
         node.init(new_bid);
 
@@ -306,6 +308,7 @@ public:
 
             m_reqs[node2kick] = node.load(bid);
             m_bid2node[bid] = node2kick;
+            pager_load(m_pager, node2kick, bid_hash()(bid));
 
             m_fixed[node2kick] = fix;
 
@@ -325,6 +328,7 @@ public:
         node_type& node = *(m_nodes[free_node]);
         m_reqs[free_node] = node.load(bid);
         m_bid2node[bid] = free_node;
+        pager_load(m_pager, free_node, bid_hash()(bid));
 
         m_pager.hit(free_node);
 
@@ -398,6 +402,7 @@ public:
 
             m_reqs[node2kick] = node.load(bid);
             m_bid2node[bid] = node2kick;
+            pager_load(m_pager, node2kick, bid_hash()(bid));
 
             m_fixed[node2kick] = fix;
 
@@ -417,6 +422,7 @@ public:
         node_type& node = *(m_nodes[free_node]);
         m_reqs[free_node] = node.load(bid);
         m_bid2node[bid] = free_node;
+        pager_load(m_pager, free_node, bid_hash()(bid));
 
         m_pager.hit(free_node);
 
@@ -501,6 +507,7 @@ public:
 
             m_reqs[node2kick] = node.prefetch(bid);
             m_bid2node[bid] = node2kick;
+            pager_load(m_pager, node2kick, bid_hash()(bid));
 
             m_fixed[node2kick] = false;
 
@@ -520,6 +527,7 @@ public:
         node_type& node = *(m_nodes[free_node]);
         m_reqs[free_node] = node.prefetch(bid);
         m_bid2node[bid] = free_node;
+        pager_load(m_pager, free_node, bid_hash()(bid));
 
         m_pager.hit(free_node);
 
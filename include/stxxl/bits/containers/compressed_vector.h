@@ -0,0 +1,614 @@
+/***************************************************************************
+ *  include/stxxl/bits/containers/compressed_vector.h
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#ifndef STXXL_CONTAINERS_COMPRESSED_VECTOR_HEADER
+#define STXXL_CONTAINERS_COMPRESSED_VECTOR_HEADER
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <queue>
+#include <type_traits>
+#include <vector>
+
+#include <tlx/logger/core.hpp>
+#include <tlx/simple_vector.hpp>
+
+#include <foxxll/common/utils.hpp>
+#include <foxxll/io/request_operations.hpp>
+#include <foxxll/mng/block_manager.hpp>
+#include <foxxll/mng/typed_block.hpp>
+
+#include <stxxl/bits/common/binary_buffer.h>
+#include <stxxl/bits/containers/pager.h>
+#include <stxxl/bits/defines.h>
+#include <stxxl/types>
+
+namespace stxxl {
+
+//! \addtogroup stlcont
+//! \{
+
+/*!
+ * \name Block codecs of compressed_vector
+ *
+ * A codec encodes the items of one block into a binary_buffer and decodes
+ * them from a binary_reader:
+ * \code
+ * struct Codec {
+ *     template <typename ValueType>
+ *     static void encode(const ValueType* items, size_t n, binary_buffer& out);
+ *     template <typename ValueType>
+ *     static void decode(binary_reader& in, ValueType* items, size_t n);
+ * };
+ * \endcode
+ * \{
+ */
+
+//! Codec storing the items unchanged.
+struct raw_codec
+{
+    template <typename ValueType>
+    static void encode(const ValueType* items, size_t n, binary_buffer& out)
+    {
+        out.append(items, n * sizeof(ValueType));
+    }
+
+    template <typename ValueType>
+    static void decode(binary_reader& in, ValueType* items, size_t n)
+    {
+        in.read(items, n * sizeof(ValueType));
+    }
+};
+
+//! Codec for integral items storing the zigzag encoded differences of
+//! consecutive items as varints, suited for counters, sorted keys and
+//! timestamps.
+struct delta_codec
+{
+    template <typename ValueType>
+    static void encode(const ValueType* items, size_t n, binary_buffer& out)
+    {
+        static_assert(std::is_integral<ValueType>::value,
+                      "delta_codec requires integral items");
+        using unsigned_type = typename std::make_unsigned<ValueType>::type;
+        using signed_type = typename std::make_signed<ValueType>::type;
+
+        unsigned_type prev = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            const unsigned_type x = static_cast<unsigned_type>(items[i]);
+            const int64_t d = static_cast<signed_type>(
+                static_cast<unsigned_type>(x - prev));
+            out.put_varint(static_cast<uint64_t>(
+                               (static_cast<uint64_t>(d) << 1) ^ static_cast<uint64_t>(d >> 63)));
+            prev = x;
+        }
+    }
+
+    template <typename ValueType>
+    static void decode(binary_reader& in, ValueType* items, size_t n)
+    {
+        using unsigned_type = typename std::make_unsigned<ValueType>::type;
+
+        unsigned_type prev = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            const uint64_t z = in.get_varint64();
+            const uint64_t d = (z >> 1) ^ (0 - (z & 1));
+            prev = static_cast<unsigned_type>(prev + static_cast<unsigned_type>(d));
+            items[i] = static_cast<ValueType>(prev);
+        }
+    }
+};
+
+//! Byte-oriented LZ77 codec for arbitrary items: greedy matching of four
+//! byte sequences via a hash table, sequences of literals and back
+//! references are stored with varint lengths.
+struct lz_codec
+{
+    //! log2 of the number of hash table entries
+    static constexpr unsigned hash_bits = 12;
+
+    template <typename ValueType>
+    static void encode(const ValueType* items, size_t n, binary_buffer& out)
+    {
+        const char* src = reinterpret_cast<const char*>(items);
+        const size_t len = n * sizeof(ValueType);
+        const size_t none = std::numeric_limits<size_t>::max();
+
+        std::vector<size_t> table(size_t(1) << hash_bits, none);
+
+        size_t anchor = 0, i = 0;
+        while (i + 4 <= len)
+        {
+            uint32_t seq;
+            memcpy(&seq, src + i, 4);
+            const size_t h = (seq * 2654435761u) >> (32 - hash_bits);
+            const size_t cand = table[h];
+            table[h] = i;
+
+            if (cand == none || memcmp(src + cand, src + i, 4) != 0) {
+                ++i;
+                continue;
+            }
+
+            size_t m = 4;
+            while (i + m < len && src[cand + m] == src[i + m])
+                ++m;
+
+            out.put_varint(static_cast<uint64_t>(i - anchor));
+            out.append(src + anchor, i - anchor);
+            out.put_varint(static_cast<uint64_t>(m));
+            out.put_varint(static_cast<uint64_t>(i - cand));
+
+            i += m;
+            anchor = i;
+        }
+
+        out.put_varint(static_cast<uint64_t>(len - anchor));
+        out.append(src + anchor, len - anchor);
+        out.put_varint(static_cast<uint64_t>(0));
+    }
+
+    template <typename ValueType>
+    static void decode(binary_reader& in, ValueType* items, size_t n)
+    {
+        char* dst = reinterpret_cast<char*>(items);
+        const size_t len = n * sizeof(ValueType);
+
+        size_t pos = 0;
+        while (true)
+        {
+            const size_t literals = static_cast<size_t>(in.get_varint64());
+            assert(pos + literals <= len);
+            in.read(dst + pos, literals);
+            pos += literals;
+
+            const size_t m = static_cast<size_t>(in.get_varint64());
+            if (m == 0) break;
+            const size_t offset = static_cast<size_t>(in.get_varint64());
+            assert(offset <= pos && pos + m <= len);
+
+            // byte-wise, as the reference may overlap the output
+            for (size_t j = 0; j < m; ++j, ++pos)
+                dst[pos] = dst[pos - offset];
+        }
+        assert(pos == len);
+    }
+};
+
+//! \}
+
+/*!
+ * External vector whose blocks are stored compressed.
+ *
+ * The items are grouped into blocks of BlockSize bytes, which are cached
+ * uncompressed in a page cache managed by a pager like in stxxl::vector. A
+ * block is decompressed by read_page() when it is loaded into the cache and
+ * recompressed by write_page() when a dirty block is evicted or flushed.
+ *
+ * Compressed blocks have variable size, hence they are not stored at fixed
+ * BIDs. Instead, they are appended to segments of BlockSize bytes allocated
+ * from the block manager, at offsets aligned for direct I/O. An extent index
+ * in internal memory stores segment, offset and length of each block.
+ * Rewritten blocks leave garbage in their old segment, and a segment is freed
+ * once it contains no live block. If a block does not compress, it is stored
+ * raw.
+ *
+ * \tparam ValueType type of the contained objects (POD with no references to internal memory)
+ * \tparam Codec codec of the blocks, e.g. delta_codec, lz_codec or raw_codec
+ * \tparam PagerType pager type, e.g. lru_pager<8>, the number of pages is the number of cached blocks
+ * \tparam BlockSize size of an uncompressed block in bytes, a multiple of 4096
+ * \tparam AllocStr parallel disk allocation strategy of the segments
+ */
+template <
+    typename ValueType,
+    typename Codec = delta_codec,
+    typename PagerType = lru_pager<8>,
+    size_t BlockSize = STXXL_DEFAULT_BLOCK_SIZE(ValueType),
+    typename AllocStr = foxxll::default_alloc_strategy
+    >
+class compressed_vector
+{
+    static constexpr bool debug = false;
+
+public:
+    using value_type = ValueType;
+    using reference = value_type &;
+    using const_reference = const value_type &;
+    using size_type = external_size_type;
+
+    using codec_type = Codec;
+    using pager_type = PagerType;
+    using alloc_strategy_type = AllocStr;
+
+    static constexpr size_t block_size = BlockSize;
+
+    //! type of the uncompressed blocks in the page cache
+    using block_type = foxxll::typed_block<BlockSize, ValueType>;
+
+    //! alignment of offset and length of the compressed blocks for direct I/O
+    static constexpr size_t io_alignment = 4096;
+
+    static_assert(BlockSize % io_alignment == 0,
+                  "compressed_vector requires blocks aligned for direct I/O");
+
+protected:
+    //! segments storing the compressed blocks, also used as I/O buffer
+    using segment_type = foxxll::typed_block<BlockSize, char>;
+    using bid_type = typename segment_type::bid_type;
+
+    //! location of a compressed block
+    struct extent
+    {
+        //! segment index
+        size_t segment;
+        //! byte offset in the segment
+        uint32_t offset;
+        //! length of the stored data in bytes, zero if never written
+        uint32_t length;
+        //! whether the block is stored uncompressed
+        bool raw;
+    };
+
+    enum { not_cached = -1 };
+
+    //! number of data bytes of an uncompressed block
+    static constexpr size_t raw_bytes = block_type::size * sizeof(value_type);
+
+    alloc_strategy_type m_alloc_strategy;
+    foxxll::block_manager* m_bm;
+    size_type m_size;
+
+    //! \name Extent Index
+    //! \{
+
+    //! location of each block
+    mutable std::vector<extent> m_extents;
+    //! BID of each segment, segments which were freed have an empty BID
+    mutable std::vector<bid_type> m_segments;
+    //! number of live (aligned) bytes in each segment
+    mutable std::vector<size_t> m_segment_live;
+    //! indexes of freed segments for reuse
+    mutable std::vector<size_t> m_free_segments;
+    //! segment which compressed blocks are appended to
+    mutable size_t m_current_segment;
+    //! write position in the current segment
+    mutable size_t m_segment_fill;
+
+    //! \}
+
+    //! \name Page Cache
+    //! \{
+
+    mutable pager_type m_pager;
+    mutable tlx::simple_vector<block_type> m_cache;
+    mutable std::vector<ptrdiff_t> m_block_to_slot;
+    mutable tlx::simple_vector<size_t> m_slot_to_block;
+    mutable std::vector<bool> m_slot_dirty;
+    mutable std::queue<size_t> m_free_slots;
+
+    //! \}
+
+    //! buffer for compressed blocks being read or written
+    mutable tlx::simple_vector<segment_type> m_iobuf;
+    //! encoded block before it is copied into m_iobuf
+    mutable binary_buffer m_encoded;
+
+    //! total number of compressed bytes in the extents
+    mutable size_type m_compressed_bytes;
+
+    static size_t align(size_t n)
+    {
+        return foxxll::div_ceil(n, io_alignment) * io_alignment;
+    }
+
+    //! drop the extent of a block, freeing its segment if it becomes empty
+    void release_extent(const size_t& block_no) const
+    {
+        extent& e = m_extents[block_no];
+        if (e.length == 0)
+            return;
+
+        m_compressed_bytes -= e.length;
+        m_segment_live[e.segment] -= align(e.length);
+        if (m_segment_live[e.segment] == 0 && e.segment != m_current_segment)
+            free_segment(e.segment);
+
+        e.length = 0;
+    }
+
+    //! return an empty segment to the block manager
+    void free_segment(const size_t& segment) const
+    {
+        TLX_LOG << "compressed_vector: free segment " << segment;
+        m_bm->delete_block(m_segments[segment]);
+        m_segments[segment] = bid_type();
+        m_free_segments.push_back(segment);
+    }
+
+    //! allocate a new segment for appending compressed blocks
+    void next_segment() const
+    {
+        if (m_current_segment != size_t(-1) && m_segment_live[m_current_segment] == 0)
+            free_segment(m_current_segment);
+
+        if (m_free_segments.empty()) {
+            m_segments.emplace_back();
+            m_segment_live.push_back(0);
+            m_current_segment = m_segments.size() - 1;
+        }
+        else {
+            m_current_segment = m_free_segments.back();
+            m_free_segments.pop_back();
+        }
+
+        m_bm->new_blocks(m_alloc_strategy,
+                         m_segments.begin() + m_current_segment,
+                         m_segments.begin() + m_current_segment + 1,
+                         m_current_segment);
+        m_segment_fill = 0;
+    }
+
+    //! compress a block from a cache frame and append it to a segment
+    void write_page(const size_t& block_no, const block_type& frame) const
+    {
+        m_encoded.clear();
+        codec_type::encode(frame.begin(), block_type::size, m_encoded);
+
+        const bool raw = (m_encoded.size() >= raw_bytes);
+        const char* data = raw ? reinterpret_cast<const char*>(frame.begin()) : m_encoded.data();
+        const size_t length = raw ? raw_bytes : m_encoded.size();
+        const size_t io_length = align(length);
+
+        release_extent(block_no);
+        if (m_current_segment == size_t(-1) || m_segment_fill + io_length > BlockSize)
+            next_segment();
+
+        TLX_LOG << "compressed_vector::write_page(): block " << block_no
+                << " length " << length << " in segment " << m_current_segment
+                << " @ " << m_segment_fill;
+
+        memcpy(m_iobuf[0].begin(), data, length);
+        const bid_type& bid = m_segments[m_current_segment];
+        bid.storage->awrite(m_iobuf[0].begin(), bid.offset + m_segment_fill, io_length)->wait();
+
+        extent& e = m_extents[block_no];
+        e.segment = m_current_segment;
+        e.offset = static_cast<uint32_t>(m_segment_fill);
+        e.length = static_cast<uint32_t>(length);
+        e.raw = raw;
+
+        m_segment_fill += io_length;
+        m_segment_live[m_current_segment] += io_length;
+        m_compressed_bytes += length;
+    }
+
+    //! read a compressed block and decompress it into a cache frame
+    void read_page(const size_t& block_no, block_type& frame) const
+    {
+        const extent& e = m_extents[block_no];
+        if (e.length == 0) {
+            std::fill(frame.begin(), frame.end(), value_type());
+            return;
+        }
+
+        const bid_type& bid = m_segments[e.segment];
+        bid.storage->aread(m_iobuf[0].begin(), bid.offset + e.offset, align(e.length))->wait();
+
+        if (e.raw) {
+            memcpy(frame.begin(), m_iobuf[0].begin(), raw_bytes);
+            return;
+        }
+
+        binary_reader in(m_iobuf[0].begin(), e.length);
+        codec_type::decode(in, frame.begin(), block_type::size);
+    }
+
+    //! returns the cache slot of a block, loading it if necessary
+    size_t load(const size_t& block_no) const
+    {
+        const ptrdiff_t cached = m_block_to_slot[block_no];
+        if (cached != not_cached) {
+            m_pager.hit(static_cast<size_t>(cached));
+            return static_cast<size_t>(cached);
+        }
+
+        size_t slot;
+        if (m_free_slots.empty())
+        {
+            slot = m_pager.kick();
+            const size_t old_block = m_slot_to_block[slot];
+            if (m_slot_dirty[slot])
+                write_page(old_block, m_cache[slot]);
+            m_block_to_slot[old_block] = not_cached;
+        }
+        else
+        {
+            slot = m_free_slots.front();
+            m_free_slots.pop();
+        }
+
+        read_page(block_no, m_cache[slot]);
+
+        pager_load(m_pager, slot, block_no);
+        m_pager.hit(slot);
+        m_block_to_slot[block_no] = static_cast<ptrdiff_t>(slot);
+        m_slot_to_block[slot] = block_no;
+        m_slot_dirty[slot] = false;
+        return slot;
+    }
+
+public:
+    //! Constructs a compressed vector with n elements.
+    //!
+    //! \param n Number of elements.
+    //! \param npages Number of cached blocks.
+    explicit compressed_vector(size_type n = 0,
+                               size_t npages = pager_type::default_npages)
+        : m_bm(foxxll::block_manager::get_instance()),
+          m_size(0),
+          m_current_segment(size_t(-1)),
+          m_segment_fill(0),
+          m_pager(npages),
+          m_cache(npages),
+          m_slot_to_block(npages),
+          m_slot_dirty(npages, false),
+          m_iobuf(1),
+          m_compressed_bytes(0)
+    {
+        for (size_t i = 0; i < numpages(); ++i)
+            m_free_slots.push(i);
+
+        resize(n);
+    }
+
+    //! non-copyable: delete copy-constructor
+    compressed_vector(const compressed_vector&) = delete;
+    //! non-copyable: delete assignment operator
+    compressed_vector& operator = (const compressed_vector&) = delete;
+
+    ~compressed_vector()
+    {
+        for (const bid_type& bid : m_segments) {
+            if (bid.storage)
+                m_bm->delete_block(bid);
+        }
+    }
+
+    //! \name Size and Capacity
+    //! \{
+
+    //! return the size of the vector.
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    //! true if the vector's size is zero.
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    //! Number of blocks cached uncompressed.
+    size_t numpages() const
+    {
+        return m_pager.size();
+    }
+
+    //! Number of compressed bytes of all blocks.
+    size_type compressed_bytes() const
+    {
+        return m_compressed_bytes;
+    }
+
+    //! Number of bytes allocated on disks for the segments.
+    size_type raw_capacity() const
+    {
+        return size_type(m_segments.size() - m_free_segments.size()) * BlockSize;
+    }
+
+    //! Resize vector contents to n items. New items are value-initialized.
+    void resize(size_type n)
+    {
+        const size_t new_blocks = static_cast<size_t>(
+            foxxll::div_ceil(n, block_type::size));
+
+        for (size_t b = new_blocks; b < m_extents.size(); ++b)
+        {
+            const ptrdiff_t slot = m_block_to_slot[b];
+            if (slot != not_cached) {
+                m_free_slots.push(static_cast<size_t>(slot));
+                m_slot_dirty[slot] = false;
+            }
+            release_extent(b);
+        }
+
+        // clear the items beyond the old size in its last block
+        if (n > m_size && m_size % block_type::size != 0)
+        {
+            const size_t block_no = static_cast<size_t>(m_size / block_type::size);
+            const size_t slot = load(block_no);
+            std::fill(m_cache[slot].begin() + m_size % block_type::size,
+                      m_cache[slot].end(), value_type());
+            m_slot_dirty[slot] = true;
+        }
+
+        extent empty_extent = { 0, 0, 0, false };
+        m_extents.resize(new_blocks, empty_extent);
+        m_block_to_slot.resize(new_blocks, not_cached);
+        m_size = n;
+    }
+
+    //! \}
+
+    //! \name Modifiers
+    //! \{
+
+    //! Append a new element at the end.
+    void push_back(const value_type& obj)
+    {
+        const size_type old_size = m_size;
+        resize(old_size + 1);
+        (*this)[old_size] = obj;
+    }
+
+    //! Erases all elements and frees all segments.
+    void clear()
+    {
+        resize(0);
+    }
+
+    //! Write all dirty blocks of the page cache.
+    void flush() const
+    {
+        for (size_t slot = 0; slot < numpages(); ++slot)
+        {
+            if (!m_slot_dirty[slot])
+                continue;
+            write_page(m_slot_to_block[slot], m_cache[slot]);
+            m_slot_dirty[slot] = false;
+        }
+    }
+
+    //! \}
+
+    //! \name Element Access
+    //! \{
+
+    //! Returns a reference to the element at offset, which is valid until the
+    //! next access to the vector. The block is recompressed when evicted.
+    reference operator [] (size_type offset)
+    {
+        assert(offset < m_size);
+        const size_t slot = load(static_cast<size_t>(offset / block_type::size));
+        m_slot_dirty[slot] = true;
+        return m_cache[slot][offset % block_type::size];
+    }
+
+    //! Returns the element at offset.
+    const_reference operator [] (size_type offset) const
+    {
+        assert(offset < m_size);
+        const size_t slot = load(static_cast<size_t>(offset / block_type::size));
+        return m_cache[slot][offset % block_type::size];
+    }
+
+    //! \}
+};
+
+//! \}
+
+} // namespace stxxl
+
+#endif // !STXXL_CONTAINERS_COMPRESSED_VECTOR_HEADER
@@ -0,0 +1,419 @@
+/***************************************************************************
+ *  include/stxxl/bits/containers/concurrent_queue.h
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#ifndef STXXL_CONTAINERS_CONCURRENT_QUEUE_HEADER
+#define STXXL_CONTAINERS_CONCURRENT_QUEUE_HEADER
+
+#include <atomic>
+#include <cassert>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include <tlx/define.hpp>
+#include <tlx/logger/core.hpp>
+
+#include <foxxll/io/request.hpp>
+#include <foxxll/mng/block_manager.hpp>
+#include <foxxll/mng/config.hpp>
+#include <foxxll/mng/typed_block.hpp>
+
+#include <stxxl/bits/defines.h>
+#include <stxxl/types>
+
+namespace stxxl {
+
+//! \addtogroup stlcont
+//! \{
+
+/*!
+ * External FIFO queue for many producer and consumer threads.
+ *
+ * Threads access the queue via handles: each producer fills a private block
+ * and publishes it to the shared list of blocks when it is full (or on
+ * flush()), and each consumer claims a whole block from the front of the list
+ * and pops its elements privately. Hence, only publishing and claiming a
+ * block take the queue's lock, single pushes and pops do not.
+ *
+ * Published blocks are kept in internal memory up to a limit, further blocks
+ * are written to disk asynchronously. The blocks at the front of the list are
+ * read ahead, so consumers usually claim blocks which are already in memory.
+ *
+ * The order is FIFO for blocks, not for single elements: elements of
+ * different producers are interleaved blockwise, and elements not yet
+ * published are not visible to consumers.
+ *
+ * \code
+ * stxxl::concurrent_queue<int> q;
+ * // in each producer thread
+ * stxxl::concurrent_queue<int>::producer p(q);
+ * p.push(42);
+ * p.flush();
+ * // in each consumer thread
+ * stxxl::concurrent_queue<int>::consumer c(q);
+ * int x;
+ * while (c.pop(x)) { ... }
+ * \endcode
+ *
+ * \tparam ValueType type of the contained objects (POD with no references to internal memory)
+ * \tparam BlockSize size of the external memory block in bytes, default is \c STXXL_DEFAULT_BLOCK_SIZE(ValueType)
+ * \tparam AllocStr parallel disk block allocation strategy, default is \c foxxll::default_alloc_strategy
+ * \tparam SizeType size data type, default is \c external_size_type
+ */
+template <class ValueType,
+          size_t BlockSize = STXXL_DEFAULT_BLOCK_SIZE(ValueType),
+          class AllocStr = foxxll::default_alloc_strategy,
+          class SizeType = external_size_type>
+class concurrent_queue
+{
+    static constexpr bool debug = false;
+
+public:
+    using value_type = ValueType;
+    using alloc_strategy_type = AllocStr;
+    using size_type = SizeType;
+    enum {
+        block_size = BlockSize
+    };
+
+    using block_type = foxxll::typed_block<block_size, value_type>;
+    using bid_type = foxxll::BID<block_size>;
+
+    class producer;
+    class consumer;
+
+private:
+    //! state of a published block
+    enum entry_state { in_memory, writing, on_disk, reading };
+
+    //! a published block, possibly with fewer than block_type::size elements
+    struct entry
+    {
+        entry_state state;
+        block_type* block;
+        bid_type bid;
+        size_t size;
+        foxxll::request_ptr req;
+    };
+
+    //! protects all members below
+    std::mutex m_mutex;
+
+    //! published blocks in FIFO order
+    std::deque<entry> m_entries;
+
+    //! number of entries popped from m_entries so far
+    size_t m_popped;
+
+    //! absolute index of the oldest entry which may still be writing
+    size_t m_write_scan;
+
+    //! number of entries in state in_memory
+    size_t m_in_memory;
+
+    //! unused blocks
+    std::vector<block_type*> m_free_blocks;
+
+    //! maximum number of published blocks kept in internal memory
+    size_t m_memory_blocks;
+
+    //! number of blocks at the front to read ahead
+    size_t m_prefetch_blocks;
+
+    //! number of published elements
+    std::atomic<size_type> m_size;
+
+    alloc_strategy_type m_alloc_strategy;
+    size_t m_alloc_count;
+    foxxll::block_manager* m_bm;
+
+    //! get an unused block, the lock must be held
+    block_type * get_block()
+    {
+        if (m_free_blocks.empty())
+            return new block_type;
+        block_type* b = m_free_blocks.back();
+        m_free_blocks.pop_back();
+        return b;
+    }
+
+    //! return an unused block, the lock must be held
+    void put_block(block_type* b)
+    {
+        if (m_free_blocks.size() < m_memory_blocks)
+            m_free_blocks.push_back(b);
+        else
+            delete b;
+    }
+
+    //! recycle the blocks of finished writes, the lock must be held
+    void collect_writes()
+    {
+        if (m_write_scan < m_popped)
+            m_write_scan = m_popped;
+
+        for ( ; m_write_scan < m_popped + m_entries.size(); ++m_write_scan)
+        {
+            entry& e = m_entries[m_write_scan - m_popped];
+            if (e.state == writing) {
+                if (!e.req->poll()) break;
+                put_block(e.block);
+                e.block = nullptr;
+                e.req = foxxll::request_ptr();
+                e.state = on_disk;
+            }
+        }
+    }
+
+    //! append a block to the list, which takes ownership of it
+    void publish(block_type* block, size_t size)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        entry e { in_memory, block, bid_type(), size, foxxll::request_ptr() };
+
+        if (m_in_memory >= m_memory_blocks && m_entries.size() >= m_prefetch_blocks)
+        {
+            m_bm->new_block(m_alloc_strategy, e.bid, m_alloc_count++);
+            e.req = block->write(e.bid);
+            e.state = writing;
+            TLX_LOG << "concurrent_queue[" << this << "]: write block @ " << e.bid;
+        }
+        else {
+            ++m_in_memory;
+        }
+
+        m_entries.push_back(e);
+        m_size += size;
+
+        collect_writes();
+    }
+
+    //! claim the front block, returns false if there is none
+    bool claim(block_type*& block, size_t& size)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        if (m_entries.empty())
+            return false;
+
+        entry e = m_entries.front();
+        m_entries.pop_front();
+        ++m_popped;
+        m_size -= e.size;
+
+        if (e.state == in_memory) {
+            --m_in_memory;
+        }
+        else if (e.state == on_disk) {
+            e.block = get_block();
+            e.req = e.block->read(e.bid);
+        }
+
+        // read ahead the next blocks
+        for (size_t i = 0; i < m_prefetch_blocks && i < m_entries.size(); ++i)
+        {
+            entry& n = m_entries[i];
+            if (n.state != on_disk) continue;
+            n.block = get_block();
+            n.req = n.block->read(n.bid);
+            n.state = reading;
+        }
+
+        lock.unlock();
+
+        // wait for the write or read of the block outside the lock
+        if (e.state != in_memory) {
+            e.req->wait();
+            m_bm->delete_block(e.bid);
+        }
+
+        block = e.block;
+        size = e.size;
+        return true;
+    }
+
+    //! return a consumed block
+    void release(block_type* block)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        put_block(block);
+    }
+
+public:
+    //! \name Constructors/Destructors
+    //! \{
+
+    //! Constructs an empty queue.
+    //!
+    //! \param memory_blocks maximum number of published blocks kept in
+    //! internal memory, default is 4 * D. Each handle holds one more block.
+    //! \param prefetch_blocks number of blocks read ahead, default is 2 * D
+    explicit concurrent_queue(size_t memory_blocks = 0, size_t prefetch_blocks = 0)
+        : m_popped(0), m_write_scan(0), m_in_memory(0),
+          m_size(0),
+          m_alloc_count(0),
+          m_bm(foxxll::block_manager::get_instance())
+    {
+        const size_t disks = foxxll::config::get_instance()->disks_number();
+        m_memory_blocks = memory_blocks ? memory_blocks : 4 * disks;
+        m_prefetch_blocks = prefetch_blocks ? prefetch_blocks : 2 * disks;
+    }
+
+    //! non-copyable: delete copy-constructor
+    concurrent_queue(const concurrent_queue&) = delete;
+    //! non-copyable: delete assignment operator
+    concurrent_queue& operator = (const concurrent_queue&) = delete;
+
+    //! Destroys the queue, all handles must have been destroyed before.
+    ~concurrent_queue()
+    {
+        for (entry& e : m_entries)
+        {
+            if (e.req.valid())
+                e.req->wait();
+            delete e.block;
+            if (e.state != in_memory)
+                m_bm->delete_block(e.bid);
+        }
+        for (block_type* b : m_free_blocks)
+            delete b;
+    }
+
+    //! \}
+
+    //! \name Capacity
+    //! \{
+
+    //! Returns the number of published elements, which changes concurrently.
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    //! Returns \c true if no published elements are left.
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    //! \}
+
+    /*!
+     * Handle of a producer thread. Pushed elements are collected in a private
+     * block which is published when it is full, on flush() or on destruction.
+     */
+    class producer
+    {
+    protected:
+        concurrent_queue& m_queue;
+        block_type* m_block;
+        size_t m_pos;
+
+    public:
+        explicit producer(concurrent_queue& queue)
+            : m_queue(queue), m_block(nullptr), m_pos(0)
+        { }
+
+        //! non-copyable: delete copy-constructor
+        producer(const producer&) = delete;
+        //! non-copyable: delete assignment operator
+        producer& operator = (const producer&) = delete;
+
+        ~producer()
+        {
+            flush();
+        }
+
+        //! Append an element to the private block.
+        void push(const value_type& val)
+        {
+            if (TLX_UNLIKELY(m_block == nullptr)) {
+                std::unique_lock<std::mutex> lock(m_queue.m_mutex);
+                m_block = m_queue.get_block();
+            }
+
+            (*m_block)[m_pos++] = val;
+
+            if (TLX_UNLIKELY(m_pos == block_type::size))
+                flush();
+        }
+
+        //! Publish the private block, even if it is not full.
+        void flush()
+        {
+            if (m_pos == 0) return;
+            m_queue.publish(m_block, m_pos);
+            m_block = nullptr;
+            m_pos = 0;
+        }
+    };
+
+    /*!
+     * Handle of a consumer thread. Elements are popped from a private claimed
+     * block, the next block is claimed when it is exhausted.
+     */
+    class consumer
+    {
+    protected:
+        concurrent_queue& m_queue;
+        block_type* m_block;
+        size_t m_pos;
+        size_t m_size;
+
+    public:
+        explicit consumer(concurrent_queue& queue)
+            : m_queue(queue), m_block(nullptr), m_pos(0), m_size(0)
+        { }
+
+        //! non-copyable: delete copy-constructor
+        consumer(const consumer&) = delete;
+        //! non-copyable: delete assignment operator
+        consumer& operator = (const consumer&) = delete;
+
+        //! Destroys the handle, unpopped elements of its block are lost.
+        ~consumer()
+        {
+            if (m_block)
+                m_queue.release(m_block);
+        }
+
+        //! Pop an element into val, returns false if no published elements
+        //! are left.
+        bool pop(value_type& val)
+        {
+            if (TLX_UNLIKELY(m_pos == m_size))
+            {
+                if (m_block) {
+                    m_queue.release(m_block);
+                    m_block = nullptr;
+                }
+                m_pos = m_size = 0;
+                if (!m_queue.claim(m_block, m_size))
+                    return false;
+            }
+
+            val = (*m_block)[m_pos++];
+            return true;
+        }
+
+        //! Number of elements left in the claimed block.
+        size_t claimed() const
+        {
+            return m_size - m_pos;
+        }
+    };
+};
+
+//! \}
+
+} // namespace stxxl
+
+#endif // !STXXL_CONTAINERS_CONCURRENT_QUEUE_HEADER
@@ -16,11 +16,15 @@
 #define STXXL_CONTAINERS_DEQUE_HEADER
 
 #include <algorithm>
+#include <cassert>
 #include <deque>
 #include <limits>
 #include <utility>
 #include <vector>
 
+#include <tlx/define.hpp>
+#include <tlx/logger/core.hpp>
+
 #include <stxxl/vector>
 
 namespace stxxl {
@@ -419,6 +423,8 @@ public:
 //! It is an adaptor of the \c VectorType.
 //! The implementation wraps the elements around
 //! the end of the \c VectorType circularly.
+//! For work lists which mostly push and pop at the ends, stxxl::block_deque
+//! is faster, since it prefetches and writes blocks like stxxl::sequence.
 //! \tparam ValueType type of the contained objects (POD with no references to internal memory)
 //! \tparam VectorType the type of the underlying vector container,
 //! the default is \c stxxl::vector<ValueType>
@@ -715,6 +721,245 @@ bool operator < (const deque<ValueType, VectorType>& a, const deque<ValueType, V
     return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
 }
 
+//! A deque that migrates from internal memory to external when its size
+//! exceeds a certain threshold, and optionally back when it shrinks again.
+//! While the deque is internal, no external vector is allocated.
+//!
+//! For semantics of the methods see documentation of the STL \c std::deque.
+//! \tparam ValueType type of the contained objects (POD with no references to internal memory)
+//! \tparam CritSize number of elements at which the deque migrates to external memory
+//! \tparam ExternalDeque type of the external deque, default is \c stxxl::deque<ValueType>
+//! \tparam InternalDeque type of the internal deque, default is \c std::deque<ValueType>
+template <class ValueType, size_t CritSize,
+          class ExternalDeque = deque<ValueType>,
+          class InternalDeque = std::deque<ValueType> >
+class migrating_deque
+{
+    static constexpr bool debug = false;
+
+public:
+    using value_type = ValueType;
+    using size_type = typename ExternalDeque::size_type;
+    using reference = ValueType &;
+    using const_reference = const ValueType &;
+
+    using int_deque_type = InternalDeque;
+    using ext_deque_type = ExternalDeque;
+
+private:
+    enum { critical_size = CritSize };
+
+    int_deque_type* int_impl;
+    ext_deque_type* ext_impl;
+
+    //! size at which the external deque migrates back, 0 for never
+    size_t demote_size;
+
+public:
+    //! \name Constructors/Destructors
+    //! \{
+
+    migrating_deque()
+        : int_impl(new int_deque_type()), ext_impl(nullptr), demote_size(0)
+    { }
+
+    //! non-copyable: delete copy-constructor
+    migrating_deque(const migrating_deque&) = delete;
+    //! non-copyable: delete assignment operator
+    migrating_deque& operator = (const migrating_deque&) = delete;
+
+    ~migrating_deque()
+    {
+        delete int_impl;
+        delete ext_impl;
+    }
+
+    //! \}
+
+    //! \name Modifiers
+    //! \{
+
+    void swap(migrating_deque& obj)
+    {
+        std::swap(int_impl, obj.int_impl);
+        std::swap(ext_impl, obj.ext_impl);
+        std::swap(demote_size, obj.demote_size);
+    }
+
+    //! \}
+
+    //! \name Miscellaneous
+    //! \{
+
+    //! Returns true if current implementation is internal, otherwise false.
+    bool internal() const
+    {
+        assert((int_impl && !ext_impl) || (!int_impl && ext_impl));
+        return (int_impl != nullptr);
+    }
+    //! Returns true if current implementation is external, otherwise false.
+    bool external() const
+    {
+        assert((int_impl && !ext_impl) || (!int_impl && ext_impl));
+        return (ext_impl != nullptr);
+    }
+
+    //! Lets the external deque migrate back to internal memory when
+    //! pop_front() or pop_back() shrink it to new_size elements, 0 disables
+    //! migrating back. The size should be well below CritSize to avoid
+    //! migrating back and forth.
+    void set_demote_size(size_t new_size)
+    {
+        assert(new_size < critical_size);
+        demote_size = new_size;
+    }
+
+    //! \}
+
+    //! \name Capacity
+    //! \{
+
+    bool empty() const
+    {
+        assert((int_impl && !ext_impl) || (!int_impl && ext_impl));
+        return (int_impl) ? int_impl->empty() : ext_impl->empty();
+    }
+
+    size_type size() const
+    {
+        assert((int_impl && !ext_impl) || (!int_impl && ext_impl));
+        return (int_impl) ? size_type(int_impl->size()) : ext_impl->size();
+    }
+
+    //! \}
+
+    //! \name Operators
+    //! \{
+
+    reference operator [] (size_type n)
+    {
+        assert(n < size());
+        return (int_impl) ? (*int_impl)[n] : (*ext_impl)[n];
+    }
+
+    const_reference operator [] (size_type n) const
+    {
+        assert(n < size());
+        return (int_impl) ? (*int_impl)[n] : (*ext_impl)[n];
+    }
+
+    reference front()
+    {
+        assert(!empty());
+        return (int_impl) ? int_impl->front() : ext_impl->front();
+    }
+
+    const_reference front() const
+    {
+        assert(!empty());
+        return (int_impl) ? int_impl->front() : ext_impl->front();
+    }
+
+    reference back()
+    {
+        assert(!empty());
+        return (int_impl) ? int_impl->back() : ext_impl->back();
+    }
+
+    const_reference back() const
+    {
+        assert(!empty());
+        return (int_impl) ? int_impl->back() : ext_impl->back();
+    }
+
+    //! \}
+
+    //! \name Modifiers
+    //! \{
+
+    void push_front(const value_type& el)
+    {
+        if (int_impl)
+        {
+            int_impl->push_front(el);
+            if (TLX_UNLIKELY(int_impl->size() == critical_size))
+                promote();
+        }
+        else
+            ext_impl->push_front(el);
+    }
+
+    void push_back(const value_type& el)
+    {
+        if (int_impl)
+        {
+            int_impl->push_back(el);
+            if (TLX_UNLIKELY(int_impl->size() == critical_size))
+                promote();
+        }
+        else
+            ext_impl->push_back(el);
+    }
+
+    void pop_front()
+    {
+        assert(!empty());
+        if (int_impl)
+        {
+            int_impl->pop_front();
+        }
+        else
+        {
+            ext_impl->pop_front();
+            if (TLX_UNLIKELY(ext_impl->size() == demote_size && demote_size != 0))
+                demote();
+        }
+    }
+
+    void pop_back()
+    {
+        assert(!empty());
+        if (int_impl)
+        {
+            int_impl->pop_back();
+        }
+        else
+        {
+            ext_impl->pop_back();
+            if (TLX_UNLIKELY(ext_impl->size() == demote_size && demote_size != 0))
+                demote();
+        }
+    }
+
+    //! \}
+
+private:
+    //! migrate to the external deque
+    void promote()
+    {
+        TLX_LOG << "migrating_deque[" << this << "]: promote at " << int_impl->size();
+        ext_impl = new ext_deque_type();
+        for (const value_type& v : *int_impl)
+            ext_impl->push_back(v);
+        delete int_impl;
+        int_impl = nullptr;
+    }
+
+    //! migrate back to the internal deque
+    void demote()
+    {
+        TLX_LOG << "migrating_deque[" << this << "]: demote at " << ext_impl->size();
+        int_impl = new int_deque_type();
+        while (!ext_impl->empty())
+        {
+            int_impl->push_back(ext_impl->front());
+            ext_impl->pop_front();
+        }
+        delete ext_impl;
+        ext_impl = nullptr;
+    }
+};
+
 //! \}
 
 } // namespace stxxl
@@ -116,8 +116,8 @@ public:
 };
 
 //! Cache of blocks contained in an external memory hash map. Uses the
-//! stxxl::lru_pager as eviction algorithm.
-template <class BlockType>
+//! PagerType (default stxxl::lru_pager) as eviction algorithm.
+template <class BlockType, class PagerType = stxxl::lru_pager<> >
 class block_cache
 {
     static constexpr bool debug = false;
@@ -157,7 +157,7 @@ protected:
 #endif
     };
 
-    using pager_type = stxxl::lru_pager<>;
+    using pager_type = PagerType;
     using write_buffer_type = block_cache_write_buffer<block_type>;
 
     using bid_map_type = typename std::unordered_map<
@@ -416,6 +416,7 @@ public:
             bids_[i_block] = bid;
             dirty_[i_block] = false;
             retain_count_[i_block] = 0;
+            pager_load(pager_, i_block, bid_hash()(bid));
         }
 
         // now actually load the wanted subblock and store it within *block
@@ -462,6 +463,7 @@ public:
             bids_[i_block] = bid;
             retain_count_[i_block] = 0;
             dirty_[i_block] = false;
+            pager_load(pager_, i_block, bid_hash()(bid));
         }
 
         // now actually load the block
@@ -600,9 +602,9 @@ void swap(stxxl::hash_map::block_cache_write_buffer<BlockType>& a,
     a.swap(b);
 }
 
-template <class HashMap>
-void swap(stxxl::hash_map::block_cache<HashMap>& a,
-          stxxl::hash_map::block_cache<HashMap>& b)
+template <class BlockType, class PagerType>
+void swap(stxxl::hash_map::block_cache<BlockType, PagerType>& a,
+          stxxl::hash_map::block_cache<BlockType, PagerType>& b)
 {
     a.swap(b);
 }
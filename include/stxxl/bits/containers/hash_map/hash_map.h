@@ -50,6 +50,7 @@ namespace hash_map {
  * \tparam SubBlocksPerBlock the number of subblocks per external block
  * (default: 256 -> 2MB blocks)
  * \tparam AllocType allocator for internal-memory buffer
+ * \tparam PagerType pager used by the block cache, see stxxl::lru_pager
  */
 template <class KeyType,
           class MappedType,
@@ -57,7 +58,8 @@ template <class KeyType,
           class KeyCompareWithMinMax,
           unsigned SubBlockSize = 4*1024,
           unsigned SubBlocksPerBlock = 256,
-          class AllocatorType = std::allocator<std::pair<const KeyType, MappedType> >
+          class AllocatorType = std::allocator<std::pair<const KeyType, MappedType> >,
+          class PagerType = stxxl::lru_pager<>
           >
 class hash_map
 {
@@ -65,7 +67,8 @@ class hash_map
 
 protected:
     using self_type = hash_map<KeyType, MappedType, HashType, KeyCompareWithMinMax,
-                               SubBlockSize, SubBlocksPerBlock>;
+                               SubBlockSize, SubBlocksPerBlock, AllocatorType,
+                               PagerType>;
 
 public:
     //! type of the keys being used
@@ -135,7 +138,7 @@ public:
     //! for tracking active iterators
     using iterator_map_type = iterator_map<self_type>;
 
-    using block_cache_type = block_cache<block_type>;
+    using block_cache_type = block_cache<block_type, PagerType>;
 
     using reader_type = buffered_reader<block_cache_type, bid_iterator_type>;
 
@@ -1458,7 +1461,7 @@ protected:
     friend class hash_map_iterator<self_type>;
     friend class hash_map_const_iterator<self_type>;
     friend class iterator_map<self_type>;
-    friend class block_cache<block_type>;
+    friend class block_cache<block_type, PagerType>;
     friend struct HashedValuesStream<self_type, reader_type>;
 
 #if 1
@@ -1593,11 +1596,14 @@ public:
 namespace std {
 
 template <class KeyType, class MappedType, class HashType, class KeyCompareType,
-          unsigned SubBlockSize, unsigned SubBlocksPerBlock, class AllocType>
+          unsigned SubBlockSize, unsigned SubBlocksPerBlock, class AllocType,
+          class PagerType>
 void swap(stxxl::hash_map::hash_map<KeyType, MappedType, HashType, KeyCompareType,
-                                    SubBlockSize, SubBlocksPerBlock, AllocType>& a,
+                                    SubBlockSize, SubBlocksPerBlock, AllocType,
+                                    PagerType>& a,
           stxxl::hash_map::hash_map<KeyType, MappedType, HashType, KeyCompareType,   // NOLINT
-                                    SubBlockSize, SubBlocksPerBlock, AllocType>& b)
+                                    SubBlockSize, SubBlocksPerBlock, AllocType,
+                                    PagerType>& b)
 {
     if (&a != &b)
         a.swap(b);
@@ -27,7 +27,7 @@ template <class HashMap>
 class hash_map_iterator;
 template <class HashMap>
 class hash_map_const_iterator;
-template <class HashMap>
+template <class BlockType, class PagerType>
 class block_cache;
 
 template <class HashMap>
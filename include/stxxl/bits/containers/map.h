@@ -28,7 +28,8 @@ template <class KeyType,
           class CompareType,
           unsigned LogNodeSize,
           unsigned LogLeafSize,
-          class PDAllocStrategy
+          class PDAllocStrategy,
+          class PagerType
           >
 class btree;
 
@@ -73,17 +74,20 @@ class btree;
 //! \tparam RawNodeSize size of internal nodes of map in bytes (btree implementation).
 //! \tparam RawLeafSize size of leaves of map in bytes (btree implementation).
 //! \tparam PDAllocStrategy parallel disk block allocation strategy (\c foxxll::simple_random is recommended and default)
+//! \tparam PagerType pager used by the node caches: \c lru_pager, \c clock_pager,
+//! \c twoq_pager or \c arc_pager (default: lru_pager)
 //!
 template <class KeyType,
           class DataType,
           class CompareType,
           unsigned RawNodeSize = 16* 1024,      // 16 KBytes default
           unsigned RawLeafSize = 128* 1024,     // 128 KBytes default
-          class PDAllocStrategy = foxxll::simple_random
+          class PDAllocStrategy = foxxll::simple_random,
+          class PagerType = stxxl::lru_pager<>
           >
 class map
 {
-    using impl_type = btree::btree<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy>;
+    using impl_type = btree::btree<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy, PagerType>;
 
     impl_type impl;
 
@@ -363,54 +367,60 @@ public:
               class CompareType_,
               unsigned RawNodeSize_,
               unsigned RawLeafSize_,
-              class PDAllocStrategy_>
-    friend bool operator == (const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_>& a,
-                             const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_>& b);
+              class PDAllocStrategy_,
+              class PagerType_>
+    friend bool operator == (const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_, PagerType_>& a,
+                             const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_, PagerType_>& b);
     //////////////////////////////////////////////////
     template <class KeyType_,
               class DataType_,
               class CompareType_,
               unsigned RawNodeSize_,
               unsigned RawLeafSize_,
-              class PDAllocStrategy_>
-    friend bool operator < (const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_>& a,
-                            const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_>& b);
+              class PDAllocStrategy_,
+              class PagerType_>
+    friend bool operator < (const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_, PagerType_>& a,
+                            const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_, PagerType_>& b);
     //////////////////////////////////////////////////
     template <class KeyType_,
               class DataType_,
               class CompareType_,
               unsigned RawNodeSize_,
               unsigned RawLeafSize_,
-              class PDAllocStrategy_>
-    friend bool operator > (const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_>& a,
-                            const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_>& b);
+              class PDAllocStrategy_,
+              class PagerType_>
+    friend bool operator > (const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_, PagerType_>& a,
+                            const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_, PagerType_>& b);
     //////////////////////////////////////////////////
     template <class KeyType_,
               class DataType_,
               class CompareType_,
               unsigned RawNodeSize_,
               unsigned RawLeafSize_,
-              class PDAllocStrategy_>
-    friend bool operator != (const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_>& a,
-                             const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_>& b);
+              class PDAllocStrategy_,
+              class PagerType_>
+    friend bool operator != (const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_, PagerType_>& a,
+                             const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_, PagerType_>& b);
     //////////////////////////////////////////////////
     template <class KeyType_,
               class DataType_,
               class CompareType_,
               unsigned RawNodeSize_,
               unsigned RawLeafSize_,
-              class PDAllocStrategy_>
-    friend bool operator <= (const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_>& a,
-                             const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_>& b);
+              class PDAllocStrategy_,
+              class PagerType_>
+    friend bool operator <= (const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_, PagerType_>& a,
+                             const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_, PagerType_>& b);
     //////////////////////////////////////////////////
     template <class KeyType_,
               class DataType_,
               class CompareType_,
               unsigned RawNodeSize_,
               unsigned RawLeafSize_,
-              class PDAllocStrategy_>
-    friend bool operator >= (const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_>& a,
-                             const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_>& b);
+              class PDAllocStrategy_,
+              class PagerType_>
+    friend bool operator >= (const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_, PagerType_>& a,
+                             const map<KeyType_, DataType_, CompareType_, RawNodeSize_, RawLeafSize_, PDAllocStrategy_, PagerType_>& b);
     //////////////////////////////////////////////////
 };
 
@@ -419,10 +429,11 @@ template <class KeyType,
           class CompareType,
           unsigned RawNodeSize,
           unsigned RawLeafSize,
-          class PDAllocStrategy
+          class PDAllocStrategy,
+          class PagerType
           >
-inline bool operator == (const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy>& a,
-                         const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy>& b)
+inline bool operator == (const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy, PagerType>& a,
+                         const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy, PagerType>& b)
 {
     return a.impl == b.impl;
 }
@@ -432,10 +443,11 @@ template <class KeyType,
           class CompareType,
           unsigned RawNodeSize,
           unsigned RawLeafSize,
-          class PDAllocStrategy
+          class PDAllocStrategy,
+          class PagerType
           >
-inline bool operator < (const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy>& a,
-                        const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy>& b)
+inline bool operator < (const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy, PagerType>& a,
+                        const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy, PagerType>& b)
 {
     return a.impl < b.impl;
 }
@@ -445,10 +457,11 @@ template <class KeyType,
           class CompareType,
           unsigned RawNodeSize,
           unsigned RawLeafSize,
-          class PDAllocStrategy
+          class PDAllocStrategy,
+          class PagerType
           >
-inline bool operator > (const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy>& a,
-                        const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy>& b)
+inline bool operator > (const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy, PagerType>& a,
+                        const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy, PagerType>& b)
 {
     return a.impl > b.impl;
 }
@@ -458,10 +471,11 @@ template <class KeyType,
           class CompareType,
           unsigned RawNodeSize,
           unsigned RawLeafSize,
-          class PDAllocStrategy
+          class PDAllocStrategy,
+          class PagerType
           >
-inline bool operator != (const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy>& a,
-                         const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy>& b)
+inline bool operator != (const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy, PagerType>& a,
+                         const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy, PagerType>& b)
 {
     return a.impl != b.impl;
 }
@@ -471,10 +485,11 @@ template <class KeyType,
           class CompareType,
           unsigned RawNodeSize,
           unsigned RawLeafSize,
-          class PDAllocStrategy
+          class PDAllocStrategy,
+          class PagerType
           >
-inline bool operator <= (const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy>& a,
-                         const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy>& b)
+inline bool operator <= (const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy, PagerType>& a,
+                         const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy, PagerType>& b)
 {
     return a.impl <= b.impl;
 }
@@ -484,10 +499,11 @@ template <class KeyType,
           class CompareType,
           unsigned RawNodeSize,
           unsigned RawLeafSize,
-          class PDAllocStrategy
+          class PDAllocStrategy,
+          class PagerType
           >
-inline bool operator >= (const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy>& a,
-                         const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy>& b)
+inline bool operator >= (const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy, PagerType>& a,
+                         const map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy, PagerType>& b)
 {
     return a.impl >= b.impl;
 }
@@ -503,10 +519,11 @@ template <class KeyType,
           class CompareType,
           unsigned RawNodeSize,
           unsigned RawLeafSize,
-          class PDAllocStrategy
+          class PDAllocStrategy,
+          class PagerType
           >
-void swap(stxxl::map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy>& a,
-          stxxl::map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy>& b
+void swap(stxxl::map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy, PagerType>& a,
+          stxxl::map<KeyType, DataType, CompareType, RawNodeSize, RawLeafSize, PDAllocStrategy, PagerType>& b
           )
 {
     a.swap(b);
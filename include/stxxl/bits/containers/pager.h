@@ -18,7 +18,9 @@
 #include <cassert>
 #include <list>
 #include <random>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <tlx/simple_vector.hpp>
 #include <tlx/unused.hpp>
@@ -109,6 +111,467 @@ public:
     }
 };
 
+//! Pager with \b CLOCK replacement strategy (second chance), an approximation
+//! of LRU. A hit only sets the reference bit of the page, hence it is O(1)
+//! and does not touch any list.
+template <unsigned npages_ = 0>
+class clock_pager
+{
+    using size_type = size_t;
+
+    //! reference bits of the pages
+    std::vector<bool> referenced;
+    //! position of the clock hand
+    size_type hand;
+
+public:
+    static constexpr unsigned default_npages = npages_;
+
+    explicit clock_pager(size_type num_pages = default_npages)
+        : referenced(num_pages, false), hand(0) { }
+
+    //! non-copyable: delete copy-constructor
+    clock_pager(const clock_pager&) = delete;
+    //! non-copyable: delete assignment operator
+    clock_pager& operator = (const clock_pager&) = delete;
+
+    size_type kick()
+    {
+        // advance the hand, clearing reference bits, until an unreferenced
+        // page is found. terminates after at most one full turn.
+        for ( ; ; )
+        {
+            const size_type i = hand;
+            if (++hand == size()) hand = 0;
+            if (!referenced[i])
+                return i;
+            referenced[i] = false;
+        }
+    }
+
+    void hit(size_type ipage)
+    {
+        assert(ipage < size());
+        referenced[ipage] = true;
+    }
+
+    void swap(clock_pager& obj)
+    {
+        referenced.swap(obj.referenced);
+        std::swap(hand, obj.hand);
+    }
+
+    size_type size() const
+    {
+        return referenced.size();
+    }
+};
+
+//! \internal
+//! Doubly linked list of page numbers with O(1) removal, the links are kept in
+//! arrays indexed by page number. Used by the 2Q and ARC pagers.
+class pager_list
+{
+    using size_type = size_t;
+
+    static constexpr size_type nil = size_type(-1);
+
+    tlx::simple_vector<size_type> m_prev, m_next;
+    size_type m_front, m_back, m_size;
+
+public:
+    explicit pager_list(size_type num_pages = 0)
+        : m_prev(num_pages), m_next(num_pages),
+          m_front(nil), m_back(nil), m_size(0) { }
+
+    //! insert page i as the most recently used one
+    void push_front(size_type i)
+    {
+        m_prev[i] = nil;
+        m_next[i] = m_front;
+        if (m_front != nil) m_prev[m_front] = i;
+        else m_back = i;
+        m_front = i;
+        ++m_size;
+    }
+
+    //! remove page i from the list
+    void erase(size_type i)
+    {
+        assert(m_size > 0);
+        if (m_prev[i] != nil) m_next[m_prev[i]] = m_next[i];
+        else m_front = m_next[i];
+        if (m_next[i] != nil) m_prev[m_next[i]] = m_prev[i];
+        else m_back = m_prev[i];
+        --m_size;
+    }
+
+    //! the least recently used page
+    size_type back() const
+    {
+        assert(m_size > 0);
+        return m_back;
+    }
+
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    void swap(pager_list& obj)
+    {
+        m_prev.swap(obj.m_prev);
+        m_next.swap(obj.m_next);
+        std::swap(m_front, obj.m_front);
+        std::swap(m_back, obj.m_back);
+        std::swap(m_size, obj.m_size);
+    }
+};
+
+/*!
+ * Pager with (simplified) \b 2Q replacement strategy (Johnson and Shasha).
+ *
+ * Newly loaded pages enter a probationary LRU queue A1 and are promoted to
+ * the main LRU queue Am when they are hit again. Pages are evicted from A1 as
+ * long as it holds more than a quarter of all pages, hence a scan over many
+ * pages, which are used only once, does not flush the frequently used ones out
+ * of the cache.
+ *
+ * Repeated hits of the same page without a hit of another page in between are
+ * correlated references (e.g. a scan over the elements of a vector page) and
+ * do not count as reuse.
+ */
+template <unsigned npages_ = 0>
+class twoq_pager
+{
+    using size_type = size_t;
+
+    enum queue_type : unsigned char { none, a1, am };
+
+    pager_list a1_queue, am_queue;
+    tlx::simple_vector<queue_type> queue_of;
+    //! maximum size of a1_queue before its pages are preferred for eviction
+    size_type a1_target;
+    //! last page hit, used to filter correlated references
+    size_type last_hit;
+
+public:
+    static constexpr unsigned default_npages = npages_;
+
+    explicit twoq_pager(size_type num_pages = default_npages)
+        : a1_queue(num_pages), am_queue(num_pages), queue_of(num_pages),
+          a1_target(std::max<size_type>(num_pages / 4, 1)),
+          last_hit(num_pages)
+    {
+        std::fill(queue_of.begin(), queue_of.end(), none);
+    }
+
+    //! non-copyable: delete copy-constructor
+    twoq_pager(const twoq_pager&) = delete;
+    //! non-copyable: delete assignment operator
+    twoq_pager& operator = (const twoq_pager&) = delete;
+
+    size_type kick()
+    {
+        size_type i;
+        if (!a1_queue.empty() && (a1_queue.size() > a1_target || am_queue.empty())) {
+            i = a1_queue.back();
+            a1_queue.erase(i);
+        }
+        else if (!am_queue.empty()) {
+            i = am_queue.back();
+            am_queue.erase(i);
+        }
+        else {
+            // no page was hit yet
+            return 0;
+        }
+        queue_of[i] = none;
+        last_hit = size();
+        return i;
+    }
+
+    void hit(size_type ipage)
+    {
+        assert(ipage < size());
+        if (ipage == last_hit)
+            return;
+        last_hit = ipage;
+
+        switch (queue_of[ipage])
+        {
+        case none:
+            a1_queue.push_front(ipage);
+            queue_of[ipage] = a1;
+            break;
+        case a1:
+            a1_queue.erase(ipage);
+            am_queue.push_front(ipage);
+            queue_of[ipage] = am;
+            break;
+        case am:
+            am_queue.erase(ipage);
+            am_queue.push_front(ipage);
+            break;
+        }
+    }
+
+    void swap(twoq_pager& obj)
+    {
+        a1_queue.swap(obj.a1_queue);
+        am_queue.swap(obj.am_queue);
+        queue_of.swap(obj.queue_of);
+        std::swap(a1_target, obj.a1_target);
+        std::swap(last_hit, obj.last_hit);
+    }
+
+    size_type size() const
+    {
+        return queue_of.size();
+    }
+};
+
+/*!
+ * Pager with \b ARC replacement strategy (Adaptive Replacement Cache, Megiddo
+ * and Modha).
+ *
+ * Resident pages are kept in two LRU lists: T1 holds pages which were used
+ * once since they were loaded, T2 pages which were used at least twice. ARC
+ * additionally remembers the keys of recently evicted pages in the ghost
+ * lists B1 and B2 and adapts the target size of T1 whenever an evicted page
+ * is loaded again: a hit in B1 means T1 was too small, a hit in B2 means T2
+ * was too small.
+ *
+ * The keys of loaded pages are passed with load(), see pager_load(), which is
+ * called by the containers. Without keys no ghost hits can be detected and
+ * the pager does not adapt, but still evicts pages used only once first.
+ *
+ * Repeated hits of the same page without a hit of another page in between are
+ * correlated references and do not count as reuse.
+ */
+template <unsigned npages_ = 0>
+class arc_pager
+{
+    using size_type = size_t;
+    using key_type = size_t;
+
+    enum list_type : unsigned char { none, t1, t2 };
+
+    //! ghost list of keys of evicted pages with O(1) lookup
+    class ghost_list
+    {
+        using list_type = std::list<key_type>;
+
+        list_type m_list;
+        std::unordered_map<key_type, list_type::iterator> m_map;
+
+    public:
+        void push_front(const key_type& key)
+        {
+            m_map[key] = m_list.insert(m_list.begin(), key);
+        }
+
+        //! remove key, returns false if it is not contained
+        bool erase(const key_type& key)
+        {
+            auto it = m_map.find(key);
+            if (it == m_map.end())
+                return false;
+            m_list.erase(it->second);
+            m_map.erase(it);
+            return true;
+        }
+
+        void pop_back()
+        {
+            assert(!m_list.empty());
+            m_map.erase(m_list.back());
+            m_list.pop_back();
+        }
+
+        size_type size() const
+        {
+            return m_list.size();
+        }
+
+        void swap(ghost_list& obj)
+        {
+            m_list.swap(obj.m_list);
+            m_map.swap(obj.m_map);
+        }
+    };
+
+    pager_list t1_list, t2_list;
+    ghost_list b1_list, b2_list;
+    tlx::simple_vector<list_type> list_of;
+    //! keys of the resident pages
+    tlx::simple_vector<key_type> key_of;
+    //! whether key_of is valid
+    std::vector<bool> has_key;
+    //! target size of t1_list
+    size_type t1_target;
+    //! last page hit, used to filter correlated references
+    size_type last_hit;
+
+    //! remove page i from its resident list
+    void unlink(size_type i)
+    {
+        if (list_of[i] == t1)
+            t1_list.erase(i);
+        else if (list_of[i] == t2)
+            t2_list.erase(i);
+        list_of[i] = none;
+    }
+
+public:
+    static constexpr unsigned default_npages = npages_;
+
+    explicit arc_pager(size_type num_pages = default_npages)
+        : t1_list(num_pages), t2_list(num_pages),
+          list_of(num_pages), key_of(num_pages), has_key(num_pages, false),
+          t1_target(0), last_hit(num_pages)
+    {
+        std::fill(list_of.begin(), list_of.end(), none);
+    }
+
+    //! non-copyable: delete copy-constructor
+    arc_pager(const arc_pager&) = delete;
+    //! non-copyable: delete assignment operator
+    arc_pager& operator = (const arc_pager&) = delete;
+
+    size_type kick()
+    {
+        size_type i;
+        if (!t1_list.empty() && (t1_list.size() > t1_target || t2_list.empty())) {
+            i = t1_list.back();
+            if (has_key[i]) b1_list.push_front(key_of[i]);
+        }
+        else if (!t2_list.empty()) {
+            i = t2_list.back();
+            if (has_key[i]) b2_list.push_front(key_of[i]);
+        }
+        else {
+            // no page was hit yet
+            return 0;
+        }
+        unlink(i);
+        last_hit = size();
+        return i;
+    }
+
+    void hit(size_type ipage)
+    {
+        assert(ipage < size());
+        if (ipage == last_hit)
+            return;
+        last_hit = ipage;
+
+        if (list_of[ipage] == none) {
+            // the page was kicked and is used again without load(), it must
+            // not stay in the ghost lists.
+            if (has_key[ipage] &&
+                !b1_list.erase(key_of[ipage]))
+                b2_list.erase(key_of[ipage]);
+            t1_list.push_front(ipage);
+            list_of[ipage] = t1;
+        }
+        else {
+            unlink(ipage);
+            t2_list.push_front(ipage);
+            list_of[ipage] = t2;
+        }
+    }
+
+    //! Notify the pager that page ipage was loaded with the page identified by
+    //! key. The subsequent hit() of ipage is not counted as reuse.
+    void load(size_type ipage, const key_type& key)
+    {
+        assert(ipage < size());
+        unlink(ipage);
+
+        const size_type c = size();
+        const size_type b1_size = b1_list.size(), b2_size = b2_list.size();
+        if (b1_list.erase(key)) {
+            // T1 was too small: the page would still be resident
+            const size_type delta = std::max<size_type>(b2_size / b1_size, 1);
+            t1_target = std::min(t1_target + delta, c);
+            t2_list.push_front(ipage);
+            list_of[ipage] = t2;
+        }
+        else if (b2_list.erase(key)) {
+            // T2 was too small
+            const size_type delta = std::max<size_type>(b1_size / b2_size, 1);
+            t1_target = t1_target > delta ? t1_target - delta : 0;
+            t2_list.push_front(ipage);
+            list_of[ipage] = t2;
+        }
+        else {
+            t1_list.push_front(ipage);
+            list_of[ipage] = t1;
+            // limit the history to c pages for each of T1 + B1 and T2 + B2
+            while (b1_list.size() > 0 && t1_list.size() + b1_list.size() > c)
+                b1_list.pop_back();
+        }
+        while (b2_list.size() > 0 && t2_list.size() + b2_list.size() > c)
+            b2_list.pop_back();
+
+        key_of[ipage] = key;
+        has_key[ipage] = true;
+        last_hit = ipage;
+    }
+
+    void swap(arc_pager& obj)
+    {
+        t1_list.swap(obj.t1_list);
+        t2_list.swap(obj.t2_list);
+        b1_list.swap(obj.b1_list);
+        b2_list.swap(obj.b2_list);
+        list_of.swap(obj.list_of);
+        key_of.swap(obj.key_of);
+        has_key.swap(obj.has_key);
+        std::swap(t1_target, obj.t1_target);
+        std::swap(last_hit, obj.last_hit);
+    }
+
+    size_type size() const
+    {
+        return list_of.size();
+    }
+
+    //! current target size of the list of pages used once
+    size_type target_size() const
+    {
+        return t1_target;
+    }
+};
+
+//! \internal
+template <typename Pager>
+auto pager_load(Pager& pager, size_t ipage, size_t key, int)
+->decltype(pager.load(ipage, key), void())
+{
+    pager.load(ipage, key);
+}
+
+//! \internal
+template <typename Pager>
+void pager_load(Pager&, size_t, size_t, long)
+{ }
+
+//! Notify a pager that page ipage was loaded with the page identified by key,
+//! for pagers that keep a history of evicted pages (arc_pager). Call before
+//! the hit() of the loaded page. Does nothing for all other pagers.
+template <typename Pager>
+void pager_load(Pager& pager, size_t ipage, size_t key)
+{
+    pager_load(pager, ipage, key, 0);
+}
+
 //! \}
 
 } // namespace stxxl
@@ -122,6 +585,27 @@ void swap(stxxl::lru_pager<npages_>& a,
     a.swap(b);
 }
 
+template <unsigned npages_>
+void swap(stxxl::clock_pager<npages_>& a,
+          stxxl::clock_pager<npages_>& b)
+{
+    a.swap(b);
+}
+
+template <unsigned npages_>
+void swap(stxxl::twoq_pager<npages_>& a,
+          stxxl::twoq_pager<npages_>& b)
+{
+    a.swap(b);
+}
+
+template <unsigned npages_>
+void swap(stxxl::arc_pager<npages_>& a,
+          stxxl::arc_pager<npages_>& b)
+{
+    a.swap(b);
+}
+
 } // namespace std
 
 #endif // !STXXL_CONTAINERS_PAGER_HEADER
@@ -1849,6 +1849,45 @@ public:
     }
 };
 
+/*!
+ * Calls f(i) for i in [0, n) as OpenMP tasks. Unlike a parallel for, the
+ * tasks are not assigned statically: threads of the team take the next task
+ * as soon as they are idle. Inside a parallel region the tasks are spawned
+ * into the current team instead of starting a nested one. Returns after all
+ * tasks and the tasks they spawned have finished.
+ */
+template <typename Functor>
+void parallel_tasks(size_t n, const Functor& f)
+{
+#if STXXL_PARALLEL
+    const Functor* fp = &f;
+    if (omp_in_parallel())
+    {
+#pragma omp taskgroup
+        {
+            for (size_t i = 0; i < n; ++i)
+            {
+#pragma omp task firstprivate(i, fp)
+                (*fp)(i);
+            }
+        }
+        return;
+    }
+#pragma omp parallel
+#pragma omp single
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+#pragma omp task firstprivate(i, fp)
+            (*fp)(i);
+        }
+    }
+#else
+    for (size_t i = 0; i < n; ++i)
+        f(i);
+#endif
+}
+
 } // namespace ppq_local
 
 /*!
@@ -2064,6 +2103,10 @@ protected:
     //! Number of elements int the insertion heaps
     size_type m_heaps_size;
 
+    //! Number of insertion heap flushes running as tasks, see
+    //! flush_insertion_heap(), zero when a bulk push ends
+    size_t m_flushes_pending;
+
     //! Number of elements in the extract buffer
     size_type m_extract_buffer_size;
 
@@ -2367,6 +2410,7 @@ public:
           m_extract_buffer_index(0),
           // Number of elements currently in the data structures
           m_heaps_size(0),
+          m_flushes_pending(0),
           m_extract_buffer_size(0),
           m_internal_size(0),
           m_external_size(0),
@@ -2745,12 +2789,24 @@ public:
     /*!
      * Ends a sequence of push operations. Run bulk_push_begin() and some
      * bulk_push() before this.
+     *
+     * Flushes deferred by bulk_push() have finished at the barrier ending
+     * its parallel region or worksharing loop. If bulk_push_end() is called
+     * inside the parallel region, all pushes must be complete, e.g. after a
+     * barrier or by spawning the pushing tasks in a taskgroup, which also
+     * waits for the flushes they spawned.
      */
     void bulk_push_end()
     {
         assert(m_in_bulk_push);
         m_in_bulk_push = false;
 
+#if STXXL_PARALLEL
+        // wait for the flushes deferred by the calling thread's pushes
+#pragma omp taskwait
+#endif
+        assert(m_flushes_pending == 0);
+
         if (!m_is_very_large_bulk && 0)
         {
             for (size_t p = 0; p < m_num_insertion_heaps; ++p)
@@ -2763,23 +2819,20 @@ public:
         }
         else if (!m_is_very_large_bulk && 1)
         {
-#if STXXL_PARALLEL
-#pragma omp parallel for
-#endif
-            for (long p = 0; p < static_cast<long>(m_num_insertion_heaps); ++p)
-            {
-                // reestablish heap property: siftUp only those items pushed
-                for (size_t index = m_proc[p]->heap_add_size; index != 0; ) {
-                    std::push_heap(m_proc[p]->insertion_heap.begin(),
-                                   m_proc[p]->insertion_heap.end() - (--index),
-                                   m_compare);
-                }
+            ppq_local::parallel_tasks(
+                m_num_insertion_heaps, [this](size_t p) {
+                    // reestablish heap property: siftUp only those items pushed
+                    for (size_t index = m_proc[p]->heap_add_size; index != 0; ) {
+                        std::push_heap(m_proc[p]->insertion_heap.begin(),
+                                       m_proc[p]->insertion_heap.end() - (--index),
+                                       m_compare);
+                    }
 
 #if STXXL_PARALLEL
 #pragma omp atomic
 #endif
-                m_heaps_size += m_proc[p]->heap_add_size;
-            }
+                    m_heaps_size += m_proc[p]->heap_add_size;
+                });
 
             for (size_t p = 0; p < m_num_insertion_heaps; ++p)
             {
@@ -2789,36 +2842,33 @@ public:
         }
         else // m_is_very_large_bulk
         {
-#if STXXL_PARALLEL
-#pragma omp parallel for
-#endif
-            for (size_t p = 0; p < m_num_insertion_heaps; ++p)
-            {
-                if (m_proc[p]->insertion_heap.size() >= m_insertion_heap_capacity) {
-                    // flush out overfull insertion heap arrays
+            ppq_local::parallel_tasks(
+                m_num_insertion_heaps, [this](size_t p) {
+                    if (m_proc[p]->insertion_heap.size() >= m_insertion_heap_capacity) {
+                        // flush out overfull insertion heap arrays
 #if STXXL_PARALLEL
 #pragma omp atomic
 #endif
-                    m_heaps_size += m_proc[p]->heap_add_size;
+                        m_heaps_size += m_proc[p]->heap_add_size;
 
-                    m_proc[p]->heap_add_size = 0;
-                    flush_insertion_heap(p);
-                }
-                else {
-                    // reestablish heap property: siftUp only those items pushed
-                    for (size_t index = m_proc[p]->heap_add_size; index != 0; ) {
-                        std::push_heap(m_proc[p]->insertion_heap.begin(),
-                                       m_proc[p]->insertion_heap.end() - (--index),
-                                       m_compare);
+                        m_proc[p]->heap_add_size = 0;
+                        flush_insertion_heap(p);
                     }
+                    else {
+                        // reestablish heap property: siftUp only those items pushed
+                        for (size_t index = m_proc[p]->heap_add_size; index != 0; ) {
+                            std::push_heap(m_proc[p]->insertion_heap.begin(),
+                                           m_proc[p]->insertion_heap.end() - (--index),
+                                           m_compare);
+                        }
 
 #if STXXL_PARALLEL
 #pragma omp atomic
 #endif
-                    m_heaps_size += m_proc[p]->heap_add_size;
-                    m_proc[p]->heap_add_size = 0;
-                }
-            }
+                        m_heaps_size += m_proc[p]->heap_add_size;
+                        m_proc[p]->heap_add_size = 0;
+                    }
+                });
 
             for (size_t p = 0; p < m_num_insertion_heaps; ++p)
             {
@@ -3958,12 +4008,24 @@ protected:
     }
 
     //! Flushes the insertions heap p into an internal array.
+    //!
+    //! The items of the heap are handed over to a task, which sorts them and
+    //! adds them as internal array, and the caller continues with an empty
+    //! insertion heap. Inside a parallel region, e.g. in bulk_push(), the
+    //! task is deferred. Threads execute it only at task scheduling points:
+    //! usually at the taskwait of the spawning thread's next flush, at the
+    //! latest at the barrier ending the region or worksharing loop. Hence
+    //! each thread has at most one deferred flush, it runs or waits for the
+    //! previous one before starting another.
     inline void flush_insertion_heap(size_t p)
     {
         assert(m_proc[p]->insertion_heap.size() != 0);
 
+#if STXXL_PARALLEL
+#pragma omp taskwait
+#endif
+
         heap_type& insheap = m_proc[p]->insertion_heap;
-        size_t size = insheap.size();
 
         TLX_LOG0 <<
             "Flushing insertion heap array p=" << p <<
@@ -3972,11 +4034,43 @@ protected:
             " int_memory=" << internal_array_type::int_memory(insheap.size()) <<
             " mem_left=" << m_mem_left;
 
-        m_stats.num_insertion_heap_flushes++;
+#if STXXL_PARALLEL
+#pragma omp critical(stxxl_flush_insertion_heap)
+#endif
+        {
+            // invalidate player in minima tree (before adding the IA to tree)
+            m_minima.deactivate_heap(p);
+        }
+
+        heap_type* values = new heap_type;
+        values->swap(insheap);
+
+        // reserve new insertion heap
+        insheap.reserve(m_insertion_heap_capacity);
+        assert(insheap.capacity() * sizeof(value_type)
+               == insertion_heap_int_memory());
+
+#if STXXL_PARALLEL
+#pragma omp atomic
+#endif
+        ++m_flushes_pending;
+
+#if STXXL_PARALLEL
+#pragma omp task if (omp_in_parallel()) firstprivate(values)
+#endif
+        flush_insertion_heap_values(values);
+    }
+
+    //! Sorts the items of a flushed insertion heap and adds them as internal
+    //! array, runs as task of flush_insertion_heap().
+    void flush_insertion_heap_values(heap_type* values)
+    {
+        const size_t size = values->size();
+
         stats_timer flush_time(true); // separate timer due to parallel sorting
 
         // sort locally, independent of others
-        std::sort(insheap.begin(), insheap.end(), m_inv_compare);
+        std::sort(values->begin(), values->end(), m_inv_compare);
 
 #if STXXL_PARALLEL
 #pragma omp critical(stxxl_flush_insertion_heap)
@@ -3985,27 +4079,27 @@ protected:
             // test that enough RAM is available for merged internal array:
             // otherwise flush the existing internal arrays out to disk.
             flush_ia_ea_until_memory_free(
-                internal_array_type::int_memory(insheap.size()));
-
-            // invalidate player in minima tree (before adding the IA to tree)
-            m_minima.deactivate_heap(p);
-
-            // insheap is empty afterwards, as vector was swapped into new_array
-            add_as_internal_array(insheap);
+                internal_array_type::int_memory(size));
 
-            // reserve new insertion heap
-            insheap.reserve(m_insertion_heap_capacity);
-            assert(insheap.capacity() * sizeof(value_type)
-                   == insertion_heap_int_memory());
+            // values is empty afterwards, as vector was swapped into new_array
+            add_as_internal_array(*values);
 
             // update item counts
 #if STXXL_PARALLEL
 #pragma omp atomic
 #endif
             m_heaps_size -= size;
+
+            m_stats.num_insertion_heap_flushes++;
+            m_stats.insertion_heap_flush_time += flush_time;
         }
 
-        m_stats.insertion_heap_flush_time += flush_time;
+        delete values;
+
+#if STXXL_PARALLEL
+#pragma omp atomic
+#endif
+        --m_flushes_pending;
     }
 
     //! Flushes all insertions heaps into an internal array.
@@ -4028,24 +4122,18 @@ protected:
         m_stats.insertion_heap_flush_time.start();
 
         size_type size = m_heaps_size;
-        size_type int_memory = 0;
         assert(size > 0);
         std::vector<std::pair<value_iterator, value_iterator> > sequences(m_num_insertion_heaps);
 
-#if STXXL_PARALLEL
-        #pragma omp parallel for
-#endif
-        for (long i = 0; i < static_cast<long>(m_num_insertion_heaps); ++i)
-        {
-            heap_type& insheap = m_proc[i]->insertion_heap;
-
-            std::sort(insheap.begin(), insheap.end(), m_inv_compare);
+        ppq_local::parallel_tasks(
+            m_num_insertion_heaps, [this, &sequences](size_t i) {
+                heap_type& insheap = m_proc[i]->insertion_heap;
 
-            if (c_merge_sorted_heaps)
-                sequences[i] = std::make_pair(insheap.begin(), insheap.end());
+                std::sort(insheap.begin(), insheap.end(), m_inv_compare);
 
-            int_memory += insheap.capacity();
-        }
+                if (c_merge_sorted_heaps)
+                    sequences[i] = std::make_pair(insheap.begin(), insheap.end());
+            });
 
         if (c_merge_sorted_heaps)
         {
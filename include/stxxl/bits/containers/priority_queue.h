@@ -26,12 +26,15 @@
 #include <utility>
 #include <vector>
 
+#include <tlx/define.hpp>
 #include <tlx/logger/core.hpp>
 
+#include <stxxl/bits/containers/pager.h>
 #include <stxxl/bits/containers/pq_ext_merger.h>
 #include <stxxl/bits/containers/pq_helpers.h>
 #include <stxxl/bits/containers/pq_int_merger.h>
 #include <stxxl/bits/containers/pq_mergers.h>
+#include <stxxl/bits/containers/vector.h>
 
 namespace stxxl {
 
@@ -278,6 +281,83 @@ public:
         insert_heap.push(obj);
     }
 
+    //! Removes up to max_size "largest" elements and appends them to out in
+    //! the order in which top() would return them.
+    //!
+    //! The insert heap is moved into the sequence heap first, then the
+    //! elements are merged directly from the group buffers in batches of up
+    //! to N elements instead of kDeleteBufferSize. Refilling the group
+    //! buffers and merging them use the parallel multiway merge if
+    //! STXXL_PARALLEL is enabled. \return number of elements removed
+    size_t bulk_pop(std::vector<value_type>& out, size_t max_size)
+    {
+        TLX_LOG << "priority_queue::bulk_pop(" << max_size << ")";
+
+        max_size = static_cast<size_t>(
+            std::min(static_cast<size_type>(max_size), size()));
+        if (max_size == 0)
+            return 0;
+
+        if (insert_heap.size() > 1)
+            empty_insert_heap();
+
+        out.reserve(out.size() + max_size);
+
+        // the delete buffer holds the smallest elements
+        size_t rest = max_size;
+        size_t length = std::min(rest, current_delete_buffer_size());
+        out.insert(out.end(), delete_buffer_current_min,
+                   delete_buffer_current_min + length);
+        delete_buffer_current_min += length;
+        rest -= length;
+
+        priority_queue_local::invert_order<typename Config::comparator_type, value_type, value_type> inv_cmp(cmp);
+
+        std::pair<value_type*, value_type*> seqs[kTotalNumGroups];
+        size_t group_index[kTotalNumGroups];
+
+        while (rest > 0)
+        {
+            // afterwards each group buffer holds N elements or its whole group
+            size_t num_seqs = 0;
+            size_type total_group_size = 0;
+            for (size_t i = num_active_groups; i > 0; )
+            {
+                --i;
+                const size_type group_length = refill_group_buffer(i);
+                if (group_length == 0 && i == num_active_groups - 1)
+                    --num_active_groups;
+                if (group_length == 0)
+                    continue;
+
+                total_group_size += group_length;
+                seqs[num_seqs] = std::make_pair(group_buffer_current_mins[i], group_buffers[i] + N);
+                group_index[num_seqs++] = i;
+            }
+
+            length = static_cast<size_t>(
+                std::min(static_cast<size_type>(std::min<size_t>(rest, N)), total_group_size));
+            assert(length > 0);
+
+            const size_t pos = out.size();
+            out.resize(pos + length);
+            potentially_parallel::multiway_merge_sentinels(
+                seqs, seqs + num_seqs, out.data() + pos, length, inv_cmp);
+            // sequence iterators are progressed appropriately
+
+            for (size_t j = 0; j < num_seqs; ++j)
+                group_buffer_current_mins[group_index[j]] = seqs[j].first;
+
+            size_ -= size_type(length);
+            rest -= length;
+        }
+
+        if (delete_buffer_current_min == delete_buffer_end)
+            refill_delete_buffer();
+
+        return max_size;
+    }
+
     //! \}
 
     //! \name Miscellaneous
@@ -686,12 +766,15 @@ private:
     void empty_insert_heap()
     {
         TLX_LOG << "empty_insert_heap()";
-        assert(insert_heap.size() == (N + 1));
+        assert(insert_heap.size() > 1 && insert_heap.size() <= (N + 1));
 
         const value_type sup = get_supremum();
 
+        // number of inserted elements, usually N unless called by bulk_pop()
+        const size_t num_inserted = insert_heap.size() - 1;
+
         // build new segment
-        value_type* newSegment = new value_type[N + 1];
+        value_type* newSegment = new value_type[num_inserted + 1];
         value_type* newPos = newSegment;
 
         // put the new data there for now
@@ -700,13 +783,13 @@ private:
 
         insert_heap.sort_to(SortTo);
 
-        SortTo = newSegment + N;
+        SortTo = newSegment + num_inserted;
         insert_heap.clear();
         insert_heap.push(*SortTo);
 
         assert(insert_heap.size() == 1);
 
-        newSegment[N] = sup; // sentinel
+        newSegment[num_inserted] = sup; // sentinel
 
         // copy the delete_buffer and group_buffers[0] to temporary storage
         // (the temporary can be eliminated using some dirty tricks)
@@ -737,12 +820,12 @@ private:
         // note that merge exactly trips into the footsteps
         // of itself
         priority_queue_local::merge2_iterator(pos, newPos,
-                                              newSegment, newSegment + N, cmp);
+                                              newSegment, newSegment + num_inserted, cmp);
 
         // and insert it
         const size_t freeLevel = make_space_available(0);
         assert(freeLevel == 0 || int_mergers[0].size() == 0);
-        int_mergers[0].append_array(newSegment, N);
+        int_mergers[0].append_array(newSegment, num_inserted);
 
         // get rid of invalid level 2 buffers
         // by inserting them into tree 0 (which is almost empty in this case)
@@ -761,7 +844,7 @@ private:
         }
 
         // update size
-        size_ += size_type(N);
+        size_ += size_type(num_inserted);
 
         // special case if the tree was empty before
         if (delete_buffer_current_min == delete_buffer_end)
@@ -971,6 +1054,503 @@ public:
     using result = priority_queue<priority_queue_config<ValueType, CompareTypeWithMin, Buffer1Size, N, AI, 2, B, AE, 2> >;
 };
 
+//! A priority queue that migrates from internal memory to external when its
+//! size exceeds a certain threshold, and optionally back when it shrinks
+//! again. While the queue is internal, it is a binary heap in a std::vector
+//! and neither the external priority queue nor its pools are constructed.
+//!
+//! For semantics of the methods see documentation of stxxl::priority_queue.
+//! \tparam ExternalPQ type of the external priority queue, e.g. the result
+//! of PRIORITY_QUEUE_GENERATOR
+//! \tparam CritSize number of elements at which the queue migrates to
+//! external memory
+template <class ExternalPQ, size_t CritSize>
+class migrating_priority_queue
+{
+    static constexpr bool debug = false;
+
+public:
+    using ext_pq_type = ExternalPQ;
+    using value_type = typename ext_pq_type::value_type;
+    using comparator_type = typename ext_pq_type::comparator_type;
+    using size_type = typename ext_pq_type::size_type;
+    using pool_type = typename ext_pq_type::pool_type;
+
+private:
+    enum { critical_size = CritSize };
+
+    comparator_type cmp;
+
+    //! binary heap while internal, with the largest element at the front
+    std::vector<value_type> heap;
+    ext_pq_type* ext_impl;
+
+    //! shared pool for the external queue or nullptr
+    pool_type* pool;
+    //! pool sizes for the external queue if there is no shared pool
+    size_t p_pool_mem, w_pool_mem;
+
+    //! size at which the external queue migrates back, 0 for never
+    size_t demote_size;
+
+public:
+    //! \name Constructors/Destructors
+    //! \{
+
+    //! Constructs an empty priority queue. After migration the external
+    //! queue uses the given pool, which may be shared by many queues.
+    explicit migrating_priority_queue(pool_type& pool_, const comparator_type& comp_ = comparator_type())
+        : cmp(comp_), ext_impl(nullptr), pool(&pool_),
+          p_pool_mem(0), w_pool_mem(0), demote_size(0)
+    { }
+
+    //! Constructs an empty priority queue. After migration the external
+    //! queue uses its own pools of the given sizes in bytes.
+    migrating_priority_queue(const size_t p_pool_mem_, const size_t w_pool_mem_,
+                             const comparator_type& comp_ = comparator_type())
+        : cmp(comp_), ext_impl(nullptr), pool(nullptr),
+          p_pool_mem(p_pool_mem_), w_pool_mem(w_pool_mem_), demote_size(0)
+    { }
+
+    //! non-copyable: delete copy-constructor
+    migrating_priority_queue(const migrating_priority_queue&) = delete;
+    //! non-copyable: delete assignment operator
+    migrating_priority_queue& operator = (const migrating_priority_queue&) = delete;
+
+    ~migrating_priority_queue()
+    {
+        delete ext_impl;
+    }
+
+    //! \}
+
+    //! \name Miscellaneous
+    //! \{
+
+    //! Returns true if current implementation is internal, otherwise false.
+    bool internal() const
+    {
+        return (ext_impl == nullptr);
+    }
+    //! Returns true if current implementation is external, otherwise false.
+    bool external() const
+    {
+        return (ext_impl != nullptr);
+    }
+
+    //! Lets the external queue migrate back to internal memory when pop()
+    //! shrinks it to new_size elements, 0 disables migrating back. The size
+    //! should be well below CritSize to avoid migrating back and forth.
+    void set_demote_size(size_t new_size)
+    {
+        assert(new_size < critical_size);
+        demote_size = new_size;
+    }
+
+    //! \}
+
+    //! \name Capacity
+    //! \{
+
+    //! Returns number of elements contained.
+    size_type size() const
+    {
+        return (ext_impl) ? ext_impl->size() : size_type(heap.size());
+    }
+
+    //! Returns true if queue has no elements.
+    bool empty() const { return (size() == 0); }
+
+    //! \}
+
+    //! \name Operators
+    //! \{
+
+    //! Returns "largest" element. Precondition: \c empty() is false.
+    const value_type & top() const
+    {
+        assert(!empty());
+        return (ext_impl) ? ext_impl->top() : heap.front();
+    }
+
+    //! \}
+
+    //! \name Modifiers
+    //! \{
+
+    //! Removes the element at the top. Precondition: \c empty() is false.
+    void pop()
+    {
+        assert(!empty());
+        if (!ext_impl)
+        {
+            std::pop_heap(heap.begin(), heap.end(), cmp);
+            heap.pop_back();
+        }
+        else
+        {
+            ext_impl->pop();
+            if (TLX_UNLIKELY(ext_impl->size() == demote_size && demote_size != 0))
+                demote();
+        }
+    }
+
+    //! Inserts x into the priority_queue.
+    void push(const value_type& obj)
+    {
+        if (!ext_impl)
+        {
+            heap.push_back(obj);
+            std::push_heap(heap.begin(), heap.end(), cmp);
+            if (TLX_UNLIKELY(heap.size() == critical_size))
+                promote();
+        }
+        else
+            ext_impl->push(obj);
+    }
+
+    //! \}
+
+private:
+    //! migrate to the external priority queue
+    void promote()
+    {
+        TLX_LOG << "migrating_priority_queue[" << this << "]: promote at " << heap.size();
+        ext_impl = pool ? new ext_pq_type(*pool, cmp)
+                   : new ext_pq_type(p_pool_mem, w_pool_mem, cmp);
+        for (const value_type& v : heap)
+            ext_impl->push(v);
+        std::vector<value_type>().swap(heap);
+    }
+
+    //! migrate back to the internal heap. The elements are popped in
+    //! descending order, which is a valid heap already.
+    void demote()
+    {
+        TLX_LOG << "migrating_priority_queue[" << this << "]: demote at " << ext_impl->size();
+        heap.reserve(ext_impl->size());
+        while (!ext_impl->empty())
+        {
+            heap.push_back(ext_impl->top());
+            ext_impl->pop();
+        }
+        delete ext_impl;
+        ext_impl = nullptr;
+    }
+};
+
+namespace priority_queue_local {
+
+//! Interface of the configurations of a dynamic_priority_queue.
+template <class ValueType, class CompareTypeWithMin>
+class dynamic_pq_base
+{
+public:
+    using value_type = ValueType;
+    using size_type = external_size_type;
+
+    virtual ~dynamic_pq_base() { }
+
+    virtual size_type size() const = 0;
+    virtual const value_type & top() const = 0;
+    virtual void pop() = 0;
+    virtual void push(const value_type& obj) = 0;
+    virtual size_t mem_cons() const = 0;
+};
+
+//! A priority_queue generated for IntMemory bytes of internal memory and up
+//! to MaxItems * 1024 elements, see PRIORITY_QUEUE_GENERATOR.
+template <class ValueType, class CompareTypeWithMin, size_t IntMemory,
+          external_size_type MaxItems>
+class dynamic_pq_config : public dynamic_pq_base<ValueType, CompareTypeWithMin>
+{
+public:
+    using value_type = ValueType;
+    using size_type = external_size_type;
+
+    using pq_type = typename PRIORITY_QUEUE_GENERATOR<
+              ValueType, CompareTypeWithMin, IntMemory, MaxItems>::result;
+
+    dynamic_pq_config(const size_t p_pool_mem, const size_t w_pool_mem,
+                      const CompareTypeWithMin& cmp)
+        : pq(p_pool_mem, w_pool_mem, cmp)
+    { }
+
+    size_type size() const final { return pq.size(); }
+    const value_type & top() const final { return pq.top(); }
+    void pop() final { pq.pop(); }
+    void push(const value_type& obj) final { pq.push(obj); }
+    size_t mem_cons() const final { return pq.mem_cons(); }
+
+private:
+    pq_type pq;
+};
+
+} // namespace priority_queue_local
+
+//! A priority queue whose parameters are chosen at runtime from its memory
+//! budget and expected size, instead of at compile time via
+//! PRIORITY_QUEUE_GENERATOR.
+//!
+//! The parameters of the sequence heap (insertion buffer, group buffers,
+//! merger arities and block size) are array bounds and template arguments of
+//! stxxl::priority_queue. Hence this queue instantiates a ladder of
+//! configurations for 16 MiB to 8 GiB of internal memory, each generated for
+//! the external volume of MaxItems, but at most 2048 times its memory, and
+//! uses the smallest one whose memory is at least a quarter of the expected
+//! size. A configuration takes twice its memory: the other half holds the
+//! prefetch and write pools and three blocks of an external vector used for
+//! growing. The rest of the budget is left unused. When the queue exceeds 4
+//! times the memory of its configuration, it moves its elements into the next
+//! larger configuration that fits into the budget, which has larger buffers
+//! and merger arities. The elements are moved through an external vector,
+//! hence the two configurations are never allocated at the same time.
+//! Without a larger configuration, the queue keeps using the current one up
+//! to the volume it was generated for, a push beyond throws.
+//!
+//! For semantics of the methods see documentation of stxxl::priority_queue.
+//! \tparam ValueType type of the contained objects (POD with no references to internal memory)
+//! \tparam CompareTypeWithMin comparator with min_value(), see PRIORITY_QUEUE_GENERATOR
+//! \tparam MaxItems upper limit for number of elements contained in the
+//! priority queue (in 1024 units), i.e. the external volume it must hold, see
+//! PRIORITY_QUEUE_GENERATOR
+template <class ValueType, class CompareTypeWithMin, external_size_type MaxItems>
+class dynamic_priority_queue
+{
+    static constexpr bool debug = false;
+
+public:
+    using value_type = ValueType;
+    using comparator_type = CompareTypeWithMin;
+    using size_type = external_size_type;
+
+    //! number of configurations
+    static constexpr size_t num_configs = 4;
+
+private:
+    using base_type = priority_queue_local::dynamic_pq_base<value_type, comparator_type>;
+
+    template <size_t IntMemory, external_size_type ConfigItems>
+    using config_type = priority_queue_local::dynamic_pq_config<
+              value_type, comparator_type, IntMemory, ConfigItems>;
+
+    comparator_type cmp;
+
+    //! total memory budget in bytes
+    size_t m_memory;
+
+    //! index of the current configuration
+    size_t m_config;
+
+    //! the current configuration
+    base_type* m_impl;
+
+    //! external vector holding the elements while the queue grows
+    using drain_vector_type = stxxl::vector<value_type, 1, stxxl::lru_pager<1> >;
+
+    //! number of buffers of the drain vector's writer and reader
+    static constexpr size_t drain_buffers = 2;
+
+    //! internal memory reserved for growing: the drain vector's page and
+    //! the buffers of its writer or reader
+    static constexpr size_t drain_memory =
+        (1 + drain_buffers) * drain_vector_type::block_type::raw_size;
+
+    //! internal memory of configuration i in bytes
+    static constexpr size_t config_memory(size_t i)
+    {
+        return (size_t(16) * 1024 * 1024) << (3 * i);
+    }
+
+    //! number of elements configuration i is generated for, in units of
+    //! 1024. Larger values exceed the template instantiation depth of
+    //! PRIORITY_QUEUE_GENERATOR for small memory.
+    static constexpr external_size_type config_items(size_t i)
+    {
+        return std::min<external_size_type>(
+            MaxItems, 2048 * external_size_type(config_memory(i)) / sizeof(value_type) / 1024);
+    }
+
+    //! capacity of configuration i in elements
+    static size_type config_capacity(size_t i)
+    {
+        return config_items(i) * 1024;
+    }
+
+    //! size from which the queue moves to the next configuration, if the
+    //! budget allows it
+    static size_type grow_size(size_t i)
+    {
+        return 4 * size_type(config_memory(i)) / sizeof(value_type);
+    }
+
+    //! memory of each of the prefetch and write pools of configuration i
+    static constexpr size_t pool_memory(size_t i)
+    {
+        return (config_memory(i) - drain_memory) / 2;
+    }
+
+    //! construct configuration i with its pools
+    base_type * create(size_t i) const
+    {
+        TLX_LOG << "dynamic_priority_queue[" << this << "]: configuration " << i
+                << " with " << config_memory(i) << " bytes and pools of "
+                << pool_memory(i) << " bytes";
+        switch (i)
+        {
+        case 0:
+            return new config_type<config_memory(0), config_items(0)>(
+                pool_memory(0), pool_memory(0), cmp);
+        case 1:
+            return new config_type<config_memory(1), config_items(1)>(
+                pool_memory(1), pool_memory(1), cmp);
+        case 2:
+            return new config_type<config_memory(2), config_items(2)>(
+                pool_memory(2), pool_memory(2), cmp);
+        default:
+            return new config_type<config_memory(3), config_items(3)>(
+                pool_memory(3), pool_memory(3), cmp);
+        }
+    }
+
+    //! whether the budget allows the configuration after the current one
+    bool can_grow() const
+    {
+        return m_config + 1 < num_configs &&
+               2 * config_memory(m_config + 1) <= m_memory;
+    }
+
+    //! move all elements into the next larger configuration, draining them
+    //! in sorted order into an external vector and destroying the current
+    //! configuration before constructing the next one
+    void grow()
+    {
+        TLX_LOG << "dynamic_priority_queue[" << this << "]: grow at " << m_impl->size();
+        drain_vector_type drain(m_impl->size());
+        {
+            typename drain_vector_type::bufwriter_type writer(drain, drain_buffers);
+            while (m_impl->size() != 0)
+            {
+                writer << m_impl->top();
+                m_impl->pop();
+            }
+            writer.finish();
+        }
+
+        delete m_impl;
+        m_impl = nullptr;       // in case create() throws
+        m_impl = create(++m_config);
+
+        typename drain_vector_type::bufreader_type reader(drain, drain_buffers);
+        for ( ; !reader.empty(); ++reader)
+            m_impl->push(*reader);
+    }
+
+public:
+    //! \name Constructors/Destructors
+    //! \{
+
+    //! Constructs an empty priority queue.
+    //! \param memory internal memory budget in bytes including the pools, at
+    //! least 32 MiB
+    //! \param expected_size expected maximum number of elements, 0 for
+    //! starting with the smallest configuration
+    explicit dynamic_priority_queue(
+        const size_t memory, const size_type expected_size = 0,
+        const comparator_type& comp_ = comparator_type())
+        : cmp(comp_), m_memory(memory), m_config(0)
+    {
+        if (m_memory < 2 * config_memory(0))
+            throw foxxll::bad_parameter(
+                      "dynamic_priority_queue: the memory budget must be at least 32 MiB");
+
+        while (grow_size(m_config) < expected_size && can_grow())
+            ++m_config;
+
+        m_impl = create(m_config);
+    }
+
+    //! non-copyable: delete copy-constructor
+    dynamic_priority_queue(const dynamic_priority_queue&) = delete;
+    //! non-copyable: delete assignment operator
+    dynamic_priority_queue& operator = (const dynamic_priority_queue&) = delete;
+
+    ~dynamic_priority_queue()
+    {
+        delete m_impl;
+    }
+
+    //! \}
+
+    //! \name Capacity
+    //! \{
+
+    //! Returns number of elements contained.
+    size_type size() const { return m_impl->size(); }
+
+    //! Returns true if queue has no elements.
+    bool empty() const { return (size() == 0); }
+
+    //! \}
+
+    //! \name Operators
+    //! \{
+
+    //! Returns "largest" element. Precondition: \c empty() is false.
+    const value_type & top() const
+    {
+        return m_impl->top();
+    }
+
+    //! \}
+
+    //! \name Modifiers
+    //! \{
+
+    //! Removes the element at the top. Precondition: \c empty() is false.
+    void pop()
+    {
+        m_impl->pop();
+    }
+
+    //! Inserts x into the priority_queue. Throws if the queue holds
+    //! MaxItems * 1024 elements, or the capacity of the largest configuration
+    //! fitting the memory budget.
+    void push(const value_type& obj)
+    {
+        if (TLX_UNLIKELY(m_impl->size() >= grow_size(m_config)) && can_grow())
+            grow();
+
+        if (TLX_UNLIKELY(m_impl->size() >= config_capacity(m_config)))
+        {
+            FOXXLL_THROW2(std::runtime_error, "dynamic_priority_queue<...>::push()",
+                          "Overflow! The capacity of " << config_capacity(m_config) <<
+                          " elements is reached, which is limited by MaxItems and the" <<
+                          " memory budget of " << m_memory << " bytes");
+        }
+
+        m_impl->push(obj);
+    }
+
+    //! \}
+
+    //! \name Miscellaneous
+    //! \{
+
+    //! Index of the current configuration.
+    size_t config() const { return m_config; }
+
+    //! Internal memory of the current configuration in bytes, not including
+    //! the pools.
+    size_t config_mem() const { return config_memory(m_config); }
+
+    //! Number of bytes consumed by the current configuration from the
+    //! internal memory not including pools.
+    size_t mem_cons() const { return m_impl->mem_cons(); }
+
+    //! \}
+};
+
 //! \}
 
 } // namespace stxxl
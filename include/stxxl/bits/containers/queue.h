@@ -23,6 +23,7 @@
 #include <tlx/define.hpp>
 #include <tlx/logger/core.hpp>
 
+#include <foxxll/common/timer.hpp>
 #include <foxxll/common/tmeta.hpp>
 #include <foxxll/mng/block_manager.hpp>
 #include <foxxll/mng/prefetch_pool.hpp>
@@ -30,6 +31,9 @@
 #include <foxxll/mng/typed_block.hpp>
 #include <foxxll/mng/write_pool.hpp>
 
+#include <stxxl/bits/common/adaptive_prefetch.h>
+#include <stxxl/bits/common/manifest.h>
+#include <stxxl/bits/common/span.h>
 #include <stxxl/bits/defines.h>
 #include <stxxl/bits/deprecated.h>
 #include <stxxl/types>
@@ -65,10 +69,9 @@ public:
 
     using block_type = foxxll::typed_block<block_size, value_type>;
     using bid_type = foxxll::BID<block_size>;
-
-private:
     using pool_type = foxxll::read_write_pool<block_type>;
 
+private:
     size_type m_size;
     bool delete_pool;
     pool_type* pool;
@@ -81,6 +84,10 @@ private:
     std::deque<bid_type> bids;
     foxxll::block_manager* bm;
     size_t blocks2prefetch;
+    //! controller of blocks2prefetch or nullptr
+    adaptive_prefetch* adaptive;
+    //! data file of a manifest the queue was opened from
+    foxxll::file_ptr file;
 
 public:
     //! \name Constructors/Destructors
@@ -166,6 +173,8 @@ public:
         std::swap(bids, obj.bids);
         std::swap(bm, obj.bm);
         std::swap(blocks2prefetch, obj.blocks2prefetch);
+        std::swap(adaptive, obj.adaptive);
+        std::swap(file, obj.file);
     }
 
     //! \}
@@ -190,6 +199,7 @@ private:
         front_block = back_block = pool->steal();
         back_element = back_block->begin() - 1;
         front_element = back_block->begin();
+        adaptive = nullptr;
         set_prefetch_aggr(blocks2prefetch_);
     }
 
@@ -203,6 +213,8 @@ public:
     //!                          a negative value means to use the number of blocks in the prefetch pool
     void set_prefetch_aggr(int blocks2prefetch_)
     {
+        delete adaptive;
+        adaptive = nullptr;
         if (blocks2prefetch_ < 0)
             blocks2prefetch = pool->size_prefetch();
         else
@@ -214,8 +226,38 @@ public:
     {
         return blocks2prefetch;
     }
+
+    //! Lets the number of blocks to prefetch adapt to the stalls of pop() on
+    //! pending reads, until the next call of set_prefetch_aggr().
+    //! \param budget  prefetch blocks shared with other containers using the
+    //!                same pool, the depth then starts at one block. Default
+    //!                is a private limit of all blocks in the prefetch pool.
+    void set_adaptive_prefetch(prefetch_budget* budget = nullptr)
+    {
+        delete adaptive;
+        adaptive = budget ? new adaptive_prefetch(*budget)
+                   : new adaptive_prefetch(pool->size_prefetch(), blocks2prefetch);
+        blocks2prefetch = adaptive->depth();
+    }
     //! \}
 
+private:
+    //! wait for the read of the front block and report it to the
+    //! prefetch controller
+    void wait_for_read(const foxxll::request_ptr& req)
+    {
+        if (!adaptive) {
+            req->wait();
+            return;
+        }
+        const bool stalled = !req->poll();
+        const double start = foxxll::timestamp();
+        req->wait();
+        if (adaptive->on_read(stalled, foxxll::timestamp() - start))
+            blocks2prefetch = adaptive->depth();
+    }
+
+public:
     //! \name Modifiers
     //! \{
 
@@ -323,9 +365,9 @@ public:
             }
 
             front_element = front_block->begin();
-            req->wait();
+            wait_for_read(req);
 
-            bm->delete_block(bids.front());
+            delete_blocks_except(file, bids.begin(), bids.begin() + 1);
             bids.pop_front();
             return;
         }
@@ -335,6 +377,92 @@ public:
     }
     //! \}
 
+    //! \name Bulk Operations
+    //! \{
+
+    //! Appends n elements. The elements are copied blockwise, only block
+    //! boundaries take the path of push().
+    void push_bulk(const value_type* data, size_t n)
+    {
+        while (n > 0)
+        {
+            const size_t room = back_block->end() - 1 - back_element;
+            if (room == 0) {
+                push(*data++);
+                --n;
+                continue;
+            }
+
+            const size_t k = std::min(room, n);
+            std::copy(data, data + k, back_element + 1);
+            data += k, n -= k;
+            back_element += k;
+            m_size += k;
+        }
+    }
+
+    //! Appends all elements of a stream.
+    template <typename StreamAlgorithm>
+    void push_bulk(StreamAlgorithm& in)
+    {
+        while (!in.empty())
+        {
+            const size_t room = back_block->end() - 1 - back_element;
+            if (room == 0) {
+                push(*in);
+                ++in;
+                continue;
+            }
+
+            size_t k = 0;
+            for ( ; k < room && !in.empty(); ++k, ++in)
+                back_element[k + 1] = *in;
+            back_element += k;
+            m_size += k;
+        }
+    }
+
+    //! Removes n elements and copies them into out in FIFO order. If out is
+    //! nullptr, the elements are discarded, e.g. after processing them via
+    //! front_span().
+    void pop_bulk(value_type* out, size_t n)
+    {
+        assert(n <= m_size);
+        while (n > 0)
+        {
+            // elements of the front block, except the last one which pop()
+            // removes together with the block
+            const value_type* last = (front_block == back_block)
+                                     ? back_element : front_block->end() - 1;
+            const size_t k = std::min<size_t>(n, last - front_element);
+            if (k == 0) {
+                if (out) *out++ = front();
+                pop();
+                --n;
+                continue;
+            }
+
+            if (out)
+                out = std::copy(front_element, front_element + k, out);
+            n -= k;
+            front_element += k;
+            m_size -= k;
+        }
+    }
+
+    //! Returns the elements of the front block in place, starting with
+    //! front().
+    span<value_type> front_span()
+    {
+        if (empty())
+            return span<value_type>();
+        value_type* last = (front_block == back_block)
+                           ? back_element : front_block->end() - 1;
+        return span<value_type>(front_element, last - front_element + 1);
+    }
+
+    //! \}
+
     //! \name Operators
     //! \{
 
@@ -368,6 +496,59 @@ public:
 
     //! \}
 
+    //! \name Persistence
+    //! \{
+
+    //! Saves the queue to the data file of a manifest, see stxxl::manifest.
+    //! The queue is not changed, its external blocks are copied.
+    void save(manifest& m)
+    {
+        m.start_save("queue", block_type::raw_size);
+        m.append(*front_block);
+        block_type* tmp = pool->steal();
+        for (size_t i = 0; i < bids.size(); ++i)
+        {
+            // read via the pool, which may still hold the block for writing
+            pool->read(tmp, bids[i])->wait();
+            m.append(*tmp);
+        }
+        pool->add(tmp);
+        if (back_block != front_block)
+            m.append(*back_block);
+        m.set("size", m_size);
+        m.set("front", front_element - front_block->begin());
+        m.set("back", back_element - back_block->begin() + 1);
+        m.finish_save();
+    }
+
+    //! Opens a queue saved to a manifest. The queue must be empty. The
+    //! external blocks are read in place from the data file and are not
+    //! deleted by pop().
+    void open(manifest& m)
+    {
+        assert(empty());
+        file = m.start_open("queue", block_type::raw_size);
+        const size_t n = m.num_blocks();
+
+        m.read_block(0, *front_block);
+        for (size_t i = 1; i + 1 < n; ++i)
+            bids.push_back(m.template bid<bid_type>(i));
+        if (n >= 2) {
+            back_block = pool->steal();
+            m.read_block(n - 1, *back_block);
+        }
+
+        m_size = m.get("size");
+        front_element = front_block->begin() + m.get("front");
+        back_element = back_block->begin() + m.get("back") - 1;
+        m.finish_open();
+
+        for (size_t i = 0; i < blocks2prefetch && i < bids.size(); ++i)
+            pool->hint(bids[i]);
+    }
+
+    //! \}
+
     //! \name Constructors/Destructors
     //! \{
 
@@ -382,8 +563,10 @@ public:
             delete pool;
         }
 
+        delete adaptive;
+
         if (!bids.empty())
-            bm->delete_blocks(bids.begin(), bids.end());
+            delete_blocks_except(file, bids.begin(), bids.end());
     }
 
     //! \}
@@ -406,6 +589,222 @@ public:
     //! \}
 };
 
+//! A queue that migrates from internal memory to external when its size
+//! exceeds a certain threshold, and optionally back when it shrinks again.
+//! While the queue is internal, no blocks are allocated and no pool is
+//! constructed.
+//!
+//! For semantics of the methods see documentation of the STL \c std::queue.
+//! \tparam ValueType type of the contained objects (POD with no references to internal memory)
+//! \tparam CritSize number of elements at which the queue migrates to external memory
+//! \tparam ExternalQueue type of the external queue, default is \c stxxl::queue<ValueType>
+//! \tparam InternalQueue type of the internal queue, default is \c std::deque<ValueType>
+template <class ValueType, size_t CritSize,
+          class ExternalQueue = queue<ValueType>,
+          class InternalQueue = std::deque<ValueType> >
+class migrating_queue
+{
+    static constexpr bool debug = false;
+
+public:
+    using value_type = ValueType;
+    using size_type = typename ExternalQueue::size_type;
+    using pool_type = typename ExternalQueue::pool_type;
+
+    using int_queue_type = InternalQueue;
+    using ext_queue_type = ExternalQueue;
+
+private:
+    enum { critical_size = CritSize };
+
+    int_queue_type* int_impl;
+    ext_queue_type* ext_impl;
+
+    //! shared pool for the external queue or nullptr
+    pool_type* pool;
+
+    //! size at which the external queue migrates back, 0 for never
+    size_t demote_size;
+
+public:
+    //! \name Constructors/Destructors
+    //! \{
+
+    //! Constructs an empty queue. After migration the external queue uses
+    //! its own pool.
+    migrating_queue()
+        : int_impl(new int_queue_type()), ext_impl(nullptr),
+          pool(nullptr), demote_size(0)
+    { }
+
+    //! Constructs an empty queue. After migration the external queue uses the
+    //! given pool, which may be shared by many queues.
+    explicit migrating_queue(pool_type& pool_)
+        : int_impl(new int_queue_type()), ext_impl(nullptr),
+          pool(&pool_), demote_size(0)
+    { }
+
+    //! non-copyable: delete copy-constructor
+    migrating_queue(const migrating_queue&) = delete;
+    //! non-copyable: delete assignment operator
+    migrating_queue& operator = (const migrating_queue&) = delete;
+
+    ~migrating_queue()
+    {
+        delete int_impl;
+        delete ext_impl;
+    }
+
+    //! \}
+
+    //! \name Modifiers
+    //! \{
+
+    void swap(migrating_queue& obj)
+    {
+        std::swap(int_impl, obj.int_impl);
+        std::swap(ext_impl, obj.ext_impl);
+        std::swap(pool, obj.pool);
+        std::swap(demote_size, obj.demote_size);
+    }
+
+    //! \}
+
+    //! \name Miscellaneous
+    //! \{
+
+    //! Returns true if current implementation is internal, otherwise false.
+    bool internal() const
+    {
+        assert((int_impl && !ext_impl) || (!int_impl && ext_impl));
+        return (int_impl != nullptr);
+    }
+    //! Returns true if current implementation is external, otherwise false.
+    bool external() const
+    {
+        assert((int_impl && !ext_impl) || (!int_impl && ext_impl));
+        return (ext_impl != nullptr);
+    }
+
+    //! Lets the external queue migrate back to internal memory when pop()
+    //! shrinks it to new_size elements, 0 disables migrating back. The size
+    //! should be well below CritSize to avoid migrating back and forth.
+    void set_demote_size(size_t new_size)
+    {
+        assert(new_size < critical_size);
+        demote_size = new_size;
+    }
+
+    //! \}
+
+    //! \name Capacity
+    //! \{
+
+    //! Returns true if the queue is empty.
+    bool empty() const
+    {
+        assert((int_impl && !ext_impl) || (!int_impl && ext_impl));
+        return (int_impl) ? int_impl->empty() : ext_impl->empty();
+    }
+    //! Returns the number of elements contained in the queue.
+    size_type size() const
+    {
+        assert((int_impl && !ext_impl) || (!int_impl && ext_impl));
+        return (int_impl) ? size_type(int_impl->size()) : ext_impl->size();
+    }
+
+    //! \}
+
+    //! \name Accessor Functions
+    //! \{
+
+    //! Returns a mutable reference at the front of the queue.
+    value_type & front()
+    {
+        assert(!empty());
+        return (int_impl) ? int_impl->front() : ext_impl->front();
+    }
+    //! Returns a const reference at the front of the queue.
+    const value_type & front() const
+    {
+        assert(!empty());
+        return (int_impl) ? int_impl->front() : ext_impl->front();
+    }
+    //! Returns a mutable reference at the back of the queue.
+    value_type & back()
+    {
+        assert(!empty());
+        return (int_impl) ? int_impl->back() : ext_impl->back();
+    }
+    //! Returns a const reference at the back of the queue.
+    const value_type & back() const
+    {
+        assert(!empty());
+        return (int_impl) ? int_impl->back() : ext_impl->back();
+    }
+
+    //! Adds an element in the queue.
+    void push(const value_type& val)
+    {
+        assert((int_impl && !ext_impl) || (!int_impl && ext_impl));
+
+        if (int_impl)
+        {
+            int_impl->push_back(val);
+            if (TLX_UNLIKELY(int_impl->size() == critical_size))
+                promote();
+        }
+        else
+            ext_impl->push(val);
+    }
+
+    //! Removes element from the queue.
+    void pop()
+    {
+        assert((int_impl && !ext_impl) || (!int_impl && ext_impl));
+
+        if (int_impl)
+        {
+            int_impl->pop_front();
+        }
+        else
+        {
+            ext_impl->pop();
+            if (TLX_UNLIKELY(ext_impl->size() == demote_size && demote_size != 0))
+                demote();
+        }
+    }
+
+    //! \}
+
+private:
+    //! migrate to the external queue
+    void promote()
+    {
+        TLX_LOG << "migrating_queue[" << this << "]: promote at " << int_impl->size();
+        ext_impl = pool ? new ext_queue_type(*pool) : new ext_queue_type();
+        for (const value_type& v : *int_impl)
+            ext_impl->push(v);
+        delete int_impl;
+        int_impl = nullptr;
+    }
+
+    //! migrate back to the internal queue, blockwise from the front
+    void demote()
+    {
+        TLX_LOG << "migrating_queue[" << this << "]: demote at " << ext_impl->size();
+        int_impl = new int_queue_type();
+        while (!ext_impl->empty())
+        {
+            span<value_type> s = ext_impl->front_span();
+            int_impl->insert(int_impl->end(), s.begin(), s.end());
+            ext_impl->pop_bulk(nullptr, s.size());
+        }
+        delete ext_impl;
+        ext_impl = nullptr;
+    }
+};
+
 //! \}
 
 } // namespace stxxl
@@ -0,0 +1,240 @@
+/***************************************************************************
+ *  include/stxxl/bits/containers/radix_heap.h
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#ifndef STXXL_CONTAINERS_RADIX_HEAP_HEADER
+#define STXXL_CONTAINERS_RADIX_HEAP_HEADER
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include <tlx/logger/core.hpp>
+#include <tlx/math/clz.hpp>
+
+#include <foxxll/mng/config.hpp>
+
+#include <stxxl/bits/containers/queue.h>
+#include <stxxl/bits/defines.h>
+#include <stxxl/types>
+
+namespace stxxl {
+
+//! \addtogroup stlcont
+//! \{
+
+/*!
+ * External radix heap: a monotone priority queue for unsigned integer keys,
+ * i.e. pushed keys must not be smaller than the last key returned by top().
+ *
+ * An item with key k is kept in bucket i, where i - 1 is the highest bit in
+ * which k differs from the last key returned by top(), or bucket 0 if k equals
+ * it. Each bucket is an external stxxl::queue whose back block buffers
+ * pushes in memory, all queues share one block pool. When bucket 0 runs
+ * empty, the smallest non-empty bucket is scanned once and its items are
+ * redistributed to lower buckets relative to its minimum, which becomes the
+ * new last key. Each item moves to lower buckets only, hence is
+ * redistributed at most log2(C) times where C is the largest difference of
+ * keys in the heap, and all I/O is sequential.
+ *
+ * Memory consumption is two blocks per bucket used so far plus the prefetch
+ * and write blocks of the pool.
+ *
+ * \tparam KeyType unsigned integer type of the keys
+ * \tparam DataType type of the data stored with each key (POD with no references to internal memory)
+ * \tparam BlockSize size of the external memory block in bytes, default is \c STXXL_DEFAULT_BLOCK_SIZE
+ * \tparam AllocStr parallel disk block allocation strategy, default is \c foxxll::default_alloc_strategy
+ */
+template <class KeyType, class DataType,
+          size_t BlockSize = STXXL_DEFAULT_BLOCK_SIZE(KeyType),
+          class AllocStr = foxxll::default_alloc_strategy>
+class radix_heap
+{
+    static constexpr bool debug = false;
+
+    static_assert(std::is_unsigned<KeyType>::value && sizeof(KeyType) <= sizeof(uint64_t),
+                  "radix_heap requires unsigned integer keys of at most 64 bits");
+
+public:
+    using key_type = KeyType;
+    using data_type = DataType;
+    using value_type = std::pair<key_type, data_type>;
+    using size_type = external_size_type;
+    using queue_type = queue<value_type, BlockSize, AllocStr>;
+    using pool_type = typename queue_type::pool_type;
+
+    //! number of buckets, one per bit of the keys and bucket 0
+    static constexpr size_t num_buckets = std::numeric_limits<key_type>::digits + 1;
+
+private:
+    //! pool shared by the bucket queues
+    pool_type m_pool;
+
+    //! bucket queues, created when they are used first
+    std::array<queue_type*, num_buckets> m_buckets;
+
+    //! smallest key in each non-empty bucket
+    std::array<key_type, num_buckets> m_min;
+
+    //! last key returned by top(), the key of all items in bucket 0
+    key_type m_last;
+
+    //! number of items
+    size_type m_size;
+
+    //! bucket of key relative to m_last
+    size_t bucket_index(const key_type& key) const
+    {
+        const uint64_t diff = static_cast<uint64_t>(key ^ m_last);
+        return (diff == 0) ? 0 : 64 - tlx::clz(diff);
+    }
+
+    //! get bucket i, creating its queue on first use
+    queue_type& bucket(size_t i)
+    {
+        if (TLX_UNLIKELY(m_buckets[i] == nullptr))
+        {
+            TLX_LOG << "radix_heap[" << this << "]: create bucket " << i;
+            // each queue keeps its front and back block out of the pool
+            m_pool.resize_write(m_pool.size_write() + 2);
+            m_buckets[i] = new queue_type(m_pool);
+        }
+        return *m_buckets[i];
+    }
+
+    //! append an item to bucket i
+    void insert(size_t i, const value_type& v)
+    {
+        queue_type& q = bucket(i);
+        if (q.empty() || v.first < m_min[i])
+            m_min[i] = v.first;
+        q.push(v);
+    }
+
+    //! fill bucket 0 by redistributing the smallest non-empty bucket
+    void refill()
+    {
+        if (m_buckets[0] != nullptr && !m_buckets[0]->empty())
+            return;
+
+        size_t i = 1;
+        while (m_buckets[i] == nullptr || m_buckets[i]->empty())
+            ++i;
+        assert(i < num_buckets);
+
+        m_last = m_min[i];
+        TLX_LOG << "radix_heap[" << this << "]: redistribute bucket " << i
+                << " with " << m_buckets[i]->size() << " items, last = " << m_last;
+
+        queue_type& q = *m_buckets[i];
+        while (!q.empty())
+        {
+            span<value_type> s = q.front_span();
+            for (const value_type& v : s)
+                insert(bucket_index(v.first), v);
+            q.pop_bulk(nullptr, s.size());
+        }
+    }
+
+public:
+    //! \name Constructors/Destructors
+    //! \{
+
+    //! Constructs an empty heap.
+    //! \param prefetch_blocks number of blocks read ahead by the bucket being
+    //! redistributed, default is D
+    //! \param write_blocks number of blocks for buffered writing shared by all
+    //! buckets, default is 2 * D
+    explicit radix_heap(size_t prefetch_blocks = 0, size_t write_blocks = 0)
+        : m_pool(prefetch_blocks ? prefetch_blocks
+                 : foxxll::config::get_instance()->disks_number(),
+                 write_blocks ? write_blocks
+                 : 2 * foxxll::config::get_instance()->disks_number()),
+          m_last(0), m_size(0)
+    {
+        m_buckets.fill(nullptr);
+    }
+
+    //! non-copyable: delete copy-constructor
+    radix_heap(const radix_heap&) = delete;
+    //! non-copyable: delete assignment operator
+    radix_heap& operator = (const radix_heap&) = delete;
+
+    ~radix_heap()
+    {
+        for (queue_type* q : m_buckets)
+            delete q;
+    }
+
+    //! \}
+
+    //! \name Capacity
+    //! \{
+
+    //! Returns the number of items.
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    //! Returns true if the heap has no items.
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    //! \}
+
+    //! \name Operators
+    //! \{
+
+    //! Returns the item with the smallest key. Precondition: \c empty() is
+    //! false.
+    const value_type & top()
+    {
+        assert(!empty());
+        refill();
+        return m_buckets[0]->front();
+    }
+
+    //! \}
+
+    //! \name Modifiers
+    //! \{
+
+    //! Inserts an item. The key must not be smaller than the last key
+    //! returned by top().
+    void push(const key_type& key, const data_type& data)
+    {
+        assert(key >= m_last);
+        insert(bucket_index(key), value_type(key, data));
+        ++m_size;
+    }
+
+    //! Removes the item with the smallest key. Precondition: \c empty() is
+    //! false.
+    void pop()
+    {
+        assert(!empty());
+        refill();
+        m_buckets[0]->pop();
+        --m_size;
+    }
+
+    //! \}
+};
+
+//! \}
+
+} // namespace stxxl
+
+#endif // !STXXL_CONTAINERS_RADIX_HEAP_HEADER
@@ -22,6 +22,7 @@
 #include <tlx/define.hpp>
 #include <tlx/logger/core.hpp>
 
+#include <foxxll/common/timer.hpp>
 #include <foxxll/common/tmeta.hpp>
 #include <foxxll/mng/block_manager.hpp>
 #include <foxxll/mng/prefetch_pool.hpp>
@@ -29,6 +30,9 @@
 #include <foxxll/mng/typed_block.hpp>
 #include <foxxll/mng/write_pool.hpp>
 
+#include <stxxl/bits/common/adaptive_prefetch.h>
+#include <stxxl/bits/common/manifest.h>
+#include <stxxl/bits/common/span.h>
 #include <stxxl/bits/defines.h>
 #include <stxxl/bits/deprecated.h>
 #include <stxxl/types>
@@ -119,6 +123,12 @@ private:
     /// number of blocks to prefetch
     size_t m_blocks2prefetch;
 
+    /// controller of m_blocks2prefetch or nullptr
+    adaptive_prefetch* m_adaptive;
+
+    /// data file of a manifest the sequence was opened from
+    foxxll::file_ptr m_file;
+
 public:
     //! \name Constructors/Destructors
     //! \{
@@ -201,6 +211,8 @@ public:
         std::swap(m_bids, obj.m_bids);
         std::swap(m_bm, obj.m_bm);
         std::swap(m_blocks2prefetch, obj.m_blocks2prefetch);
+        std::swap(m_adaptive, obj.m_adaptive);
+        std::swap(m_file, obj.m_file);
     }
 
     //! \}
@@ -226,9 +238,25 @@ private:
         m_front_block = m_back_block = m_pool->steal();
         m_back_element = m_back_block->begin() - 1;
         m_front_element = m_back_block->begin();
+        m_adaptive = nullptr;
         set_prefetch_aggr(blocks2prefetch);
     }
 
+    /// wait for the read of a front or back block and report it to the
+    /// prefetch controller
+    void wait_for_read(const foxxll::request_ptr& req)
+    {
+        if (!m_adaptive) {
+            req->wait();
+            return;
+        }
+        const bool stalled = !req->poll();
+        const double start = foxxll::timestamp();
+        req->wait();
+        if (m_adaptive->on_read(stalled, foxxll::timestamp() - start))
+            m_blocks2prefetch = m_adaptive->depth();
+    }
+
 public:
     //! \name Miscellaneous
     //! \{
@@ -239,6 +267,8 @@ public:
     //!                         a negative value means to use the number of blocks in the prefetch pool
     void set_prefetch_aggr(int blocks2prefetch)
     {
+        delete m_adaptive;
+        m_adaptive = nullptr;
         if (blocks2prefetch < 0)
             m_blocks2prefetch = m_pool->size_prefetch();
         else
@@ -251,6 +281,20 @@ public:
         return m_blocks2prefetch;
     }
 
+    //! Lets the number of blocks to prefetch adapt to the stalls of
+    //! pop_front() and pop_back() on pending reads, until the next call of
+    //! set_prefetch_aggr().
+    //! \param budget  prefetch blocks shared with other containers using the
+    //!                same pool, the depth then starts at one block. Default
+    //!                is a private limit of all blocks in the prefetch pool.
+    void set_adaptive_prefetch(prefetch_budget* budget = nullptr)
+    {
+        delete m_adaptive;
+        m_adaptive = budget ? new adaptive_prefetch(*budget)
+                     : new adaptive_prefetch(m_pool->size_prefetch(), m_blocks2prefetch);
+        m_blocks2prefetch = m_adaptive->depth();
+    }
+
     //! \}
 
     //! \name Modifiers
@@ -433,9 +477,9 @@ public:
             }
 
             m_front_element = m_front_block->begin();
-            req->wait();
+            wait_for_read(req);
 
-            m_bm->delete_block(m_bids.front());
+            delete_blocks_except(m_file, m_bids.begin(), m_bids.begin() + 1);
             m_bids.pop_front();
         }
         else
@@ -492,9 +536,9 @@ public:
             }
 
             m_back_element = m_back_block->end() - 1;
-            req->wait();
+            wait_for_read(req);
 
-            m_bm->delete_block(m_bids.back());
+            delete_blocks_except(m_file, m_bids.end() - 1, m_bids.end());
             m_bids.pop_back();
         }
         else
@@ -506,6 +550,130 @@ public:
 
     //! \}
 
+    //! \name Bulk Operations
+    //! \{
+
+    //! Appends n elements at the back. The elements are copied blockwise, only
+    //! block boundaries take the path of push_back().
+    void push_back_bulk(const value_type* data, size_t n)
+    {
+        while (n > 0)
+        {
+            const size_t room = m_back_block->end() - 1 - m_back_element;
+            if (room == 0) {
+                push_back(*data++);
+                --n;
+                continue;
+            }
+
+            const size_t k = std::min(room, n);
+            std::copy(data, data + k, m_back_element + 1);
+            data += k, n -= k;
+            m_back_element += k;
+            m_size += k;
+        }
+    }
+
+    //! Appends all elements of a stream at the back.
+    template <typename StreamAlgorithm>
+    void push_back_bulk(StreamAlgorithm& in)
+    {
+        while (!in.empty())
+        {
+            const size_t room = m_back_block->end() - 1 - m_back_element;
+            if (room == 0) {
+                push_back(*in);
+                ++in;
+                continue;
+            }
+
+            size_t k = 0;
+            for ( ; k < room && !in.empty(); ++k, ++in)
+                m_back_element[k + 1] = *in;
+            m_back_element += k;
+            m_size += k;
+        }
+    }
+
+    //! Removes n elements from the front and copies them into out in order. If
+    //! out is nullptr, the elements are discarded, e.g. after processing them
+    //! via front_span().
+    void pop_front_bulk(value_type* out, size_t n)
+    {
+        assert(n <= m_size);
+        while (n > 0)
+        {
+            // elements of the front block, except the last one which
+            // pop_front() removes together with the block
+            const value_type* last = (m_front_block == m_back_block)
+                                     ? m_back_element : m_front_block->end() - 1;
+            const size_t k = std::min<size_t>(n, last - m_front_element);
+            if (k == 0) {
+                if (out) *out++ = front();
+                pop_front();
+                --n;
+                continue;
+            }
+
+            if (out)
+                out = std::copy(m_front_element, m_front_element + k, out);
+            n -= k;
+            m_front_element += k;
+            m_size -= k;
+        }
+    }
+
+    //! Removes n elements from the back and copies them into out in the order
+    //! of popping, i.e. out[0] is the former back(). If out is nullptr, the
+    //! elements are discarded, e.g. after processing them via back_span().
+    void pop_back_bulk(value_type* out, size_t n)
+    {
+        assert(n <= m_size);
+        while (n > 0)
+        {
+            // elements of the back block, except the first one which
+            // pop_back() removes together with the block
+            const value_type* first = (m_front_block == m_back_block)
+                                      ? m_front_element : m_back_block->begin();
+            const size_t k = std::min<size_t>(n, m_back_element - first);
+            if (k == 0) {
+                if (out) *out++ = back();
+                pop_back();
+                --n;
+                continue;
+            }
+
+            if (out)
+                out = std::reverse_copy(m_back_element - k + 1, m_back_element + 1, out);
+            n -= k;
+            m_back_element -= k;
+            m_size -= k;
+        }
+    }
+
+    //! Returns the elements of the front block in place, starting with
+    //! front().
+    span<value_type> front_span()
+    {
+        if (empty())
+            return span<value_type>();
+        value_type* last = (m_front_block == m_back_block)
+                           ? m_back_element : m_front_block->end() - 1;
+        return span<value_type>(m_front_element, last - m_front_element + 1);
+    }
+
+    //! Returns the elements of the back block in place, ending with back().
+    span<value_type> back_span()
+    {
+        if (empty())
+            return span<value_type>();
+        value_type* first = (m_front_block == m_back_block)
+                            ? m_front_element : m_back_block->begin();
+        return span<value_type>(first, m_back_element - first + 1);
+    }
+
+    //! \}
+
     //! \name Capacity
     //! \{
 
@@ -556,6 +724,59 @@ public:
 
     //! \}
 
+    //! \name Persistence
+    //! \{
+
+    //! Saves the sequence to the data file of a manifest, see stxxl::manifest.
+    //! The sequence is not changed, its external blocks are copied.
+    void save(manifest& m)
+    {
+        m.start_save("sequence", block_type::raw_size);
+        m.append(*m_front_block);
+        block_type* tmp = m_pool->steal();
+        for (size_t i = 0; i < m_bids.size(); ++i)
+        {
+            // read via the pool, which may still hold the block for writing
+            m_pool->read(tmp, m_bids[i])->wait();
+            m.append(*tmp);
+        }
+        m_pool->add(tmp);
+        if (m_back_block != m_front_block)
+            m.append(*m_back_block);
+        m.set("size", m_size);
+        m.set("front", m_front_element - m_front_block->begin());
+        m.set("back", m_back_element - m_back_block->begin() + 1);
+        m.finish_save();
+    }
+
+    //! Opens a sequence saved to a manifest. The sequence must be empty. The
+    //! external blocks are read in place from the data file and are not
+    //! deleted by pop_front() and pop_back().
+    void open(manifest& m)
+    {
+        assert(empty());
+        m_file = m.start_open("sequence", block_type::raw_size);
+        const size_t n = m.num_blocks();
+
+        m.read_block(0, *m_front_block);
+        for (size_t i = 1; i + 1 < n; ++i)
+            m_bids.push_back(m.template bid<bid_type>(i));
+        if (n >= 2) {
+            m_back_block = m_pool->steal();
+            m.read_block(n - 1, *m_back_block);
+        }
+
+        m_size = m.get("size");
+        m_front_element = m_front_block->begin() + m.get("front");
+        m_back_element = m_back_block->begin() + m.get("back") - 1;
+        m.finish_open();
+
+        for (size_t i = 0; i < m_blocks2prefetch && i < m_bids.size(); ++i)
+            m_pool->hint(m_bids[i]);
+    }
+
+    //! \}
+
     //! \name Constructors/Destructors
     //! \{
 
@@ -569,8 +790,10 @@ public:
         if (m_owns_pool)
             delete m_pool;
 
+        delete m_adaptive;
+
         if (!m_bids.empty())
-            m_bm->delete_blocks(m_bids.begin(), m_bids.end());
+            delete_blocks_except(m_file, m_bids.begin(), m_bids.end());
     }
 
     //! \}
@@ -24,6 +24,7 @@
 #include <tlx/simple_vector.hpp>
 
 #include <foxxll/common/error_handling.hpp>
+#include <foxxll/common/timer.hpp>
 #include <foxxll/common/tmeta.hpp>
 #include <foxxll/io/request_operations.hpp>
 #include <foxxll/mng/block_manager.hpp>
@@ -32,6 +33,9 @@
 #include <foxxll/mng/typed_block.hpp>
 #include <foxxll/mng/write_pool.hpp>
 
+#include <stxxl/bits/common/adaptive_prefetch.h>
+#include <stxxl/bits/common/manifest.h>
+#include <stxxl/bits/common/span.h>
 #include <stxxl/bits/defines.h>
 #include <stxxl/bits/deprecated.h>
 #include <stxxl/types>
@@ -95,6 +99,8 @@ private:
     typename tlx::simple_vector<block_type>::iterator back_page;
     std::vector<bid_type> bids;
     alloc_strategy_type alloc_strategy;
+    //! data file of a stack reopened by open()
+    foxxll::file_ptr file;
 
 public:
     //! \name Constructors/Destructors
@@ -126,6 +132,7 @@ public:
         std::swap(back_page, obj.back_page);
         std::swap(bids, obj.bids);
         std::swap(alloc_strategy, obj.alloc_strategy);
+        std::swap(file, obj.file);
     }
 
     //! \}
@@ -169,11 +176,52 @@ public:
 
     virtual ~normal_stack()
     {
-        foxxll::block_manager::get_instance()->delete_blocks(bids.begin(), bids.end());
+        delete_blocks_except(file, bids.begin(), bids.end());
     }
 
     //! \}
 
+    //! \name Persistence
+    //! \{
+
+    //! Saves the stack to the data file of a manifest, see stxxl::manifest.
+    //! The stack is not changed, its external blocks are copied.
+    void save(manifest& m)
+    {
+        m.start_save("normal_stack", block_type::raw_size);
+        m.template append<block_type>(bids.begin(), bids.end());
+        for (size_t i = 0; i < blocks_per_page; ++i)
+            m.append(*(back_page + i));
+        for (size_t i = 0; i < blocks_per_page; ++i)
+            m.append(*(front_page + i));
+        m.set("size", m_size);
+        m.set("cache_offset", cache_offset);
+        m.finish_save();
+    }
+
+    //! Opens a stack saved to a manifest. The stack must be empty. The
+    //! external blocks are read in place from the data file and are not
+    //! deleted by pop().
+    void open(manifest& m)
+    {
+        assert(empty() && bids.empty());
+        file = m.start_open("normal_stack", block_type::raw_size);
+        const size_t ext = m.num_blocks() - 2 * blocks_per_page;
+
+        for (size_t i = 0; i < ext; ++i)
+            bids.push_back(m.template bid<bid_type>(i));
+        for (size_t i = 0; i < blocks_per_page; ++i)
+            m.read_block(ext + i, *(back_page + i));
+        for (size_t i = 0; i < blocks_per_page; ++i)
+            m.read_block(ext + blocks_per_page + i, *(front_page + i));
+
+        m_size = m.get("size");
+        cache_offset = m.get("cache_offset");
+        if (cache_offset > 0)
+            current_element = element(cache_offset - 1);
+        m.finish_open();
+    }
+
     //! \name Capacity
     //! \{
 
@@ -283,7 +331,7 @@ public:
 
             wait_all(requests.begin(), blocks_per_page);
 
-            foxxll::block_manager::get_instance()->delete_blocks(bids.end() - blocks_per_page, bids.end());
+            delete_blocks_except(file, bids.end() - blocks_per_page, bids.end());
             bids.resize(bids.size() - blocks_per_page);
 
             return;
@@ -296,6 +344,76 @@ public:
 
     //! \}
 
+    //! \name Bulk Operations
+    //! \{
+
+    //! Pushes n elements, data[n-1] becomes the top. The elements are copied
+    //! blockwise, only block boundaries take the path of push().
+    void push_bulk(const value_type* data, size_t n)
+    {
+        while (n > 0)
+        {
+            const size_t room = (cache_offset == 2 * blocks_per_page * block_type::size)
+                                ? 0 : block_type::size - cache_offset % block_type::size;
+            if (room == 0) {
+                push(*data++);
+                --n;
+                continue;
+            }
+
+            const size_t k = std::min(room, n);
+            std::copy(data, data + k, element(cache_offset));
+            data += k, n -= k;
+            cache_offset += k;
+            m_size += k;
+            current_element = element(cache_offset - 1);
+        }
+    }
+
+    //! Pops n elements into out in the order of popping, i.e. out[0] is the
+    //! former top. If out is nullptr, the elements are discarded, e.g. after
+    //! processing them via top_span().
+    void pop_bulk(value_type* out, size_t n)
+    {
+        assert(n <= m_size);
+        while (n > 0)
+        {
+            // elements of the top block, except the last one if pop() has
+            // to read a page
+            size_t k = std::min(n, (cache_offset - 1) % block_type::size + 1);
+            if (k == cache_offset && bids.size() >= blocks_per_page)
+                --k;
+            if (k == 0) {
+                if (out) *out++ = top();
+                pop();
+                --n;
+                continue;
+            }
+
+            if (out) {
+                value_type* first = element(cache_offset - k);
+                out = std::reverse_copy(first, first + k, out);
+            }
+            n -= k;
+            cache_offset -= k;
+            m_size -= k;
+            if (cache_offset > 0)
+                current_element = element(cache_offset - 1);
+        }
+    }
+
+    //! Returns the elements of the top block in place, the top is the last
+    //! one.
+    span<value_type> top_span()
+    {
+        if (m_size == 0 || cache_offset == 0)
+            return span<value_type>();
+        const size_t k = (cache_offset - 1) % block_type::size + 1;
+        return span<value_type>(element(cache_offset - k), k);
+    }
+
+    //! \}
+
 private:
     value_type * element(const size_t offset)
     {
@@ -553,6 +671,82 @@ public:
     }
 
     //! \}
+
+    //! \name Bulk Operations
+    //! \{
+
+    //! Pushes n elements, data[n-1] becomes the top. The elements are copied
+    //! blockwise, only block boundaries take the path of push().
+    void push_bulk(const value_type* data, size_t n)
+    {
+        while (n > 0)
+        {
+            const size_t room = (cache_offset == blocks_per_page * block_type::size)
+                                ? 0 : block_type::size - cache_offset % block_type::size;
+            if (room == 0) {
+                push(*data++);
+                --n;
+                continue;
+            }
+
+            const size_t k = std::min(room, n);
+            std::copy(data, data + k, element(cache_offset));
+            data += k, n -= k;
+            cache_offset += k;
+            m_size += k;
+            current_element = element(cache_offset - 1);
+        }
+    }
+
+    //! Pops n elements into out in the order of popping, i.e. out[0] is the
+    //! former top. If out is nullptr, the elements are discarded, e.g. after
+    //! processing them via top_span().
+    void pop_bulk(value_type* out, size_t n)
+    {
+        assert(n <= m_size);
+        while (n > 0)
+        {
+            // elements of the top block, except the last one if pop() has
+            // to switch pages
+            size_t k = std::min(n, (cache_offset - 1) % block_type::size + 1);
+            if (k == cache_offset && bids.size() >= blocks_per_page)
+                --k;
+            if (k == 0) {
+                if (out) *out++ = top();
+                pop();
+                --n;
+                continue;
+            }
+
+            if (out) {
+                value_type* first = element(cache_offset - k);
+                out = std::reverse_copy(first, first + k, out);
+            }
+            n -= k;
+            cache_offset -= k;
+            m_size -= k;
+            if (cache_offset > 0)
+                current_element = element(cache_offset - 1);
+        }
+    }
+
+    //! Returns the elements of the top block in place, the top is the last
+    //! one.
+    span<value_type> top_span()
+    {
+        if (m_size == 0 || cache_offset == 0)
+            return span<value_type>();
+        const size_t k = (cache_offset - 1) % block_type::size + 1;
+        return span<value_type>(element(cache_offset - k), k);
+    }
+
+    //! \}
+
+private:
+    value_type * element(const size_t offset)
+    {
+        return &((*(cache_buffers + offset / block_type::size))[offset % block_type::size]);
+    }
 };
 
 //! Efficient implementation that uses prefetching and overlapping using (shared) buffers pools.
@@ -587,6 +781,8 @@ private:
     std::vector<bid_type> bids;
     alloc_strategy_type alloc_strategy;
     size_t pref_aggr;
+    //! controller of pref_aggr or nullptr
+    adaptive_prefetch* adaptive;
     pool_type* owned_pool;
     pool_type* pool;
 
@@ -604,6 +800,7 @@ public:
           cache_offset(0),
           cache(new block_type),
           pref_aggr(prefetch_aggressiveness),
+          adaptive(nullptr),
           owned_pool(nullptr),
           pool(&pool_)
     {
@@ -628,6 +825,7 @@ public:
         std::swap(bids, obj.bids);
         std::swap(alloc_strategy, obj.alloc_strategy);
         std::swap(pref_aggr, obj.pref_aggr);
+        std::swap(adaptive, obj.adaptive);
         std::swap(owned_pool, obj.owned_pool);
         std::swap(pool, obj.pool);
     }
@@ -667,6 +865,7 @@ public:
         catch (const foxxll::io_error&)
         { }
         foxxll::block_manager::get_instance()->delete_blocks(bids.begin(), bids.end());
+        delete adaptive;
         delete owned_pool;
     }
 
@@ -760,9 +959,22 @@ public:
 
             bid_type last_block = bids.back();
             bids.pop_back();
-            pool->read(cache, last_block)->wait();
-            foxxll::block_manager::get_instance()->delete_block(last_block);
-            rehint();
+            foxxll::request_ptr req = pool->read(cache, last_block);
+            if (adaptive) {
+                const bool stalled = !req->poll();
+                const double start = foxxll::timestamp();
+                req->wait();
+                foxxll::block_manager::get_instance()->delete_block(last_block);
+                if (adaptive->on_read(stalled, foxxll::timestamp() - start))
+                    change_prefetch_aggr(adaptive->depth());
+                else
+                    rehint();
+            }
+            else {
+                req->wait();
+                foxxll::block_manager::get_instance()->delete_block(last_block);
+                rehint();
+            }
             cache_offset = block_type::size + 1;
         }
 
@@ -772,6 +984,70 @@ public:
 
     //! \}
 
+    //! \name Bulk Operations
+    //! \{
+
+    //! Pushes n elements, data[n-1] becomes the top. The elements are copied
+    //! blockwise, only block boundaries take the path of push().
+    void push_bulk(const value_type* data, size_t n)
+    {
+        while (n > 0)
+        {
+            if (cache_offset == block_type::size) {
+                push(*data++);
+                --n;
+                continue;
+            }
+
+            const size_t k = std::min(block_type::size - cache_offset, n);
+            std::copy(data, data + k, cache->begin() + cache_offset);
+            data += k, n -= k;
+            cache_offset += k;
+            m_size += k;
+        }
+    }
+
+    //! Pops n elements into out in the order of popping, i.e. out[0] is the
+    //! former top. If out is nullptr, the elements are discarded, e.g. after
+    //! processing them via top_span().
+    void pop_bulk(value_type* out, size_t n)
+    {
+        assert(n <= m_size);
+        while (n > 0)
+        {
+            // elements of the block, except the last one if pop() has to
+            // read the next block
+            size_t k = std::min(n, cache_offset);
+            if (k == cache_offset && !bids.empty())
+                --k;
+            if (k == 0) {
+                if (out) *out++ = top();
+                pop();
+                --n;
+                continue;
+            }
+
+            if (out) {
+                value_type* first = cache->begin() + (cache_offset - k);
+                out = std::reverse_copy(first, first + k, out);
+            }
+            n -= k;
+            cache_offset -= k;
+            m_size -= k;
+        }
+    }
+
+    //! Returns the elements of the top block in place, the top is the last
+    //! one.
+    span<value_type> top_span()
+    {
+        if (m_size == 0)
+            return span<value_type>();
+        return span<value_type>(cache->begin(), cache_offset);
+    }
+
+    //! \}
+
     //! \name Miscellaneous
     //! \{
 
@@ -779,6 +1055,36 @@ public:
     //! prefetch pool used for prefetching).
     //! \param new_p new value for the prefetch aggressiveness
     void set_prefetch_aggr(const size_t new_p)
+    {
+        delete adaptive;
+        adaptive = nullptr;
+        change_prefetch_aggr(new_p);
+    }
+
+    //! Returns number of blocks used for prefetching.
+    const size_t & get_prefetch_aggr() const
+    {
+        return pref_aggr;
+    }
+
+    //! Lets the prefetch aggressiveness adapt to the stalls of pop() on
+    //! pending reads, until the next call of set_prefetch_aggr().
+    //! \param budget prefetch blocks shared with other containers using the
+    //! same pool, the aggressiveness then starts at one block. Default is a
+    //! private limit of all blocks in the prefetch pool.
+    void set_adaptive_prefetch(prefetch_budget* budget = nullptr)
+    {
+        delete adaptive;
+        adaptive = budget ? new adaptive_prefetch(*budget)
+                   : new adaptive_prefetch(pool->size_prefetch(), pref_aggr);
+        change_prefetch_aggr(adaptive->depth());
+    }
+
+    //! \}
+
+private:
+    //! change the prefetch aggressiveness and update the hints
+    void change_prefetch_aggr(const size_t new_p)
     {
         if (pref_aggr > new_p && bids.size() > new_p)
         {
@@ -792,15 +1098,6 @@ public:
         rehint();
     }
 
-    //! Returns number of blocks used for prefetching.
-    const size_t & get_prefetch_aggr() const
-    {
-        return pref_aggr;
-    }
-
-    //! \}
-
-private:
     //! hint the last pref_aggr external blocks.
     void rehint()
     {
@@ -31,7 +31,8 @@ template <
     class CompareType,
     unsigned SubBlockSize,
     unsigned SubBlocksPerBlock,
-    class Alloc
+    class Alloc,
+    class PagerType
     >
 class hash_map;
 
@@ -54,6 +55,8 @@ class hash_map;
  * \tparam SubBlocksPerBlock the number of subblocks per external block
  * (default: 256 -> 2MB blocks)
  * \tparam AllocType allocator for internal-memory buffer
+ * \tparam PagerType pager used by the block cache: \c lru_pager,
+ * \c clock_pager, \c twoq_pager or \c arc_pager (default: lru_pager)
  */
 template <
     class KeyType,
@@ -62,12 +65,14 @@ template <
     class CompareType,
     unsigned SubBlockSize = 8* 1024,
     unsigned SubBlocksPerBlock = 256,
-    class AllocType = std::allocator<std::pair<const KeyType, MappedType> >
+    class AllocType = std::allocator<std::pair<const KeyType, MappedType> >,
+    class PagerType = stxxl::lru_pager<>
     >
 class unordered_map
 {
     using impl_type = hash_map::hash_map<KeyType, MappedType, HashType, CompareType,
-                                         SubBlockSize, SubBlocksPerBlock, AllocType>;
+                                         SubBlockSize, SubBlocksPerBlock, AllocType,
+                                         PagerType>;
 
     impl_type impl;
 
@@ -490,12 +495,15 @@ template <
     class CompareType,
     unsigned SubBlockSize,
     unsigned SubBlocksPerBlock,
-    class AllocType
+    class AllocType,
+    class PagerType
     >
 void swap(stxxl::unordered_map<KeyType, MappedType, HashType, CompareType,
-                               SubBlockSize, SubBlocksPerBlock, AllocType>& a,
+                               SubBlockSize, SubBlocksPerBlock, AllocType,
+                               PagerType>& a,
           stxxl::unordered_map<KeyType, MappedType, HashType, CompareType,
-                               SubBlockSize, SubBlocksPerBlock, AllocType>& b
+                               SubBlockSize, SubBlocksPerBlock, AllocType,
+                               PagerType>& b
           )
 {
     a.swap(b);
@@ -0,0 +1,605 @@
+/***************************************************************************
+ *  include/stxxl/bits/containers/varlen_vector.h
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#ifndef STXXL_CONTAINERS_VARLEN_VECTOR_HEADER
+#define STXXL_CONTAINERS_VARLEN_VECTOR_HEADER
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include <tlx/logger/core.hpp>
+#include <tlx/simple_vector.hpp>
+
+#include <foxxll/common/utils.hpp>
+#include <foxxll/io/request_operations.hpp>
+#include <foxxll/mng/block_manager.hpp>
+#include <foxxll/mng/config.hpp>
+#include <foxxll/mng/typed_block.hpp>
+
+#include <stxxl/bits/common/binary_buffer.h>
+#include <stxxl/bits/containers/pager.h>
+#include <stxxl/bits/containers/vector.h>
+#include <stxxl/bits/defines.h>
+#include <stxxl/types>
+
+namespace stxxl {
+
+//! \addtogroup stlcont
+//! \{
+
+/*!
+ * External vector of variable-length byte records, e.g. strings.
+ *
+ * The records are appended to blocks, each prefixed by its length as a
+ * varint (encoded by binary_buffer::put_string()). A record does not cross a
+ * block boundary, unless it is larger than a block, in which case it starts
+ * a new block and occupies as many blocks as needed exclusively. The last
+ * block is filled in internal memory and written once it is full.
+ *
+ * Records are located using two indexes:
+ * - a small in-memory sparse index, which holds the number of the first
+ *   record starting in each block, and
+ * - a compact external offset index (an stxxl::vector), which holds the
+ *   offset inside its block of every index_stride-th record.
+ *
+ * operator[] reads at most index_stride record lengths in one block, which is
+ * cached in a small page cache. Sequential scans use bufreader, which reads
+ * blocks ahead with overlapped I/O.
+ *
+ * \tparam BlockSize size of the external memory blocks in bytes
+ * \tparam PagerType pager of the block cache used by operator[]
+ * \tparam AllocStr parallel disk block allocation strategy
+ */
+template <
+    size_t BlockSize = STXXL_DEFAULT_BLOCK_SIZE(char),
+    typename PagerType = lru_pager<8>,
+    typename AllocStr = foxxll::default_alloc_strategy
+    >
+class varlen_vector
+{
+    static constexpr bool debug = false;
+
+public:
+    using value_type = std::string;
+    using size_type = external_size_type;
+
+    using pager_type = PagerType;
+    using alloc_strategy_type = AllocStr;
+
+    static constexpr size_t block_size = BlockSize;
+
+    //! every index_stride-th record has an entry in the offset index
+    static constexpr size_t index_stride = 16;
+
+    using block_type = foxxll::typed_block<BlockSize, char>;
+    using bid_type = typename block_type::bid_type;
+
+    //! type of the external offset index
+    using index_type = stxxl::vector<uint32_t, 1, lru_pager<2>, BlockSize>;
+
+    class bufreader;
+
+protected:
+    enum { not_cached = -1 };
+
+    alloc_strategy_type m_alloc_strategy;
+    foxxll::block_manager* m_bm;
+
+    //! number of records
+    size_type m_size;
+    //! number of encoded bytes of all records
+    size_type m_bytes;
+
+    //! written blocks
+    std::vector<bid_type> m_bids;
+    //! number of the first record of each block, including the last block
+    //! which is being filled. Blocks of a large record all hold its number.
+    std::vector<size_type> m_block_first;
+    //! offset in its block of every index_stride-th record
+    index_type m_index;
+
+    //! records of the last block, not yet written
+    binary_buffer m_tail;
+
+    //! \name Write Buffers
+    //! \{
+
+    tlx::simple_vector<block_type> m_write_blocks;
+    std::vector<foxxll::request_ptr> m_write_reqs;
+    size_t m_write_next;
+
+    //! \}
+
+    //! \name Block Cache
+    //! \{
+
+    mutable pager_type m_pager;
+    mutable tlx::simple_vector<block_type> m_cache;
+    mutable std::vector<ptrdiff_t> m_block_to_slot;
+    mutable tlx::simple_vector<size_t> m_slot_to_block;
+    mutable std::queue<size_t> m_free_slots;
+
+    //! \}
+
+    //! wait for all block writes
+    void wait_writes() const
+    {
+        for (const foxxll::request_ptr& r : m_write_reqs) {
+            if (r.valid())
+                r->wait();
+        }
+    }
+
+    //! write the filled last block, which may span several blocks if it
+    //! holds one large record, and start a new last block
+    void write_tail()
+    {
+        const size_t nblocks = foxxll::div_ceil(m_tail.size(), BlockSize);
+        const size_type first = m_block_first.back();
+
+        for (size_t k = 0; k < nblocks; ++k)
+        {
+            if (m_write_reqs[m_write_next].valid())
+                m_write_reqs[m_write_next]->wait();
+
+            block_type& block = m_write_blocks[m_write_next];
+            const size_t n = std::min(BlockSize, m_tail.size() - k * BlockSize);
+            memcpy(block.begin(), m_tail.data() + k * BlockSize, n);
+
+            m_bids.emplace_back();
+            m_bm->new_blocks(m_alloc_strategy, m_bids.end() - 1, m_bids.end(),
+                             m_bids.size() - 1);
+            m_write_reqs[m_write_next] = block.write(m_bids.back());
+            m_write_next = (m_write_next + 1) % m_write_blocks.size();
+
+            // continuation blocks of a large record
+            if (k > 0)
+                m_block_first.push_back(first);
+        }
+
+        TLX_LOG << "varlen_vector: wrote " << nblocks << " blocks, records from " << first;
+
+        m_tail.clear();
+        m_block_first.push_back(m_size);
+        m_block_to_slot.resize(m_bids.size(), not_cached);
+    }
+
+    //! number of the first block of the record i
+    size_t find_block(const size_type& i) const
+    {
+        // the last block whose first record is <= i, then the first block
+        // of a large record spanning several blocks
+        auto it = std::upper_bound(m_block_first.begin(), m_block_first.end(), i) - 1;
+        it = std::lower_bound(m_block_first.begin(), it, *it);
+        return static_cast<size_t>(it - m_block_first.begin());
+    }
+
+    //! data of a block, read into the block cache if necessary
+    const char * load_block(const size_t& block_no) const
+    {
+        if (block_no == m_bids.size())
+            return m_tail.data();
+
+        ptrdiff_t slot = m_block_to_slot[block_no];
+        if (slot != not_cached) {
+            m_pager.hit(static_cast<size_t>(slot));
+            return m_cache[slot].begin();
+        }
+
+        if (m_free_slots.empty()) {
+            slot = static_cast<ptrdiff_t>(m_pager.kick());
+            m_block_to_slot[m_slot_to_block[slot]] = not_cached;
+        }
+        else {
+            slot = static_cast<ptrdiff_t>(m_free_slots.front());
+            m_free_slots.pop();
+        }
+
+        // the block may still be being written
+        wait_writes();
+        m_cache[slot].read(m_bids[block_no])->wait();
+
+        pager_load(m_pager, static_cast<size_t>(slot), block_no);
+        m_pager.hit(static_cast<size_t>(slot));
+        m_block_to_slot[block_no] = slot;
+        m_slot_to_block[slot] = block_no;
+        return m_cache[slot].begin();
+    }
+
+    //! offset in block of record i, and block number
+    void locate(const size_type& i, size_t& block_no, size_t& offset) const
+    {
+        block_no = find_block(i);
+        const size_type first = m_block_first[block_no];
+        const size_type g = i / index_stride;
+
+        size_type rec;
+        if (g * index_stride >= first) {
+            rec = g * index_stride;
+            offset = static_cast<const index_type&>(m_index)[g];
+        }
+        else {
+            rec = first;
+            offset = 0;
+        }
+
+        // skip the preceding records in the block
+        if (rec == i)
+            return;
+
+        const char* data = load_block(block_no);
+        binary_reader reader(data + offset, block_data_size(block_no) - offset);
+        for ( ; rec < i; ++rec)
+            reader.skip(reader.get_varint());
+        offset += reader.curr();
+    }
+
+    //! number of valid bytes of a block
+    size_t block_data_size(const size_t& block_no) const
+    {
+        return block_no == m_bids.size() ? m_tail.size() : BlockSize;
+    }
+
+    //! number of bytes of len encoded as varint by binary_buffer
+    static size_t varint_size(size_t len)
+    {
+        size_t n = 1;
+        while (len >= 128) {
+            len >>= 7;
+            ++n;
+        }
+        return n;
+    }
+
+    //! Read the record at (block_no, offset), which may continue in the
+    //! following blocks, via get_block(block_no) returning the block's data.
+    //! Returns the number of encoded bytes.
+    template <typename GetBlock>
+    static size_t read_record(size_t block_no, size_t offset, size_t data_size,
+                            GetBlock get_block, std::string& out)
+    {
+        const char* data = get_block(block_no);
+        binary_reader reader(data + offset, data_size - offset);
+        const size_t len = reader.get_varint();
+        const size_t head = reader.curr();
+
+        if (offset + head + len <= data_size) {
+            out.assign(data + offset + head, len);
+            return head + len;
+        }
+
+        // a large record starts at the beginning of its block
+        out.assign(data + offset + head, BlockSize - offset - head);
+        while (out.size() < len) {
+            data = get_block(++block_no);
+            out.append(data, std::min(BlockSize, len - out.size()));
+        }
+        return head + len;
+    }
+
+public:
+    //! Create an empty vector.
+    //! \param npages number of blocks cached for operator[]
+    //! \param nwrite_buffers number of blocks written asynchronously (>= D recommended)
+    explicit varlen_vector(size_t npages = pager_type::default_npages,
+                           size_t nwrite_buffers = 0)
+        : m_bm(foxxll::block_manager::get_instance()),
+          m_size(0), m_bytes(0),
+          m_block_first(1, 0),
+          m_write_blocks(nwrite_buffers ? nwrite_buffers
+                         : foxxll::config::get_instance()->disks_number()),
+          m_write_reqs(m_write_blocks.size()),
+          m_write_next(0),
+          m_pager(npages),
+          m_cache(npages),
+          m_slot_to_block(npages)
+    {
+        for (size_t i = 0; i < numpages(); ++i)
+            m_free_slots.push(i);
+    }
+
+    //! non-copyable: delete copy-constructor
+    varlen_vector(const varlen_vector&) = delete;
+    //! non-copyable: delete assignment operator
+    varlen_vector& operator = (const varlen_vector&) = delete;
+
+    ~varlen_vector()
+    {
+        wait_writes();
+        m_bm->delete_blocks(m_bids.begin(), m_bids.end());
+    }
+
+    //! \name Size and Capacity
+    //! \{
+
+    //! Number of records.
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    //! Returns true if there are no records.
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    //! Number of encoded bytes of all records, including their lengths.
+    size_type bytes() const
+    {
+        return m_bytes;
+    }
+
+    //! Number of bytes allocated on disks.
+    size_type raw_capacity() const
+    {
+        return size_type(m_bids.size()) * BlockSize;
+    }
+
+    //! Number of blocks cached for operator[].
+    size_t numpages() const
+    {
+        return m_pager.size();
+    }
+
+    //! \}
+
+    //! \name Modifiers
+    //! \{
+
+    //! Append a record.
+    void push_back(const void* data, size_t len)
+    {
+        const size_t head = m_tail.size();
+        const size_t encoded = varint_size(len) + len;
+
+        if (head != 0 && head + encoded > BlockSize)
+            write_tail();
+
+        if (m_size % index_stride == 0)
+            m_index.push_back(static_cast<uint32_t>(m_tail.size()));
+
+        m_tail.put_string(static_cast<const char*>(data), len);
+        ++m_size;
+        m_bytes += encoded;
+
+        // a large record is written right away
+        if (m_tail.size() > BlockSize)
+            write_tail();
+    }
+
+    //! Append a record.
+    void push_back(const std::string& s)
+    {
+        push_back(s.data(), s.size());
+    }
+
+    //! Append the records in [first,last), which are std::strings or
+    //! binary_buffers.
+    template <typename InputIterator>
+    void append(InputIterator first, InputIterator last)
+    {
+        for ( ; first != last; ++first)
+            push_back(first->data(), first->size());
+    }
+
+    //! Append all records of a stream.
+    template <typename StreamAlgorithm>
+    void append(StreamAlgorithm& in)
+    {
+        for ( ; !in.empty(); ++in)
+            push_back(in->data(), in->size());
+    }
+
+    //! Remove all records and free the blocks.
+    void clear()
+    {
+        wait_writes();
+        m_bm->delete_blocks(m_bids.begin(), m_bids.end());
+        m_bids.clear();
+        m_block_first.assign(1, 0);
+        m_index.clear();
+        m_tail.clear();
+        m_size = 0;
+        m_bytes = 0;
+
+        m_block_to_slot.clear();
+        while (!m_free_slots.empty())
+            m_free_slots.pop();
+        for (size_t i = 0; i < numpages(); ++i)
+            m_free_slots.push(i);
+    }
+
+    //! \}
+
+    //! \name Element Access
+    //! \{
+
+    //! Read the record i into out.
+    void get(const size_type& i, std::string& out) const
+    {
+        assert(i < m_size);
+        size_t block_no, offset;
+        locate(i, block_no, offset);
+        read_record(block_no, offset, block_data_size(block_no),
+                    [this](size_t b) { return load_block(b); }, out);
+    }
+
+    //! Returns a copy of the record i.
+    std::string operator [] (const size_type& i) const
+    {
+        std::string out;
+        get(i, out);
+        return out;
+    }
+
+    //! \}
+
+    /*!
+     * Buffered sequential reader of the records from a position on, using
+     * overlapped I/O. A model of stream with value_type std::string.
+     */
+    class bufreader
+    {
+    public:
+        using value_type = std::string;
+
+    protected:
+        const varlen_vector& m_vec;
+
+        //! number of the current record
+        size_type m_pos;
+
+        //! current record
+        std::string m_current;
+
+        //! block and offset of the next record
+        size_t m_block;
+        size_t m_offset;
+
+        //! blocks being read ahead, buffer i holds block m_block + i
+        tlx::simple_vector<block_type> m_buffers;
+        std::vector<foxxll::request_ptr> m_reqs;
+        //! number of the block in m_buffers[0]
+        size_t m_first_block;
+
+        //! start reading block b into the buffer for it, if it is on disk
+        void issue(size_t b)
+        {
+            if (b >= m_vec.m_bids.size()) return;
+            const size_t i = b % m_buffers.size();
+            if (m_reqs[i].valid())
+                m_reqs[i]->wait();
+            m_reqs[i] = m_buffers[i].read(m_vec.m_bids[b]);
+        }
+
+        //! data of block b, which must not be before the current block
+        const char * get_block(size_t b)
+        {
+            if (b == m_vec.m_bids.size())
+                return m_vec.m_tail.data();
+
+            // release blocks before b and read ahead
+            while (m_first_block < b) {
+                issue(m_first_block + m_buffers.size());
+                ++m_first_block;
+            }
+            const size_t i = b % m_buffers.size();
+            m_reqs[i]->wait();
+            return m_buffers[i].begin();
+        }
+
+        void fetch()
+        {
+            if (m_pos >= m_vec.m_size) return;
+
+            // the next record starts a new block, the blocks of a large
+            // record also start with its number
+            if (m_offset != 0 && m_block + 1 < m_vec.m_block_first.size()
+                && m_vec.m_block_first[m_block + 1] == m_pos) {
+                ++m_block;
+                m_offset = 0;
+            }
+
+            const size_t encoded = read_record(
+                m_block, m_offset, m_vec.block_data_size(m_block),
+                [this](size_t b) { return get_block(b); }, m_current);
+
+            if (m_offset + encoded <= BlockSize) {
+                m_offset += encoded;
+            }
+            else {
+                // continue after the last block of a large record
+                m_block += foxxll::div_ceil(encoded, BlockSize) - 1;
+                m_offset = BlockSize;
+            }
+        }
+
+    public:
+        //! Create a reader starting at record begin.
+        //! \param vec vector to read
+        //! \param begin number of the first record
+        //! \param nbuffers number of blocks read ahead (>= 2*D recommended)
+        explicit bufreader(const varlen_vector& vec, size_type begin = 0,
+                           size_t nbuffers = 0)
+            : m_vec(vec), m_pos(begin),
+              m_buffers(nbuffers ? nbuffers
+                        : 2 * foxxll::config::get_instance()->disks_number()),
+              m_reqs(m_buffers.size())
+        {
+            m_vec.wait_writes();
+            if (m_pos >= m_vec.m_size) return;
+
+            m_vec.locate(m_pos, m_block, m_offset);
+            m_first_block = m_block;
+            for (size_t b = m_block; b < m_block + m_buffers.size(); ++b)
+                issue(b);
+
+            fetch();
+        }
+
+        //! non-copyable: delete copy-constructor
+        bufreader(const bufreader&) = delete;
+        //! non-copyable: delete assignment operator
+        bufreader& operator = (const bufreader&) = delete;
+
+        ~bufreader()
+        {
+            for (const foxxll::request_ptr& r : m_reqs) {
+                if (r.valid())
+                    r->wait();
+            }
+        }
+
+        //! Standard stream method.
+        const value_type& operator * () const
+        {
+            assert(!empty());
+            return m_current;
+        }
+
+        //! Standard stream method.
+        const value_type* operator -> () const
+        {
+            return &(operator * ());
+        }
+
+        //! Standard stream method.
+        bufreader& operator ++ ()
+        {
+            assert(!empty());
+            ++m_pos;
+            fetch();
+            return *this;
+        }
+
+        //! Standard stream method.
+        bool empty() const
+        {
+            return m_pos >= m_vec.m_size;
+        }
+
+        //! Number of the current record.
+        size_type position() const
+        {
+            return m_pos;
+        }
+    };
+};
+
+//! \}
+
+} // namespace stxxl
+
+#endif // !STXXL_CONTAINERS_VARLEN_VECTOR_HEADER
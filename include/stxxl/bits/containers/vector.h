@@ -17,17 +17,28 @@
 #define STXXL_CONTAINERS_VECTOR_HEADER
 
 #include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <queue>
+#include <shared_mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include <tlx/define.hpp>
 #include <tlx/logger/core.hpp>
+#include <tlx/unused.hpp>
 
 #include <foxxll/common/tmeta.hpp>
 #include <foxxll/common/types.hpp>
 #include <foxxll/io/request_operations.hpp>
+#include <foxxll/io/syscall_file.hpp>
 #include <foxxll/mng/block_manager.hpp>
 #include <foxxll/mng/buf_istream.hpp>
 #include <foxxll/mng/buf_istream_reverse.hpp>
@@ -35,11 +46,19 @@
 #include <foxxll/mng/typed_block.hpp>
 
 #include <stxxl/bits/common/is_sorted.h>
+#include <stxxl/bits/config.h>
 #include <stxxl/bits/containers/pager.h>
 #include <stxxl/bits/defines.h>
 #include <stxxl/bits/deprecated.h>
 #include <stxxl/types>
 
+#if STXXL_HAVE_MMAP_FILE
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace stxxl {
 
 //! \defgroup stlcont Containers
@@ -283,6 +302,9 @@ class vector_bufreader;
 template <typename VectorIteratorType>
 class vector_bufreader_reverse;
 
+template <typename VectorIteratorType>
+class vector_multireader;
+
 template <typename VectorIteratorType>
 class vector_bufwriter;
 
@@ -819,12 +841,13 @@ public:
 //! For semantics of the methods see documentation of the STL std::vector
 //! \tparam ValueType type of contained objects (POD with no references to internal memory)
 //! \tparam PageSize number of blocks in a page, default: \b 4 (recommended >= D)
-//! \tparam PagerType type of the pager: \c random_pager or \c lru_pager, default: \b lru_pager. Both take the number of pages as template parameters, default: \b 8 (recommended >= 2)
+//! \tparam PagerType type of the pager: \c random_pager, \c lru_pager, \c clock_pager, \c twoq_pager or \c arc_pager, default: \b lru_pager. All take the number of pages as template parameters, default: \b 8 (recommended >= 2)
 //! \tparam BlockSize external block size in bytes, default is <b>2 MiB</b>
 //! \tparam AllocStr parallel disk block allocation strategies: \c striping , \c random_cyclic , \c simple_random , or \c fully_random
 //!  default is \c random_cyclic
 //!
-//! Memory consumption: BlockSize*x*PageSize bytes
+//! Memory consumption: BlockSize*(x+s)*PageSize bytes, where s is the number
+//! of spare pages for asynchronous write-back and read-ahead, see set_spare_pages()
 //! \warning Do not store references to the elements of an external vector. Such references
 //! might be invalidated during any following access to elements of the vector
 template <
@@ -890,6 +913,12 @@ public:
     //! vector_bufreader compatible with this vector
     using bufreader_reverse_type = vector_bufreader_reverse<const_iterator>;
 
+    //! vector_multireader compatible with this vector
+    using multireader_type = vector_multireader<const_iterator>;
+
+    //! access pattern of a memory mapped vector, see advise()
+    enum class map_advice { normal, sequential, random };
+
     //! \internal
     class bid_vector : public std::vector<foxxll::BID<block_size> >
     {
@@ -932,10 +961,177 @@ private:
     mutable std::queue<size_t> m_free_slots;
     mutable tlx::simple_vector<block_type>* m_cache;
 
+    //! asynchronous transfer of a page from or to a frame of the page cache
+    struct pending_page
+    {
+        size_t page_no;
+        size_t frame;
+        std::vector<foxxll::request_ptr> reqs;
+    };
+
+    //! a few block buffers for asynchronous writes which bypass the page
+    //! cache, used by append() and assign()
+    class block_writer
+    {
+        tlx::simple_vector<block_type> m_blocks;
+        std::vector<foxxll::request_ptr> m_reqs;
+        size_t m_next;
+
+    public:
+        explicit block_writer(size_t nbuffers)
+            : m_blocks(nbuffers), m_reqs(nbuffers), m_next(0) { }
+
+        //! non-copyable: delete copy-constructor
+        block_writer(const block_writer&) = delete;
+        //! non-copyable: delete assignment operator
+        block_writer& operator = (const block_writer&) = delete;
+
+        ~block_writer()
+        {
+            wait();
+        }
+
+        //! the next buffer, waits until its previous write is completed
+        block_type& next()
+        {
+            if (m_reqs[m_next].valid()) {
+                m_reqs[m_next]->wait();
+                m_reqs[m_next] = foxxll::request_ptr();
+            }
+            return m_blocks[m_next];
+        }
+
+        //! write the buffer returned by next() to bid
+        void write(const typename bids_container_type::bid_type& bid)
+        {
+            m_reqs[m_next] = m_blocks[m_next].write(bid);
+            m_next = (m_next + 1) % m_blocks.size();
+        }
+
+        //! wait for all writes
+        void wait()
+        {
+            for (foxxll::request_ptr& r : m_reqs) {
+                if (!r.valid()) continue;
+                r->wait();
+                r = foxxll::request_ptr();
+            }
+        }
+    };
+
+    //! frame of m_cache used by each slot of the pager. The cache has
+    //! m_spare_pages more frames than slots, which are used for asynchronous
+    //! write-back and read-ahead.
+    mutable tlx::simple_vector<size_t> m_slot_to_frame;
+    //! number of spare frames
+    size_t m_spare_pages;
+    //! unused spare frames
+    mutable std::vector<size_t> m_spare_frames;
+    //! evicted dirty pages being written from spare frames
+    mutable std::deque<pending_page> m_writebacks;
+    //! pages being read ahead into spare frames
+    mutable std::deque<pending_page> m_prefetches;
+    //! page of the last cache miss, to detect sequential access
+    mutable size_t m_last_miss_page;
+
+    //! synchronization of the concurrent access mode
+    struct concurrency_state
+    {
+        //! protects the page tables, the pager and the pin counts
+        std::mutex mutex;
+        //! signaled when a slot becomes unpinned
+        std::condition_variable cv_unpinned;
+        //! number of pins of each slot, pinned slots are not evicted
+        tlx::simple_vector<size_t> pins;
+        //! number of slots with a pin
+        size_t pinned_slots;
+        //! reader/writer latch of each slot, held by pins
+        std::unique_ptr<std::shared_timed_mutex[]> latches;
+
+        //! slots pinned by the element accesses of a thread: the slots of
+        //! the last two pages it accessed, or -1
+        struct access_pins
+        {
+            ptrdiff_t slot[2] = { -1, -1 };
+        };
+        //! access pins of each thread inside an access_scope
+        std::unordered_map<std::thread::id, access_pins> thread_pins;
+
+        explicit concurrency_state(size_t num_slots)
+            : pins(num_slots), pinned_slots(0),
+              latches(new std::shared_timed_mutex[num_slots])
+        {
+            std::fill(pins.begin(), pins.end(), 0);
+        }
+    };
+
+    //! state of the concurrent access mode, nullptr if disabled
+    mutable std::unique_ptr<concurrency_state> m_concurrency;
+
+    //! reference counts of the blocks shared by a vector and its
+    //! copy-on-write snapshots
+    struct shared_blocks
+    {
+        using bid_type = typename bids_container_type::bid_type;
+        using key_type = std::pair<const foxxll::file*, foxxll::external_size_type>;
+
+        struct key_hash
+        {
+            size_t operator () (const key_type& k) const
+            {
+                return std::hash<const foxxll::file*>()(k.first)
+                       ^ std::hash<foxxll::external_size_type>()(k.second);
+            }
+        };
+
+        //! protects refs, the vectors sharing blocks may be used by
+        //! different threads
+        std::mutex mutex;
+        //! number of vectors referencing each shared block. Blocks which are
+        //! not contained are owned by a single vector.
+        std::unordered_map<key_type, size_t, key_hash> refs;
+
+        static key_type key(const bid_type& bid)
+        {
+            return key_type(bid.storage, bid.offset);
+        }
+
+        //! add a reference to a block
+        void add(const bid_type& bid)
+        {
+            ++refs.emplace(key(bid), 1).first->second;
+        }
+
+        //! drop a reference to a block, returns false if it was the only one
+        bool remove(const bid_type& bid)
+        {
+            auto it = refs.find(key(bid));
+            if (it == refs.end())
+                return false;
+            if (--it->second == 1)
+                refs.erase(it);
+            return true;
+        }
+
+        //! whether a block is shared
+        bool shared(const bid_type& bid) const
+        {
+            return refs.find(key(bid)) != refs.end();
+        }
+    };
+
+    //! blocks shared with snapshots, nullptr if no snapshot was ever taken
+    std::shared_ptr<shared_blocks> m_shared;
+
     foxxll::file_ptr m_from;
     foxxll::block_manager* m_bm;
     bool m_exported;
 
+    //! read-only memory mapping of the file, nullptr if not mapped
+    const value_type* m_mapped;
+    //! length of the mapping in bytes
+    size_t m_mapped_length;
+
     size_type size_from_file_length(foxxll::external_size_type file_length) const
     {
         size_t blocks_fit = file_length / external_size_type(block_type::raw_size);
@@ -972,7 +1168,12 @@ public:
           m_page_to_slot(foxxll::div_ceil(m_bids.size(), page_size), on_disk),
           m_slot_to_page(npages),
           m_cache(nullptr),
-          m_exported(false)
+          m_slot_to_frame(npages),
+          m_spare_pages(0),
+          m_last_miss_page(0),
+          m_exported(false),
+          m_mapped(nullptr),
+          m_mapped_length(0)
     {
         m_bm = foxxll::block_manager::get_instance();
 
@@ -1001,8 +1202,18 @@ public:
         std::swap(m_slot_to_page, obj.m_slot_to_page);
         std::swap(m_free_slots, obj.m_free_slots);
         std::swap(m_cache, obj.m_cache);
+        std::swap(m_slot_to_frame, obj.m_slot_to_frame);
+        std::swap(m_spare_pages, obj.m_spare_pages);
+        std::swap(m_spare_frames, obj.m_spare_frames);
+        std::swap(m_writebacks, obj.m_writebacks);
+        std::swap(m_prefetches, obj.m_prefetches);
+        std::swap(m_last_miss_page, obj.m_last_miss_page);
+        std::swap(m_concurrency, obj.m_concurrency);
+        std::swap(m_shared, obj.m_shared);
         std::swap(m_from, obj.m_from);
         std::swap(m_exported, obj.m_exported);
+        std::swap(m_mapped, obj.m_mapped);
+        std::swap(m_mapped_length, obj.m_mapped_length);
     }
 
     //! \}
@@ -1015,7 +1226,17 @@ public:
     {
         //  numpages() might be zero
         if (!m_cache && numpages() > 0)
-            m_cache = new tlx::simple_vector<block_type>(numpages() * page_size);
+        {
+            m_cache = new tlx::simple_vector<block_type>(
+                (numpages() + m_spare_pages) * page_size);
+
+            for (size_t i = 0; i < numpages(); ++i)
+                m_slot_to_frame[i] = i;
+
+            m_spare_frames.clear();
+            for (size_t i = 0; i < m_spare_pages; ++i)
+                m_spare_frames.push_back(numpages() + i);
+        }
     }
 
     //! allows to free the cache, but you may not access any element until call
@@ -1027,6 +1248,322 @@ public:
         m_cache = nullptr;
     }
 
+    //! Set the number of spare pages of the page cache. Evicted dirty pages
+    //! are written back asynchronously from a spare page instead of stalling
+    //! the access which caused the eviction, and on sequential access the
+    //! next page is read ahead into a spare page. With zero spare pages (the
+    //! default), all page transfers are synchronous. Each spare page costs
+    //! PageSize * BlockSize bytes of internal memory. Flushes the cache.
+    void set_spare_pages(size_t spare_pages)
+    {
+        const bool allocated = (m_cache != nullptr);
+        deallocate_page_cache();
+        m_spare_pages = spare_pages;
+        if (allocated)
+            allocate_page_cache();
+    }
+
+    //! Number of spare pages of the page cache.
+    size_t spare_pages() const
+    {
+        return m_spare_pages;
+    }
+
+    //! \}
+
+    //! \name Copy-on-Write Snapshots
+    //! \{
+
+    /*!
+     * Create a snapshot of the vector, which shares all blocks with this
+     * vector instead of copying them. The blocks are reference counted, and a
+     * page is moved to new blocks when either vector writes to it, hence both
+     * vectors stay independent. Creating a snapshot only flushes the page
+     * cache and counts the blocks, it performs no other I/O.
+     *
+     * The snapshot and the vector may be used by different threads.
+     * Algorithms which write the blocks of a vector directly, like sort() or
+     * stream::materialize(), copy the shared blocks of their output range
+     * with unshare(first, last) beforehand.
+     */
+    vector snapshot()
+    {
+        if (m_from)
+            throw foxxll::bad_parameter("vector::snapshot() is not supported for vectors backed by a file");
+
+        flush();
+        if (!m_shared)
+            m_shared = std::make_shared<shared_blocks>();
+
+        const size_t nblocks = static_cast<size_t>(foxxll::div_ceil(m_size, block_type::size));
+        const size_t npages = foxxll::div_ceil(nblocks, page_size);
+
+        vector snap(0, numpages());
+        snap.m_alloc_strategy = m_alloc_strategy;
+        snap.m_size = m_size;
+        snap.m_bids.assign(m_bids.begin(), m_bids.begin() + nblocks);
+        snap.m_page_status.assign(m_page_status.begin(), m_page_status.begin() + npages);
+        snap.m_page_to_slot.assign(npages, on_disk);
+        snap.m_shared = m_shared;
+
+        std::unique_lock<std::mutex> lock(m_shared->mutex);
+        for (const auto& bid : snap.m_bids)
+            m_shared->add(bid);
+
+        return snap;
+    }
+
+    //! Copy all blocks which are shared with snapshots, such that this vector
+    //! owns all its blocks.
+    void unshare()
+    {
+        unshare_range(0, m_bids.size());
+    }
+
+    //! Copy the blocks holding the elements [first,last) which are shared
+    //! with snapshots. Algorithms which write blocks directly through bid()
+    //! call this after flush() and before writing.
+    void unshare(const iterator& first, const iterator& last)
+    {
+        assert(first.parent_vector() == this && last.parent_vector() == this);
+        unshare_range(static_cast<size_t>(first.bid() - m_bids.begin()),
+                      static_cast<size_t>(last.bid() - m_bids.begin()) +
+                      (last.block_offset() ? 1 : 0));
+    }
+
+    //! \}
+
+    //! \name Memory Mapping
+    //! \{
+
+    //! Returns true if the vector is a read-only memory mapping of a file.
+    bool mapped() const
+    {
+        return m_mapped != nullptr;
+    }
+
+    //! Pointer to the elements of a memory mapped vector, or nullptr.
+    const value_type * mapped_data() const
+    {
+        return m_mapped;
+    }
+
+    //! Pass the expected access pattern of a memory mapped vector to the
+    //! operating system using madvise(): sequential access enables aggressive
+    //! read-ahead, random access disables it.
+    void advise(map_advice advice) const
+    {
+#if STXXL_HAVE_MMAP_FILE
+        if (!m_mapped) return;
+        const int a =
+            advice == map_advice::sequential ? MADV_SEQUENTIAL :
+            advice == map_advice::random ? MADV_RANDOM : MADV_NORMAL;
+        if (::madvise(const_cast<value_type*>(m_mapped), m_mapped_length, a) != 0)
+            TLX_LOG1 << "vector::advise(): madvise() failed: " << strerror(errno);
+#else
+        tlx::unused(advice);
+#endif
+    }
+
+    //! \}
+
+    //! \name Concurrent Access
+    //! \{
+
+    /*!
+     * Pin of a page in the page cache, created by pin_page(). While pinned,
+     * the page is not evicted and references to its elements stay valid. A
+     * write pin holds the exclusive latch of the page, a read pin a shared
+     * one. The pin is released by the destructor or release().
+     */
+    class page_pin
+    {
+        const vector* m_vector;
+        size_t m_page_no;
+        size_t m_slot;
+        bool m_write;
+
+        friend class vector;
+
+        page_pin(const vector* v, size_t page_no, size_t slot, bool write)
+            : m_vector(v), m_page_no(page_no), m_slot(slot), m_write(write) { }
+
+    public:
+        //! non-copyable: delete copy-constructor
+        page_pin(const page_pin&) = delete;
+        //! non-copyable: delete assignment operator
+        page_pin& operator = (const page_pin&) = delete;
+
+        //! move-constructor
+        page_pin(page_pin&& obj)
+            : m_vector(obj.m_vector), m_page_no(obj.m_page_no),
+              m_slot(obj.m_slot), m_write(obj.m_write)
+        {
+            obj.m_vector = nullptr;
+        }
+
+        //! move-assignment operator
+        page_pin& operator = (page_pin&& obj)
+        {
+            if (this != &obj) {
+                release();
+                m_vector = obj.m_vector, m_page_no = obj.m_page_no;
+                m_slot = obj.m_slot, m_write = obj.m_write;
+                obj.m_vector = nullptr;
+            }
+            return *this;
+        }
+
+        ~page_pin()
+        {
+            release();
+        }
+
+        //! Unpin the page.
+        void release()
+        {
+            if (!m_vector) return;
+            m_vector->unpin_slot(m_slot, m_write);
+            m_vector = nullptr;
+        }
+
+        //! Number of the pinned page.
+        size_t page_no() const
+        {
+            return m_page_no;
+        }
+
+        //! Offset of the first element of the page in the vector.
+        size_type first() const
+        {
+            return size_type(m_page_no) * page_size * block_type::size;
+        }
+
+        //! Access element i of the page, requires a write pin.
+        reference operator [] (size_t i)
+        {
+            assert(m_vector && m_write);
+            return const_cast<reference>(m_vector->pinned_element(m_slot, i));
+        }
+
+        //! Access element i of the page.
+        const_reference operator [] (size_t i) const
+        {
+            assert(m_vector);
+            return m_vector->pinned_element(m_slot, i);
+        }
+    };
+
+    /*!
+     * Scope of the calling thread's element accesses in the concurrent mode.
+     * Inside the scope, operator[] and iterators pin the last two pages the
+     * thread accessed, the destructor releases these pins. Each thread
+     * creates a scope before accessing elements, e.g. at the start of its
+     * parallel region, and must not exit while it lives. Nested scopes of
+     * the same thread share the pins of the outermost one. Without the
+     * concurrent mode, the scope does nothing.
+     */
+    class access_scope
+    {
+        const vector* m_vector;
+
+    public:
+        explicit access_scope(const vector& v)
+            : m_vector(v.m_concurrency ? &v : nullptr)
+        {
+            if (!m_vector) return;
+            std::unique_lock<std::mutex> lock(v.m_concurrency->mutex);
+            if (!v.m_concurrency->thread_pins.emplace(
+                    std::this_thread::get_id(),
+                    typename concurrency_state::access_pins()).second)
+                m_vector = nullptr;    // nested scope
+        }
+
+        //! non-copyable: delete copy-constructor
+        access_scope(const access_scope&) = delete;
+        //! non-copyable: delete assignment operator
+        access_scope& operator = (const access_scope&) = delete;
+
+        ~access_scope()
+        {
+            if (m_vector)
+                m_vector->end_access_scope();
+        }
+    };
+
+    /*!
+     * Enable or disable the concurrent access mode.
+     *
+     * In the concurrent mode, operator[], element access through iterators
+     * and pin_page() may be called from multiple threads in parallel. Each
+     * access locks the page tables and the pager for a short time, cache
+     * misses are loaded while holding the lock. Element accesses must be
+     * made inside an access_scope of the calling thread, which pins the last
+     * two pages the thread accessed. Hence a reference returned by
+     * operator[] stays valid until the same thread has accessed two other
+     * pages, called pin_page() or left the scope, e.g. v[i] = v[j] is safe.
+     * Longer lived references require pin_page(). The number of pages in the
+     * cache must exceed the number of pins held at the same time, i.e. two
+     * per access_scope plus those of pin_page(). All other methods (resize,
+     * flush, etc.) must not run concurrently with any access. The mode must
+     * not be disabled while access scopes or pin_page() pins exist.
+     */
+    void set_concurrent(bool enable)
+    {
+        if (enable && !m_concurrency)
+            m_concurrency.reset(new concurrency_state(numpages()));
+        else if (!enable && m_concurrency) {
+            assert(m_concurrency->thread_pins.empty());
+            assert(m_concurrency->pinned_slots == 0);
+            m_concurrency.reset();
+        }
+    }
+
+    //! Returns true if the concurrent access mode is enabled.
+    bool concurrent() const
+    {
+        return m_concurrency != nullptr;
+    }
+
+    //! Pin a page in the page cache, loading it if necessary, and acquire
+    //! its latch: exclusive for a write pin, which marks the page dirty, and
+    //! shared for a read pin. Blocks while all cache slots are pinned.
+    //! Releases the pins of the calling thread's element accesses, so
+    //! references obtained before are invalidated, but not its access_scope.
+    //! Requires the concurrent access mode.
+    page_pin pin_page(size_t page_no, bool write = false)
+    {
+        assert(m_concurrency);
+        assert(page_no < m_page_to_slot.size());
+        std::unique_lock<std::mutex> lock(m_concurrency->mutex);
+
+        auto it = m_concurrency->thread_pins.find(std::this_thread::get_id());
+        if (it != m_concurrency->thread_pins.end()) {
+            release_access_pin(it->second.slot[0]);
+            release_access_pin(it->second.slot[1]);
+        }
+
+        const size_t slot = acquire_page(page_no, lock);
+        if (write)
+            mark_dirty(page_no);
+        if (m_concurrency->pins[slot]++ == 0)
+            ++m_concurrency->pinned_slots;
+        lock.unlock();
+
+        if (write)
+            m_concurrency->latches[slot].lock();
+        else
+            m_concurrency->latches[slot].lock_shared();
+
+        return page_pin(this, page_no, slot, write);
+    }
+
+    //! Pin a page in the page cache for reading, see pin_page().
+    page_pin pin_page(size_t page_no) const
+    {
+        return const_cast<vector*>(this)->pin_page(page_no, false);
+    }
+
     //! \}
 
     //! \name Size and Capacity
@@ -1122,6 +1659,7 @@ private:
     {
         reserve(n);
         if (n < m_size) {
+            sync_pending_pages();
             // mark excess pages as uninitialized and evict them from cache
             const size_t first_page_to_evict = static_cast<size_t>(
                 foxxll::div_ceil(n, block_type::size * page_size));
@@ -1156,10 +1694,11 @@ private:
                 new_pages_size << " pages";
 
             // release blocks
+            sync_pending_pages();
             if (m_from)
                 m_from->set_size(new_bids_size * block_type::raw_size);
             else
-                m_bm->delete_blocks(m_bids.begin() + old_bids_size, m_bids.end());
+                release_blocks(m_bids.begin() + new_bids_size, m_bids.end());
 
             m_bids.resize(new_bids_size);
 
@@ -1183,9 +1722,10 @@ public:
     //! occupied.
     void clear()
     {
+        sync_pending_pages();
         m_size = 0;
         if (!m_from)
-            m_bm->delete_blocks(m_bids.begin(), m_bids.end());
+            release_blocks(m_bids.begin(), m_bids.end());
 
         m_bids.clear();
         m_page_status.clear();
@@ -1197,6 +1737,81 @@ public:
             m_free_slots.push(i);
     }
 
+    //! Append the elements of [first,last) at the end. Whole blocks are
+    //! filled in a few buffers and written asynchronously to newly allocated
+    //! blocks, without going through the page cache.
+    template <typename InputIterator>
+    void append(InputIterator first, InputIterator last)
+    {
+        append_from(
+            [&first, &last](value_type& v) {
+                if (first == last) return false;
+                v = *first;
+                ++first;
+                return true;
+            });
+    }
+
+    //! Append all items of a stream at the end, see append(first, last).
+    template <typename StreamAlgorithm>
+    void append(StreamAlgorithm& in)
+    {
+        append_from(
+            [&in](value_type& v) {
+                if (in.empty()) return false;
+                v = *in;
+                ++in;
+                return true;
+            });
+    }
+
+    //! Overwrite the n elements starting at offset with data[0,n), the range
+    //! must be within size(). Whole blocks of pages which are not cached are
+    //! written directly, without reading the pages into the page cache.
+    void assign(size_type offset, const value_type* data, size_type n)
+    {
+        assert(offset + n <= m_size);
+        const size_type end = offset + n;
+
+        // elements in front of the first whole block
+        while (offset < end && offset % block_type::size != 0)
+            element(offset++) = *data++;
+
+        sync_pending_pages();
+        block_writer writer(2 * foxxll::config::get_instance()->disks_number());
+
+        for ( ; end - offset >= block_type::size;
+              offset += block_type::size, data += block_type::size)
+        {
+            const size_t block_no = static_cast<size_t>(offset / block_type::size);
+            const size_t page_no = block_no / page_size;
+            const ptrdiff_t slot = m_page_to_slot[page_no];
+
+            if (slot >= 0)                         // != on_disk
+            {
+                block_type& block = (*m_cache)[
+                    m_slot_to_frame[slot] * page_size + block_no % page_size];
+                std::copy(data, data + block_type::size, block.begin());
+                mark_dirty(page_no);
+                continue;
+            }
+
+            block_type& block = writer.next();
+            std::copy(data, data + block_type::size, block.begin());
+            if (m_shared)
+                unshare_blocks(block_no, block_no + 1);
+            writer.write(m_bids[block_no]);
+            m_page_status[page_no] = valid_on_disk;
+        }
+
+        // the last page may be read below
+        writer.wait();
+
+        // elements behind the last whole block
+        while (offset < end)
+            element(offset++) = *data++;
+    }
+
     //! \}
 
     //! \name Front and Back Access
@@ -1262,8 +1877,13 @@ public:
           m_page_to_slot(foxxll::div_ceil(m_bids.size(), page_size), on_disk),
           m_slot_to_page(npages),
           m_cache(nullptr),
+          m_slot_to_frame(npages),
+          m_spare_pages(0),
+          m_last_miss_page(0),
           m_from(from),
-          m_exported(false)
+          m_exported(false),
+          m_mapped(nullptr),
+          m_mapped_length(0)
     {
         // initialize from file
         if (!block_type::has_only_data)
@@ -1292,6 +1912,25 @@ public:
         from->set_size(offset);
     }
 
+    //! Construct a read-only vector from an existing file, which is mapped
+    //! into memory if the platform supports it. Then const element access,
+    //! const_iterator and vector_iterator2stream read the mapped memory
+    //! directly, no page cache is allocated and the operating system's page
+    //! cache is shared with other processes mapping the same file. Without
+    //! mmap() support, the vector reads the file through its page cache.
+    //! Only const access is allowed, mutable element access throws
+    //! foxxll::bad_parameter.
+    //! \param path file to be mapped
+    //! \param advice expected access pattern, see advise()
+    //! \param size Number of elements, must not exceed the file's length.
+    vector(const std::string& path, map_advice advice,
+           const size_type size = size_type(-1))
+        : vector(tlx::make_counting<foxxll::syscall_file>(path, foxxll::file::RDONLY),
+                 size, pager_type().size())
+    {
+        map_file(path, advice);
+    }
+
     //! copy-constructor
     vector(const vector& obj)
         : m_size(obj.size()),
@@ -1301,7 +1940,12 @@ public:
           m_page_to_slot(foxxll::div_ceil(m_bids.size(), page_size), on_disk),
           m_slot_to_page(obj.numpages()),
           m_cache(nullptr),
-          m_exported(false)
+          m_slot_to_frame(obj.numpages()),
+          m_spare_pages(0),
+          m_last_miss_page(0),
+          m_exported(false),
+          m_mapped(nullptr),
+          m_mapped_length(0)
     {
         assert(!obj.m_exported);
         m_bm = foxxll::block_manager::get_instance();
@@ -1318,6 +1962,13 @@ public:
         std::copy(inbegin, inend, begin());
     }
 
+    //! move-constructor: takes the content of obj, which becomes empty
+    vector(vector&& obj)
+        : vector(0, obj.numpages())
+    {
+        swap(obj);
+    }
+
     //! \}
 
     //! \name Operators
@@ -1444,6 +2095,8 @@ public:
     //! Flushes the cache pages to the external memory.
     void flush() const
     {
+        sync_pending_pages();
+
         tlx::simple_vector<bool> non_free_slots(numpages());
 
         for (size_t i = 0; i < numpages(); i++)
@@ -1465,7 +2118,7 @@ public:
                 (static_cast<uint64_t>(page_no)
                  * static_cast<uint64_t>(block_type::size)
                  * static_cast<uint64_t>(page_size));
-                write_page(page_no, i);
+                write_page(page_no, m_slot_to_frame[i]);
 
                 m_page_to_slot[page_no] = on_disk;
             }
@@ -1493,10 +2146,12 @@ public:
             TLX_LOG1 << "Exception thrown in ~vector()";
         }
 
+        unmap_file();
+
         if (!m_exported)
         {
             if (!m_from) {
-                m_bm->delete_blocks(m_bids.begin(), m_bids.end());
+                release_blocks(m_bids.begin(), m_bids.end());
             }
             else // file must be truncated
             {
@@ -1525,6 +2180,10 @@ public:
     //! files will be numbered ascending.
     void export_files(std::string filename_prefix)
     {
+        // write the cached pages before their blocks are copied, dirty pages
+        // already own new blocks which are not written yet.
+        flush();
+        unshare();
         size_t no = 0;
         for (bids_container_iterator i = m_bids.begin(); i != m_bids.end(); ++i) {
             std::ostringstream number;
@@ -1555,6 +2214,7 @@ public:
     template <typename ForwardIterator>
     void set_content(const ForwardIterator& bid_begin, const ForwardIterator& bid_end, size_type n)
     {
+        sync_pending_pages();
         const size_t new_bids_size = foxxll::div_ceil(n, block_type::size);
         m_bids.resize(new_bids_size);
         std::copy(bid_begin, bid_end, m_bids.begin());
@@ -1598,114 +2258,579 @@ private:
                 (offset.get_block2() * PageSize + offset.get_block1()));
     }
 
-    void read_page(const size_t& page_no, const size_t& cache_slot) const
+    //! issue the reads of a page into a frame of the page cache
+    void issue_read_page(const size_t& page_no, const size_t& frame,
+                         std::vector<foxxll::request_ptr>& reqs) const
     {
         assert(page_no < m_page_status.size());
+        assert(m_page_status[page_no] != uninitialized);
 
-        if (m_page_status[page_no] == uninitialized)
-            return;
-
-        TLX_LOG << "read_page(): page_no=" << page_no << " cache_slot=" << cache_slot;
-        std::vector<foxxll::request_ptr> reqs;
+        TLX_LOG << "read_page(): page_no=" << page_no << " frame=" << frame;
         reqs.reserve(page_size);
 
         size_t block_no = page_no * page_size;
         const size_t last_block = std::min<size_t>(block_no + page_size, m_bids.size());
-        for (size_t i = cache_slot * page_size; block_no < last_block; ++block_no, ++i) {
+        assert(block_no < last_block);
+        for (size_t i = frame * page_size; block_no < last_block; ++block_no, ++i) {
             reqs.push_back((*m_cache)[i].read(m_bids[block_no]));
         }
-
-        assert(last_block - page_no * page_size > 0);
-        wait_all(reqs.data(), last_block - page_no * page_size);
     }
 
-    void write_page(const size_t& page_no, const size_t& cache_slot) const
+    //! issue the writes of a dirty page from a frame of the page cache
+    void issue_write_page(const size_t& page_no, const size_t& frame,
+                          std::vector<foxxll::request_ptr>& reqs) const
     {
         assert(page_no < m_page_status.size());
+        assert(m_page_status[page_no] & dirty);
 
-        if (!(m_page_status[page_no] & dirty))
-            return;
-
-        TLX_LOG << "write_page(): page_no=" << page_no << " cache_slot=" << cache_slot;
-
-        std::vector<foxxll::request_ptr> reqs;
+        TLX_LOG << "write_page(): page_no=" << page_no << " frame=" << frame;
         reqs.reserve(page_size);
 
         size_t block_no = page_no * page_size;
-
         const size_t last_block = std::min<size_t>(block_no + page_size, m_bids.size());
         assert(block_no < last_block);
-        for (size_t i = cache_slot * page_size; block_no < last_block; ++block_no, ++i) {
+        for (size_t i = frame * page_size; block_no < last_block; ++block_no, ++i) {
             reqs.push_back((*m_cache)[i].write(m_bids[block_no]));
         }
 
         m_page_status[page_no] = valid_on_disk;
-        assert(last_block - page_no * page_size > 0);
-
-        wait_all(reqs.data(), last_block - page_no * page_size);
     }
 
-    reference element(size_type offset)
+    void read_page(const size_t& page_no, const size_t& frame) const
     {
-        return element(blocked_index_type(offset));
+        if (m_page_status[page_no] == uninitialized)
+            return;
+
+        std::vector<foxxll::request_ptr> reqs;
+        issue_read_page(page_no, frame, reqs);
+        wait_all(reqs.data(), reqs.size());
     }
 
-    reference element(const blocked_index_type& offset)
+    void write_page(const size_t& page_no, const size_t& frame) const
     {
-        assert(offset.get_pos() < size());
-        const size_t page_no = offset.get_block2();
-        assert(page_no < m_page_to_slot.size());   // fails if offset is too large, out of bound access
-        const auto cache_slot = m_page_to_slot[page_no];
-        if (cache_slot < 0)                        // == on_disk
-        {
-            if (m_free_slots.empty())              // has to kick
-            {
-                const size_t kicked_slot = m_pager.kick();
-                m_pager.hit(kicked_slot);
-                const size_t old_page_no = m_slot_to_page[kicked_slot];
-                m_page_to_slot[page_no] = kicked_slot;
-                m_page_to_slot[old_page_no] = on_disk;
-                m_slot_to_page[kicked_slot] = page_no;
+        if (!(m_page_status[page_no] & dirty))
+            return;
+
+        std::vector<foxxll::request_ptr> reqs;
+        issue_write_page(page_no, frame, reqs);
+        wait_all(reqs.data(), reqs.size());
+    }
 
-                write_page(old_page_no, kicked_slot);
-                read_page(page_no, kicked_slot);
+    //! wait for a pending page transfer and release its spare frame
+    void complete_pending_page(std::deque<pending_page>& list,
+                               typename std::deque<pending_page>::iterator it) const
+    {
+        wait_all(it->reqs.data(), it->reqs.size());
+        m_spare_frames.push_back(it->frame);
+        list.erase(it);
+    }
 
-                m_page_status[page_no] = dirty;
+    //! release the spare frames of all finished write-backs
+    void reap_writebacks() const
+    {
+        for (auto it = m_writebacks.begin(); it != m_writebacks.end(); )
+        {
+            bool done = true;
+            for (const foxxll::request_ptr& r : it->reqs)
+                done = done && r->poll();
 
-                return (*m_cache)[kicked_slot * page_size + offset.get_block1()][offset.get_offset()];
+            if (!done) {
+                ++it;
+                continue;
             }
-            else
-            {
-                const size_t free_slot = m_free_slots.front();
-                m_free_slots.pop();
-                m_pager.hit(free_slot);
-                m_page_to_slot[page_no] = free_slot;
-                m_slot_to_page[free_slot] = page_no;
+            m_spare_frames.push_back(it->frame);
+            it = m_writebacks.erase(it);
+        }
+    }
 
-                read_page(page_no, free_slot);
+    //! Wait for all write-backs and drop all read-aheads.
+    void sync_pending_pages() const
+    {
+        while (!m_writebacks.empty())
+            complete_pending_page(m_writebacks, m_writebacks.begin());
+        while (!m_prefetches.empty())
+            complete_pending_page(m_prefetches, m_prefetches.begin());
+    }
 
-                m_page_status[page_no] = dirty;
+    //! Get an unused spare frame, waiting for the oldest write-back or
+    //! dropping the oldest read-ahead if necessary. Returns false if there
+    //! are no spare pages.
+    bool get_spare_frame(size_t& frame) const
+    {
+        if (m_spare_pages == 0)
+            return false;
 
-                return (*m_cache)[free_slot * page_size + offset.get_block1()][offset.get_offset()];
-            }
-        }
-        else
+        reap_writebacks();
+
+        if (m_spare_frames.empty())
         {
-            m_page_status[page_no] = dirty;
-            m_pager.hit(cache_slot);
-            return (*m_cache)[cache_slot * page_size + offset.get_block1()][offset.get_offset()];
+            if (!m_writebacks.empty())
+                complete_pending_page(m_writebacks, m_writebacks.begin());
+            else if (!m_prefetches.empty())
+                complete_pending_page(m_prefetches, m_prefetches.begin());
         }
+
+        assert(!m_spare_frames.empty());
+        frame = m_spare_frames.back();
+        m_spare_frames.pop_back();
+        return true;
     }
 
-    // don't forget to first flush() the vector's cache before updating pages externally
-    void page_externally_updated(const size_t page_no) const
+    //! find a pending transfer of a page
+    static typename std::deque<pending_page>::iterator
+    find_pending_page(std::deque<pending_page>& list, const size_t& page_no)
     {
-        // fails if offset is too large, out of bound access
-        assert(page_no < m_page_status.size());
-        // "A dirty page has been marked as newly initialized. The page content will be lost."
-        assert(!(m_page_status[page_no] & dirty));
-        if (m_page_to_slot[page_no] >= 0) { // != on_disk
-            // remove page from cache
+        return std::find_if(list.begin(), list.end(),
+                            [&page_no](const pending_page& p) { return p.page_no == page_no; });
+    }
+
+    //! Start reading a page ahead into a spare frame, if one is free.
+    void prefetch_page(const size_t& page_no) const
+    {
+        if (page_no >= m_page_status.size() ||
+            page_no * page_size >= m_bids.size() ||
+            m_page_to_slot[page_no] != on_disk ||
+            m_page_status[page_no] != valid_on_disk)
+            return;
+
+        if (find_pending_page(m_prefetches, page_no) != m_prefetches.end() ||
+            find_pending_page(m_writebacks, page_no) != m_writebacks.end())
+            return;
+
+        // read-ahead never stalls: use only a free spare frame
+        reap_writebacks();
+        if (m_spare_frames.empty())
+            return;
+
+        pending_page p;
+        p.page_no = page_no;
+        p.frame = m_spare_frames.back();
+        m_spare_frames.pop_back();
+        issue_read_page(page_no, p.frame, p.reqs);
+        m_prefetches.push_back(std::move(p));
+    }
+
+    //! Load a page which is not cached into a slot of the page cache,
+    //! evicting a page if necessary. Returns the slot.
+    size_t load_page(const size_t& page_no) const
+    {
+        size_t slot;
+        if (m_free_slots.empty())                  // has to kick
+        {
+            slot = m_pager.kick();
+            while (m_concurrency && m_concurrency->pins[slot] != 0) {
+                // pinned pages stay in the cache
+                m_pager.hit(slot);
+                slot = m_pager.kick();
+            }
+            const size_t old_page_no = m_slot_to_page[slot];
+            m_page_to_slot[old_page_no] = on_disk;
+
+            size_t spare;
+            if ((m_page_status[old_page_no] & dirty) && get_spare_frame(spare))
+            {
+                // write back asynchronously, continue with the spare frame
+                pending_page p;
+                p.page_no = old_page_no;
+                p.frame = m_slot_to_frame[slot];
+                issue_write_page(old_page_no, p.frame, p.reqs);
+                m_writebacks.push_back(std::move(p));
+                m_slot_to_frame[slot] = spare;
+            }
+            else
+            {
+                write_page(old_page_no, m_slot_to_frame[slot]);
+            }
+        }
+        else
+        {
+            slot = m_free_slots.front();
+            m_free_slots.pop();
+        }
+
+        pager_load(m_pager, slot, page_no);
+        m_pager.hit(slot);
+        m_page_to_slot[page_no] = slot;
+        m_slot_to_page[slot] = page_no;
+
+        // take the page from a read-ahead or a pending write-back, whose
+        // frame holds the current content of the page, or read it.
+        auto it = find_pending_page(m_prefetches, page_no);
+        std::deque<pending_page>* list = &m_prefetches;
+        if (it == m_prefetches.end()) {
+            it = find_pending_page(m_writebacks, page_no);
+            list = &m_writebacks;
+        }
+
+        if (it != list->end())
+        {
+            wait_all(it->reqs.data(), it->reqs.size());
+            m_spare_frames.push_back(m_slot_to_frame[slot]);
+            m_slot_to_frame[slot] = it->frame;
+            list->erase(it);
+        }
+        else
+        {
+            read_page(page_no, m_slot_to_frame[slot]);
+        }
+
+        // detect sequential access and read the next page ahead
+        if (m_spare_pages > 0)
+        {
+            if (page_no == m_last_miss_page + 1)
+                prefetch_page(page_no + 1);
+            m_last_miss_page = page_no;
+        }
+
+        return slot;
+    }
+
+    //! copy the blocks [begin,end) which are shared with snapshots
+    void unshare_range(size_t begin, size_t end)
+    {
+        if (!m_shared || begin >= end)
+            return;
+
+        sync_pending_pages();
+        block_writer writer(std::min<size_t>(
+                                2 * foxxll::config::get_instance()->disks_number(), end - begin));
+
+        for (size_t page_no = begin / page_size; page_no < m_page_status.size(); ++page_no)
+        {
+            const size_t first = std::max<size_t>(page_no * page_size, begin);
+            const size_t last = std::min<size_t>((page_no + 1) * page_size, end);
+            if (first >= last)
+                break;
+
+            if (m_page_to_slot[page_no] >= 0) {
+                // the cached content is written to new blocks
+                mark_dirty(page_no);
+                continue;
+            }
+            if (m_page_status[page_no] == uninitialized) {
+                // no content to copy
+                unshare_blocks(first, last);
+                continue;
+            }
+
+            for (size_t b = first; b < last; ++b)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(m_shared->mutex);
+                    if (!m_shared->shared(m_bids[b]))
+                        continue;
+                }
+
+                // read the block while it is shared, hence not written
+                block_type& block = writer.next();
+                block.read(m_bids[b])->wait();
+
+                std::unique_lock<std::mutex> lock(m_shared->mutex);
+                if (!m_shared->remove(m_bids[b]))
+                    continue;              // the other vectors dropped it meanwhile
+                m_bm->new_blocks(m_alloc_strategy,
+                                 m_bids.begin() + b, m_bids.begin() + b + 1, b);
+                lock.unlock();
+
+                writer.write(m_bids[b]);
+            }
+        }
+    }
+
+    //! move the blocks [first,last) which are shared with snapshots to newly
+    //! allocated blocks, without copying their content
+    void unshare_blocks(size_t first, size_t last)
+    {
+        std::unique_lock<std::mutex> lock(m_shared->mutex);
+        for (size_t b = first; b < last; ++b)
+        {
+            if (m_shared->remove(m_bids[b]))
+                m_bm->new_blocks(m_alloc_strategy,
+                                 m_bids.begin() + b, m_bids.begin() + b + 1, b);
+        }
+    }
+
+    //! mark a cached page as dirty. A page which becomes dirty is moved off
+    //! the blocks it shares with snapshots, as it will be written.
+    void mark_dirty(const size_t& page_no)
+    {
+        if (m_shared && m_page_status[page_no] != dirty)
+        {
+            const size_t first = page_no * page_size;
+            unshare_blocks(first, std::min<size_t>(first + page_size, m_bids.size()));
+        }
+        m_page_status[page_no] = dirty;
+    }
+
+    //! release blocks, deleting those not shared with snapshots
+    void release_blocks(bids_container_iterator begin, bids_container_iterator end)
+    {
+        if (!m_shared) {
+            m_bm->delete_blocks(begin, end);
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(m_shared->mutex);
+        for ( ; begin != end; ++begin)
+        {
+            if (!m_shared->remove(*begin))
+                m_bm->delete_block(*begin);
+        }
+    }
+
+    //! remove a page from the page cache, writing it if it is dirty
+    void evict_page(const size_t& page_no)
+    {
+        const ptrdiff_t slot = m_page_to_slot[page_no];
+        if (slot < 0)                              // == on_disk
+            return;
+
+        write_page(page_no, m_slot_to_frame[slot]);
+        m_free_slots.push(slot);
+        m_page_to_slot[page_no] = on_disk;
+    }
+
+    //! Append the items returned by next(value_type&) until it returns
+    //! false. The last partial block is filled through the page cache, all
+    //! further blocks are written directly.
+    template <typename Generator>
+    void append_from(Generator next)
+    {
+        if (m_mapped)
+            throw foxxll::bad_parameter("vector: memory mapped vectors are read-only");
+
+        value_type v;
+        while (m_size % block_type::size != 0)
+        {
+            if (!next(v))
+                return;
+            push_back(v);
+        }
+
+        sync_pending_pages();
+        block_writer writer(2 * foxxll::config::get_instance()->disks_number());
+
+        for (size_t block_no = static_cast<size_t>(m_size / block_type::size); ; ++block_no)
+        {
+            block_type& block = writer.next();
+            size_t n = 0;
+            while (n < block_type::size && next(block[n]))
+                ++n;
+            if (n == 0)
+                break;
+
+            // allocate blocks for one page at a time
+            if (block_no >= m_bids.size())
+                reserve(capacity() + page_size * block_type::size);
+
+            // the page may hold the preceding blocks
+            const size_t page_no = block_no / page_size;
+            evict_page(page_no);
+
+            if (m_shared)
+                unshare_blocks(block_no, block_no + 1);
+            writer.write(m_bids[block_no]);
+            m_page_status[page_no] = valid_on_disk;
+            m_size += n;
+
+            if (n < block_type::size)
+                break;
+        }
+    }
+
+    //! map the file at path, which backs this vector, read-only into memory
+    void map_file(const std::string& path, map_advice advice)
+    {
+#if STXXL_HAVE_MMAP_FILE
+        const size_t length = static_cast<size_t>(m_size) * sizeof(value_type);
+        if (length == 0)
+            return;
+
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            FOXXLL_THROW2(foxxll::io_error, "vector::map_file",
+                          "open() failed for " << path << ": " << strerror(errno));
+        }
+
+        // accessing a mapping beyond the end of the file raises SIGBUS
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < length) {
+            ::close(fd);
+            FOXXLL_THROW2(foxxll::bad_parameter, "vector::map_file",
+                          "file " << path << " is shorter than " << m_size << " elements");
+        }
+
+        void* addr = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        const int mmap_errno = errno;
+        ::close(fd);
+
+        if (addr == MAP_FAILED) {
+            FOXXLL_THROW2(foxxll::io_error, "vector::map_file",
+                          "mmap() failed for " << path << ": " << strerror(mmap_errno));
+        }
+
+        m_mapped = static_cast<const value_type*>(addr);
+        m_mapped_length = length;
+        advise(advice);
+
+        // the page cache is not needed anymore
+        deallocate_page_cache();
+#else
+        tlx::unused(path);
+        tlx::unused(advice);
+#endif
+    }
+
+    //! remove the memory mapping
+    void unmap_file()
+    {
+#if STXXL_HAVE_MMAP_FILE
+        if (!m_mapped) return;
+        ::munmap(const_cast<value_type*>(m_mapped), m_mapped_length);
+        m_mapped = nullptr;
+        m_mapped_length = 0;
+#endif
+    }
+
+    //! Returns the slot of a page, loading the page if it is not cached. In
+    //! the concurrent mode, lock must hold the mutex and is used to wait
+    //! until a slot can be evicted.
+    size_t acquire_page(const size_t& page_no, std::unique_lock<std::mutex>& lock) const
+    {
+        if (m_page_to_slot[page_no] < 0 && m_concurrency && m_free_slots.empty())
+        {
+            m_concurrency->cv_unpinned.wait(
+                lock, [this, &page_no]() {
+                    return m_page_to_slot[page_no] >= 0 ||
+                    m_concurrency->pinned_slots < numpages();
+                });
+        }
+
+        const ptrdiff_t cache_slot = m_page_to_slot[page_no];
+        if (cache_slot < 0)                        // == on_disk
+            return load_page(page_no);
+
+        m_pager.hit(cache_slot);
+        return static_cast<size_t>(cache_slot);
+    }
+
+    //! release a pin created by pin_page()
+    void unpin_slot(const size_t& slot, bool write) const
+    {
+        if (write)
+            m_concurrency->latches[slot].unlock();
+        else
+            m_concurrency->latches[slot].unlock_shared();
+
+        std::unique_lock<std::mutex> lock(m_concurrency->mutex);
+        assert(m_concurrency->pins[slot] > 0);
+        if (--m_concurrency->pins[slot] == 0) {
+            --m_concurrency->pinned_slots;
+            lock.unlock();
+            m_concurrency->cv_unpinned.notify_all();
+        }
+    }
+
+    //! release a pin of an element access, the mutex must be held
+    void release_access_pin(ptrdiff_t& slot) const
+    {
+        if (slot < 0) return;
+        assert(m_concurrency->pins[slot] > 0);
+        if (--m_concurrency->pins[slot] == 0) {
+            --m_concurrency->pinned_slots;
+            m_concurrency->cv_unpinned.notify_all();
+        }
+        slot = -1;
+    }
+
+    //! release the access pins of the calling thread's access_scope
+    void end_access_scope() const
+    {
+        std::unique_lock<std::mutex> lock(m_concurrency->mutex);
+        auto it = m_concurrency->thread_pins.find(std::this_thread::get_id());
+        assert(it != m_concurrency->thread_pins.end());
+        release_access_pin(it->second.slot[0]);
+        release_access_pin(it->second.slot[1]);
+        m_concurrency->thread_pins.erase(it);
+    }
+
+    //! Returns the slot of a page for an element access. In the concurrent
+    //! mode, lock must hold the mutex, and the page is pinned for the
+    //! calling thread's access_scope until it has accessed two other pages.
+    size_t access_page(const size_t& page_no, std::unique_lock<std::mutex>& lock) const
+    {
+        if (!m_concurrency)
+            return acquire_page(page_no, lock);
+
+        auto it = m_concurrency->thread_pins.find(std::this_thread::get_id());
+        // element accesses in the concurrent mode need an access_scope
+        assert(it != m_concurrency->thread_pins.end());
+        if (it == m_concurrency->thread_pins.end())
+            return acquire_page(page_no, lock);
+
+        auto& pins = it->second;
+        for (size_t k = 0; k < 2; ++k)
+        {
+            // pinned slots are not evicted and still hold the same page
+            if (pins.slot[k] >= 0 && m_page_to_slot[page_no] == pins.slot[k]) {
+                m_pager.hit(pins.slot[k]);
+                std::swap(pins.slot[0], pins.slot[k]);
+                return static_cast<size_t>(pins.slot[0]);
+            }
+        }
+
+        // drop the older pin first, a thread may wait for a slot below
+        release_access_pin(pins.slot[1]);
+        const size_t slot = acquire_page(page_no, lock);
+        if (m_concurrency->pins[slot]++ == 0)
+            ++m_concurrency->pinned_slots;
+        pins.slot[1] = pins.slot[0];
+        pins.slot[0] = static_cast<ptrdiff_t>(slot);
+        return slot;
+    }
+
+    //! element i of the page in a pinned slot
+    const_reference pinned_element(const size_t& slot, const size_t& i) const
+    {
+        assert(i < page_size * block_type::size);
+        return (*m_cache)[m_slot_to_frame[slot] * page_size + i / block_type::size]
+               [i % block_type::size];
+    }
+
+    reference element(size_type offset)
+    {
+        return element(blocked_index_type(offset));
+    }
+
+    reference element(const blocked_index_type& offset)
+    {
+        assert(offset.get_pos() < size());
+        if (TLX_UNLIKELY(m_mapped))
+            throw foxxll::bad_parameter("vector: memory mapped vectors are read-only, use const access");
+        const size_t page_no = offset.get_block2();
+        assert(page_no < m_page_to_slot.size());   // fails if offset is too large, out of bound access
+        std::unique_lock<std::mutex> lock;
+        if (m_concurrency)
+            lock = std::unique_lock<std::mutex>(m_concurrency->mutex);
+        const size_t cache_slot = access_page(page_no, lock);
+
+        mark_dirty(page_no);
+        return (*m_cache)[m_slot_to_frame[cache_slot] * page_size + offset.get_block1()][offset.get_offset()];
+    }
+
+    // don't forget to first flush() the vector's cache before updating pages externally
+    void page_externally_updated(const size_t page_no) const
+    {
+        // fails if offset is too large, out of bound access
+        assert(page_no < m_page_status.size());
+        // "A dirty page has been marked as newly initialized. The page content will be lost."
+        assert(!(m_page_status[page_no] & dirty));
+        // drop a read-ahead of the old content
+        auto it = find_pending_page(m_prefetches, page_no);
+        if (it != m_prefetches.end())
+            complete_pending_page(m_prefetches, it);
+        if (m_page_to_slot[page_no] >= 0) { // != on_disk
+            // remove page from cache
             m_free_slots.push(m_page_to_slot[page_no]);
             m_page_to_slot[page_no] = on_disk;
             TLX_LOG << "page_externally_updated(): page_no=" << page_no << " flushed from cache.";
@@ -1729,48 +2854,24 @@ private:
 
     const_reference const_element(size_type offset) const
     {
+        if (m_mapped)
+            return m_mapped[offset];
         return const_element(blocked_index_type(offset));
     }
 
     const_reference const_element(const blocked_index_type& offset) const
     {
+        if (m_mapped)
+            return m_mapped[offset.get_pos()];
+
         const size_t& page_no = offset.get_block2();
         assert(page_no < m_page_to_slot.size());   // fails if offset is too large, out of bound access
-        const auto cache_slot = m_page_to_slot[page_no];
-        if (cache_slot < 0)                        // == on_disk
-        {
-            if (m_free_slots.empty())              // has to kick
-            {
-                const size_t kicked_slot = m_pager.kick();
-                m_pager.hit(kicked_slot);
-                const size_t old_page_no = m_slot_to_page[kicked_slot];
-                m_page_to_slot[page_no] = kicked_slot;
-                m_page_to_slot[old_page_no] = on_disk;
-                m_slot_to_page[kicked_slot] = page_no;
-
-                write_page(old_page_no, kicked_slot);
-                read_page(page_no, kicked_slot);
+        std::unique_lock<std::mutex> lock;
+        if (m_concurrency)
+            lock = std::unique_lock<std::mutex>(m_concurrency->mutex);
+        const size_t cache_slot = access_page(page_no, lock);
 
-                return (*m_cache)[kicked_slot * page_size + offset.get_block1()][offset.get_offset()];
-            }
-            else
-            {
-                const size_t free_slot = m_free_slots.front();
-                m_free_slots.pop();
-                m_pager.hit(free_slot);
-                m_page_to_slot[page_no] = free_slot;
-                m_slot_to_page[free_slot] = page_no;
-
-                read_page(page_no, free_slot);
-
-                return (*m_cache)[free_slot * page_size + offset.get_block1()][offset.get_offset()];
-            }
-        }
-        else
-        {
-            m_pager.hit(cache_slot);
-            return (*m_cache)[cache_slot * page_size + offset.get_block1()][offset.get_offset()];
-        }
+        return (*m_cache)[m_slot_to_frame[cache_slot] * page_size + offset.get_block1()][offset.get_offset()];
     }
 
     bool is_page_cached(const blocked_index_type& offset) const
@@ -2304,6 +3405,344 @@ public:
 
 ////////////////////////////////////////////////////////////////////////////
 
+/*!
+ * Buffered reader with several independent sequential cursors into a vector,
+ * which share one pool of prefetch buffers.
+ *
+ * Each cursor reads an iterator range of the vector using overlapped I/O, the
+ * ranges may be disjoint or overlap, and each cursor may be used by a
+ * different thread. In contrast to one vector_bufreader per thread, the
+ * number of prefetch buffers is fixed for all cursors together. The buffers
+ * are split between the cursors in proportion to their recent consumption
+ * rate: fast cursors read further ahead, and slow ones do not hold buffers
+ * they do not need. Additionally, each cursor owns one block, which it reads
+ * synchronously if no prefetched block is available.
+ *
+ * A cursor fulfills all requirements of a stream:
+ * \code
+ * stxxl::vector<int>::multireader_type reader(vec, 64);
+ * // in each thread:
+ * stxxl::vector<int>::multireader_type::cursor c(reader, vec.begin() + a, vec.begin() + b);
+ * for ( ; !c.empty(); ++c) process(*c);
+ * \endcode
+ *
+ * The vector must not be modified while cursors are reading it, and all
+ * cursors must be destroyed before the reader.
+ */
+template <typename VectorIterator>
+class vector_multireader
+{
+public:
+    //! template parameter: the vector iterator type
+    using vector_iterator = VectorIterator;
+
+    //! value type of the output vector
+    using value_type = typename vector_iterator::value_type;
+
+    //! block type used in the vector
+    using block_type = typename vector_iterator::block_type;
+
+    //! type of the input vector
+    using vector_type = typename vector_iterator::vector_type;
+
+    //! block identifier iterator of the vector
+    using bids_container_iterator = typename vector_iterator::bids_container_iterator;
+
+    //! size of remaining data
+    using size_type = typename vector_type::size_type;
+
+    class cursor;
+
+protected:
+    //! vector to read
+    const vector_type& m_vector;
+
+    //! protects the pool and the consumption counters
+    mutable std::mutex m_mutex;
+
+    //! prefetch buffers shared by all cursors
+    tlx::simple_vector<block_type> m_blocks;
+
+    //! unused prefetch buffers
+    std::vector<block_type*> m_free;
+
+    //! registered cursors
+    std::vector<cursor*> m_cursors;
+
+    //! number of blocks recently consumed by all cursors
+    size_t m_consumed;
+
+    //! number of prefetch buffers a cursor may hold, lock must be held
+    size_t quota(const cursor& c) const
+    {
+        size_t q;
+        if (m_consumed == 0)
+            q = m_blocks.size() / m_cursors.size();
+        else
+            q = m_blocks.size() * c.m_consumed / m_consumed;
+        return std::max<size_t>(q, 1);
+    }
+
+    //! count a consumed block of a cursor and age all counters, such that
+    //! the split follows the current consumption rates. lock must be held.
+    void consumed(cursor& c)
+    {
+        ++c.m_consumed;
+        if (++m_consumed < 2 * (m_blocks.size() + m_cursors.size()))
+            return;
+
+        m_consumed = 0;
+        for (cursor* o : m_cursors) {
+            o->m_consumed /= 2;
+            m_consumed += o->m_consumed;
+        }
+    }
+
+public:
+    //! Create a reader for the vector with a pool of nbuffers prefetch
+    //! buffers for all cursors (>= 2*D recommended).
+    explicit vector_multireader(const vector_type& vec, size_t nbuffers = 0)
+        : m_vector(vec),
+          m_blocks(nbuffers ? nbuffers
+                   : 4 * foxxll::config::get_instance()->disks_number()),
+          m_consumed(0)
+    {
+        m_vector.flush();
+
+        m_free.reserve(m_blocks.size());
+        for (size_t i = 0; i < m_blocks.size(); ++i)
+            m_free.push_back(&m_blocks[i]);
+    }
+
+    //! non-copyable: delete copy-constructor
+    vector_multireader(const vector_multireader&) = delete;
+    //! non-copyable: delete assignment operator
+    vector_multireader& operator = (const vector_multireader&) = delete;
+
+    ~vector_multireader()
+    {
+        assert(m_cursors.empty());
+    }
+
+    //! Number of prefetch buffers shared by the cursors.
+    size_t nbuffers() const
+    {
+        return m_blocks.size();
+    }
+
+    //! Number of cursors.
+    size_t cursors() const
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_cursors.size();
+    }
+
+    /*!
+     * Sequential cursor over an iterator range of the vector, a model of
+     * stream. A cursor must be used by one thread at a time, different
+     * cursors of the same reader may be used concurrently.
+     */
+    class cursor
+    {
+        friend class vector_multireader;
+
+    protected:
+        //! a prefetched block
+        struct fetch
+        {
+            block_type* block;
+            foxxll::request_ptr req;
+        };
+
+        vector_multireader& m_reader;
+
+        //! next block to read
+        bids_container_iterator m_next_bid;
+
+        //! end of the blocks to read
+        bids_container_iterator m_end_bid;
+
+        //! number of remaining items
+        size_type m_remaining;
+
+        //! block which is read synchronously
+        tlx::simple_vector<block_type> m_own;
+
+        //! blocks being prefetched, in order
+        std::deque<fetch> m_fetches;
+
+        //! current block, either m_own or a prefetch buffer
+        block_type* m_current;
+
+        //! position in the current block
+        size_t m_pos;
+
+        //! number of blocks recently consumed, protected by the reader's mutex
+        size_t m_consumed;
+
+        //! return the current block to the pool if it is a prefetch buffer,
+        //! take buffers for further prefetches and issue them
+        void refill(bool release_current)
+        {
+            std::vector<block_type*> blocks;
+            {
+                std::unique_lock<std::mutex> lock(m_reader.m_mutex);
+                if (release_current)
+                {
+                    if (m_current != &m_own[0])
+                        m_reader.m_free.push_back(m_current);
+                    m_current = nullptr;
+                    m_reader.consumed(*this);
+                }
+
+                const size_t avail = static_cast<size_t>(m_end_bid - m_next_bid);
+                const size_t want = m_reader.quota(*this);
+                while (m_fetches.size() + blocks.size() < want &&
+                       blocks.size() < avail && !m_reader.m_free.empty())
+                {
+                    blocks.push_back(m_reader.m_free.back());
+                    m_reader.m_free.pop_back();
+                }
+            }
+
+            for (block_type* b : blocks) {
+                fetch f;
+                f.block = b;
+                f.req = b->read(*m_next_bid++);
+                m_fetches.push_back(f);
+            }
+        }
+
+        //! make the next block of the range current
+        void next_block(bool release_current)
+        {
+            refill(release_current);
+
+            if (!m_fetches.empty()) {
+                m_fetches.front().req->wait();
+                m_current = m_fetches.front().block;
+                m_fetches.pop_front();
+            }
+            else {
+                assert(m_next_bid != m_end_bid);
+                m_own[0].read(*m_next_bid++)->wait();
+                m_current = &m_own[0];
+            }
+            m_pos = 0;
+        }
+
+        //! return all buffers to the pool
+        void release()
+        {
+            for (fetch& f : m_fetches)
+                f.req->wait();
+
+            std::unique_lock<std::mutex> lock(m_reader.m_mutex);
+            for (fetch& f : m_fetches)
+                m_reader.m_free.push_back(f.block);
+            m_fetches.clear();
+            if (m_current && m_current != &m_own[0])
+                m_reader.m_free.push_back(m_current);
+            m_current = nullptr;
+        }
+
+    public:
+        //! Create a cursor reading [begin,end) of the reader's vector.
+        cursor(vector_multireader& reader, vector_iterator begin, vector_iterator end)
+            : m_reader(reader),
+              m_next_bid(begin.bid()),
+              m_end_bid(end.bid() + (end.block_offset() ? 1 : 0)),
+              m_remaining(static_cast<size_type>(end - begin)),
+              m_own(1),
+              m_current(nullptr),
+              m_pos(0),
+              m_consumed(0)
+        {
+            assert(begin.parent_vector() == &reader.m_vector);
+            assert(end.parent_vector() == &reader.m_vector);
+            {
+                std::unique_lock<std::mutex> lock(m_reader.m_mutex);
+                m_reader.m_cursors.push_back(this);
+            }
+
+            if (empty()) return;
+
+            next_block(false);
+            m_pos = begin.block_offset();
+        }
+
+        //! non-copyable: delete copy-constructor
+        cursor(const cursor&) = delete;
+        //! non-copyable: delete assignment operator
+        cursor& operator = (const cursor&) = delete;
+
+        ~cursor()
+        {
+            release();
+
+            std::unique_lock<std::mutex> lock(m_reader.m_mutex);
+            m_reader.m_cursors.erase(
+                std::find(m_reader.m_cursors.begin(), m_reader.m_cursors.end(), this));
+        }
+
+        //! Return constant reference to current item
+        const value_type& operator * () const
+        {
+            assert(!empty());
+            return (*m_current)[m_pos];
+        }
+
+        //! Return constant pointer to current item
+        const value_type* operator -> () const
+        {
+            return &(operator * ());
+        }
+
+        //! Advance to next item (asserts if !empty()).
+        cursor& operator ++ ()
+        {
+            assert(!empty());
+            --m_remaining;
+
+            if (TLX_UNLIKELY(empty()))
+                release();
+            else if (TLX_UNLIKELY(++m_pos == block_type::size))
+                next_block(true);
+
+            return *this;
+        }
+
+        //! Read current item into variable and advance to next one.
+        cursor& operator >> (value_type& v)
+        {
+            v = operator * ();
+            operator ++ ();
+
+            return *this;
+        }
+
+        //! Return remaining size.
+        size_type size() const
+        {
+            return m_remaining;
+        }
+
+        //! Returns true once the whole range has been read.
+        bool empty() const
+        {
+            return (m_remaining == 0);
+        }
+
+        //! Number of blocks currently being prefetched by this cursor.
+        size_t prefetching() const
+        {
+            return m_fetches.size();
+        }
+    };
+};
+
+////////////////////////////////////////////////////////////////////////////
+
 /*!
  * Buffered sequential writer to a vector using overlapped I/O.
  *
@@ -2460,6 +3899,9 @@ public:
                 // output position is start of block: create buffered writer
 
                 m_iter.flush(); // flush container
+                // copy the block if it is shared with snapshots, the
+                // following blocks are copied once they are reached.
+                m_iter.parent_vector()->unshare(m_iter, m_iter + 1);
 
                 // create buffered write stream for blocks
                 m_bufout = new buf_ostream_type(m_iter.bid(), m_nbuffers);
@@ -2475,6 +3917,7 @@ public:
             if (m_prevblk != m_iter) {
                 m_prevblk.block_externally_updated();
                 m_prevblk = m_iter;
+                m_iter.parent_vector()->unshare(m_iter, m_iter + 1);
             }
         }
 
@@ -110,6 +110,7 @@ stxxl::vector_iterator<VectorConfig> materialize(
         nbuffers = 2 * foxxll::config::get_instance()->disks_number();
 
     outbegin.flush();     // flush container
+    outbegin.parent_vector()->unshare(outbegin, outend);
 
     // create buffered write stream for blocks
     buf_ostream_type outstream(outbegin.bid(), nbuffers);
@@ -192,6 +193,7 @@ stxxl::vector_iterator<VectorConfig> materialize(
         nbuffers = 2 * foxxll::config::get_instance()->disks_number();
 
     out.flush();     // flush container
+    out.parent_vector()->unshare(out, out.parent_vector()->end());
 
     // create buffered write stream for blocks
     buf_ostream_type outstream(out.bid(), nbuffers);
@@ -0,0 +1,416 @@
+/***************************************************************************
+ *  include/stxxl/bits/stream/parse_lines.h
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#ifndef STXXL_STREAM_PARSE_LINES_HEADER
+#define STXXL_STREAM_PARSE_LINES_HEADER
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <tlx/define.hpp>
+#include <tlx/logger/core.hpp>
+
+#include <foxxll/common/error_handling.hpp>
+#include <foxxll/common/utils.hpp>
+#include <foxxll/io/file.hpp>
+#include <foxxll/io/request_operations.hpp>
+#include <foxxll/mng/config.hpp>
+#include <foxxll/mng/typed_block.hpp>
+
+#include <stxxl/bits/parallel.h>
+#include <stxxl/types>
+
+namespace stxxl {
+
+//! Stream package subnamespace.
+namespace stream {
+
+//! \addtogroup streampack
+//! \{
+
+////////////////////////////////////////////////////////////////////////
+//     PARSE LINES                                                    //
+////////////////////////////////////////////////////////////////////////
+
+/*!
+ * A model of stream that parses a newline-delimited text file into fixed-size
+ * records.
+ *
+ * The file is read in batches of ChunkSize byte chunks using asynchronous
+ * reads. Once a batch has arrived, each chunk is cut at its first and last
+ * newline and the chunks are parsed in parallel (with OpenMP) into per-chunk
+ * record buffers. Lines crossing a chunk border are assembled by the thread
+ * owning the preceding chunk, the incomplete line at the end of a batch is
+ * carried over into the next one. The reads for the next batch are issued
+ * right after parsing, hence I/O overlaps with consuming the records.
+ *
+ * The Parser is a functor with signature
+ * \code
+ * bool operator () (const char* begin, const char* end, value_type& out);
+ * \endcode
+ * which is given one line (without the trailing newline) and returns false if
+ * the line should be skipped. Each thread works on its own copy of the parser.
+ *
+ * With \c ordered = true, records are emitted in file order. If the consumer
+ * does not care about order (e.g. a \c runs_creator or \c sorter), pass \c
+ * ordered = false: records of one chunk stay together but chunks are emitted
+ * in the order their parsing finished.
+ *
+ * \warning No single line may be longer than ChunkSize bytes.
+ *
+ * \tparam Parser line parsing functor
+ * \tparam ValueType type of the records, default is \c Parser::value_type
+ * \tparam ChunkSize size of a single read request in bytes, must be a multiple of 4096
+ */
+template <typename Parser,
+          typename ValueType = typename Parser::value_type,
+          size_t ChunkSize = 4* 1024* 1024>
+class parse_lines
+{
+    static constexpr bool debug = false;
+
+    static_assert(ChunkSize % 4096 == 0, "ChunkSize must be a multiple of 4096");
+
+public:
+    //! Standard stream typedef.
+    using value_type = ValueType;
+    using parser_type = Parser;
+    using size_type = external_size_type;
+
+    //! aligned buffer type used for the asynchronous reads
+    using chunk_type = foxxll::typed_block<ChunkSize, char>;
+
+protected:
+    //! the file to parse
+    foxxll::file_ptr m_file;
+
+    //! size of the file in bytes
+    size_type m_file_size;
+
+    //! next file offset to read
+    size_type m_read_pos;
+
+    //! prototype parser, copied by each thread
+    parser_type m_parser;
+
+    //! emit records in file order
+    bool m_ordered;
+
+    //! read buffers of the current batch
+    std::vector<chunk_type*> m_chunks;
+
+    //! outstanding read requests of the current batch
+    std::vector<foxxll::request_ptr> m_reqs;
+
+    //! number of valid bytes in each chunk of the current batch
+    std::vector<size_t> m_chunk_bytes;
+
+    //! number of chunks in the current batch
+    size_t m_batch_chunks;
+
+    //! incomplete line at the end of the previous batch
+    std::string m_carry;
+
+    //! parsed records of each chunk of the batch
+    std::vector<std::vector<value_type> > m_pieces;
+
+    //! order in which the pieces are emitted
+    std::vector<size_t> m_order;
+
+    //! index into m_order of the piece currently emitted
+    size_t m_piece;
+
+    //! current record and end of current piece
+    const value_type* m_current;
+    const value_type* m_current_end;
+
+protected:
+    //! Issue asynchronous reads for the next batch of chunks.
+    void issue_reads()
+    {
+        m_batch_chunks = 0;
+        while (m_batch_chunks < m_chunks.size() && m_read_pos < m_file_size)
+        {
+            const size_t bytes = static_cast<size_t>(
+                std::min<size_type>(ChunkSize, m_file_size - m_read_pos));
+            // round up to keep the request aligned for direct I/O; reading
+            // beyond the end of the file stops short.
+            const size_t req_bytes = foxxll::div_ceil(bytes, 4096) * 4096;
+
+            TLX_LOG << "parse_lines: read chunk " << m_batch_chunks
+                    << " @ " << m_read_pos << " bytes " << bytes;
+
+            m_reqs[m_batch_chunks] = m_file->aread(
+                m_chunks[m_batch_chunks]->begin(), m_read_pos, req_bytes);
+            m_chunk_bytes[m_batch_chunks] = bytes;
+            m_read_pos += bytes;
+            ++m_batch_chunks;
+        }
+    }
+
+    //! Parse one line and append the resulting record.
+    static void parse_line(parser_type& parser, const char* begin, const char* end,
+                           std::vector<value_type>& out)
+    {
+        value_type v;
+        if (parser(begin, end, v))
+            out.push_back(v);
+    }
+
+    //! Parse the lines owned by chunk j of the current batch.
+    void parse_piece(size_t j, const std::vector<const char*>& head_end,
+                     const std::vector<const char*>& tail_begin, bool last_batch)
+    {
+        parser_type parser = m_parser;
+        std::vector<value_type>& out = m_pieces[j];
+        out.clear();
+
+        const char* begin = m_chunks[j]->begin();
+        const char* end = begin + m_chunk_bytes[j];
+
+        // first piece completes the line carried over from the last batch
+        if (j == 0)
+        {
+            if (m_carry.empty()) {
+                parse_line(parser, begin, head_end[0], out);
+            }
+            else {
+                std::string line = m_carry;
+                line.append(begin, head_end[0]);
+                parse_line(parser, line.data(), line.data() + line.size(), out);
+            }
+        }
+
+        // complete lines inside the chunk
+        const char* line = (head_end[j] == end) ? end : head_end[j] + 1;
+        while (line < tail_begin[j])
+        {
+            const char* eol = static_cast<const char*>(
+                std::memchr(line, '\n', tail_begin[j] - line));
+            assert(eol);
+            parse_line(parser, line, eol, out);
+            line = eol + 1;
+        }
+
+        // line crossing into the next chunk
+        if (j + 1 < m_batch_chunks)
+        {
+            const char* next = m_chunks[j + 1]->begin();
+            std::string cross(tail_begin[j], end);
+            cross.append(next, head_end[j + 1]);
+            parse_line(parser, cross.data(), cross.data() + cross.size(), out);
+        }
+        else if (last_batch && tail_begin[j] != end)
+        {
+            // unterminated last line of the file
+            parse_line(parser, tail_begin[j], end, out);
+        }
+    }
+
+    //! Wait for the current batch, parse it in parallel and start reading the
+    //! next one.
+    void parse_batch()
+    {
+        assert(m_batch_chunks > 0);
+        foxxll::wait_all(m_reqs.data(), m_batch_chunks);
+
+        const bool last_batch = (m_read_pos == m_file_size);
+
+        // locate the first and the last newline of each chunk. A chunk
+        // without any newline is only allowed at the very end of the file.
+        std::vector<const char*> head_end(m_batch_chunks), tail_begin(m_batch_chunks);
+        for (size_t j = 0; j < m_batch_chunks; ++j)
+        {
+            const char* begin = m_chunks[j]->begin();
+            const char* end = begin + m_chunk_bytes[j];
+
+            const char* nl = static_cast<const char*>(
+                std::memchr(begin, '\n', end - begin));
+
+            if (!nl)
+            {
+                if (!(last_batch && j + 1 == m_batch_chunks)) {
+                    throw foxxll::bad_parameter(
+                              "stream::parse_lines: line longer than ChunkSize found, increase ChunkSize");
+                }
+                head_end[j] = end;
+                tail_begin[j] = end;
+                continue;
+            }
+
+            head_end[j] = nl;
+
+            const char* last = end;
+            while (last[-1] != '\n')
+                --last;
+            tail_begin[j] = last;
+        }
+
+        m_pieces.resize(m_batch_chunks);
+        m_order.resize(m_batch_chunks);
+
+        std::atomic<size_t> done(0);
+
+#if STXXL_PARALLEL
+        #pragma omp parallel for schedule(dynamic)
+#endif
+        for (size_t j = 0; j < m_batch_chunks; ++j)
+        {
+            parse_piece(j, head_end, tail_begin, last_batch);
+            if (!m_ordered)
+                m_order[done++] = j;
+        }
+
+        if (m_ordered) {
+            for (size_t j = 0; j < m_batch_chunks; ++j)
+                m_order[j] = j;
+        }
+
+        // carry the incomplete line into the next batch
+        const char* last_end = m_chunks[m_batch_chunks - 1]->begin()
+                               + m_chunk_bytes[m_batch_chunks - 1];
+        if (!last_batch)
+            m_carry.assign(tail_begin[m_batch_chunks - 1], last_end);
+        else
+            m_carry.clear();
+
+        // buffers are free again: start reading the next batch
+        issue_reads();
+
+        m_piece = 0;
+    }
+
+    //! Point m_current to the first non-empty piece, starting at m_piece,
+    //! parsing more batches if needed.
+    void set_piece()
+    {
+        for ( ; ; )
+        {
+            for ( ; m_piece < m_order.size(); ++m_piece)
+            {
+                const std::vector<value_type>& p = m_pieces[m_order[m_piece]];
+                if (!p.empty()) {
+                    m_current = p.data();
+                    m_current_end = p.data() + p.size();
+                    return;
+                }
+            }
+
+            if (m_batch_chunks == 0) {
+                // end of file reached
+                m_current = m_current_end = nullptr;
+                return;
+            }
+
+            parse_batch();
+        }
+    }
+
+public:
+    //! Create a parsing stream over a file.
+    //! \param file file to parse, should be opened with foxxll::file::RDONLY
+    //! \param parser line parsing functor
+    //! \param num_chunks number of chunks per batch (0 is default, which
+    //! equals to the larger of 2 * number of threads and 2 * number of disks)
+    //! \param ordered emit records in file order
+    explicit parse_lines(foxxll::file_ptr file,
+                         const parser_type& parser = parser_type(),
+                         size_t num_chunks = 0, bool ordered = true)
+        : m_file(file),
+          m_file_size(file->size()),
+          m_read_pos(0),
+          m_parser(parser),
+          m_ordered(ordered),
+          m_batch_chunks(0),
+          m_piece(0),
+          m_current(nullptr), m_current_end(nullptr)
+    {
+        if (num_chunks == 0)
+        {
+            num_chunks = 2 * foxxll::config::get_instance()->disks_number();
+#if STXXL_PARALLEL
+            num_chunks = std::max<size_t>(num_chunks, 2 * omp_get_max_threads());
+#endif
+        }
+
+        m_chunks.resize(num_chunks);
+        for (size_t i = 0; i < num_chunks; ++i)
+            m_chunks[i] = new chunk_type;
+        m_reqs.resize(num_chunks);
+        m_chunk_bytes.resize(num_chunks);
+
+        issue_reads();
+        set_piece();
+    }
+
+    //! non-copyable: delete copy-constructor
+    parse_lines(const parse_lines&) = delete;
+    //! non-copyable: delete assignment operator
+    parse_lines& operator = (const parse_lines&) = delete;
+
+    ~parse_lines()
+    {
+        try
+        {
+            if (m_batch_chunks > 0)
+                foxxll::wait_all(m_reqs.data(), m_batch_chunks);
+        }
+        catch (const foxxll::io_error&)
+        { }
+
+        for (size_t i = 0; i < m_chunks.size(); ++i)
+            delete m_chunks[i];
+    }
+
+    //! Standard stream method.
+    const value_type& operator * () const
+    {
+        assert(!empty());
+        return *m_current;
+    }
+
+    //! Standard stream method.
+    const value_type* operator -> () const
+    {
+        return &(operator * ());
+    }
+
+    //! Standard stream method.
+    parse_lines& operator ++ ()
+    {
+        assert(!empty());
+        ++m_current;
+
+        if (TLX_UNLIKELY(m_current == m_current_end))
+        {
+            ++m_piece;
+            set_piece();
+        }
+
+        return *this;
+    }
+
+    //! Standard stream method.
+    bool empty() const
+    {
+        return (m_current == m_current_end);
+    }
+};
+
+//! \}
+
+} // namespace stream
+} // namespace stxxl
+
+#endif // !STXXL_STREAM_PARSE_LINES_HEADER
@@ -0,0 +1,250 @@
+/***************************************************************************
+ *  include/stxxl/bits/stream/pipeline.h
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#ifndef STXXL_STREAM_PIPELINE_HEADER
+#define STXXL_STREAM_PIPELINE_HEADER
+
+#include <cassert>
+#include <type_traits>
+#include <utility>
+
+namespace stxxl {
+
+//! Stream package subnamespace.
+namespace stream {
+
+//! \addtogroup streampack
+//! \{
+
+////////////////////////////////////////////////////////////////////////
+//     PIPELINE                                                       //
+////////////////////////////////////////////////////////////////////////
+
+/*!
+ * \name Fused pipeline stages
+ *
+ * Stateless map and filter stages which are composed at compile time with
+ * operator| and applied to a stream by a single \c pipeline object:
+ * \code
+ * auto stages = stream::map_op([](int x) { return x * 3; })
+ *             | stream::filter_op([](int x) { return x % 2 == 0; })
+ *             | stream::map_op([](int x) { return std::to_string(x); });
+ * auto s = stream::make_pipeline(input, stages);
+ * \endcode
+ *
+ * Each stage pushes its result directly into the next one, hence the whole
+ * chain is inlined into one loop over the input stream. In contrast to
+ * nesting \c transform (or similar) stream objects, intermediate items are
+ * not stored in each stage and empty() is checked only once per input item.
+ * \{
+ */
+
+//! CRTP base of all fusable pipeline stages, enables operator|.
+template <typename Derived>
+class pipeline_stage
+{ };
+
+//! Pipeline stage applying a functor to each item.
+template <typename Function>
+class map_stage : public pipeline_stage<map_stage<Function> >
+{
+    Function m_fn;
+
+public:
+    explicit map_stage(const Function& fn) : m_fn(fn) { }
+
+    //! output type of the stage for input type In
+    template <typename In>
+    struct result {
+        using type = typename std::decay<
+                  decltype(std::declval<Function&>()(std::declval<const In&>()))>::type;
+    };
+
+    //! pass x through the stage into sink
+    template <typename In, typename Sink>
+    void push(const In& x, Sink&& sink)
+    {
+        sink(m_fn(x));
+    }
+};
+
+//! Pipeline stage dropping all items for which a predicate is false.
+template <typename Predicate>
+class filter_stage : public pipeline_stage<filter_stage<Predicate> >
+{
+    Predicate m_pred;
+
+public:
+    explicit filter_stage(const Predicate& pred) : m_pred(pred) { }
+
+    //! output type of the stage for input type In
+    template <typename In>
+    struct result {
+        using type = In;
+    };
+
+    //! pass x through the stage into sink
+    template <typename In, typename Sink>
+    void push(const In& x, Sink&& sink)
+    {
+        if (m_pred(x))
+            sink(x);
+    }
+};
+
+//! Composition of two pipeline stages, created by operator|.
+template <typename First, typename Second>
+class stage_chain : public pipeline_stage<stage_chain<First, Second> >
+{
+    First m_first;
+    Second m_second;
+
+public:
+    stage_chain(const First& first, const Second& second)
+        : m_first(first), m_second(second) { }
+
+    //! output type of the chain for input type In
+    template <typename In>
+    struct result {
+        using type = typename Second::template result<
+                  typename First::template result<In>::type>::type;
+    };
+
+    //! pass x through both stages into sink
+    template <typename In, typename Sink>
+    void push(const In& x, Sink&& sink)
+    {
+        m_first.push(x, [this, &sink](const auto& y) { m_second.push(y, sink); });
+    }
+};
+
+//! Create a map stage applying fn to each item.
+template <typename Function>
+map_stage<Function> map_op(const Function& fn)
+{
+    return map_stage<Function>(fn);
+}
+
+//! Create a filter stage passing only the items for which pred is true.
+template <typename Predicate>
+filter_stage<Predicate> filter_op(const Predicate& pred)
+{
+    return filter_stage<Predicate>(pred);
+}
+
+//! Compose two pipeline stages.
+template <typename First, typename Second>
+stage_chain<First, Second>
+operator | (const pipeline_stage<First>& first, const pipeline_stage<Second>& second)
+{
+    return stage_chain<First, Second>(
+        static_cast<const First&>(first), static_cast<const Second&>(second));
+}
+
+/*!
+ * A model of stream that applies a fused chain of pipeline stages to an
+ * input stream.
+ *
+ * The input stream is advanced past each item as soon as the item was pushed
+ * through the stages, hence it is ahead of this stream by up to one item.
+ *
+ * \tparam Input type of the input stream
+ * \tparam Stages type of the stage chain, e.g. created by map_op(), filter_op()
+ * and operator|
+ */
+template <typename Input, typename Stages>
+class pipeline
+{
+public:
+    //! Standard stream typedef.
+    using value_type = typename Stages::template result<
+              typename Input::value_type>::type;
+
+protected:
+    Input& m_input;
+    Stages m_stages;
+    value_type m_current;
+    bool m_empty;
+
+    //! push input items through the stages until one comes out
+    void fetch()
+    {
+        bool found = false;
+        while (!found && !m_input.empty())
+        {
+            m_stages.push(*m_input, [this, &found](const value_type& v) {
+                              m_current = v;
+                              found = true;
+                          });
+            ++m_input;
+        }
+        m_empty = !found;
+    }
+
+public:
+    pipeline(Input& input, const Stages& stages)
+        : m_input(input), m_stages(stages), m_empty(false)
+    {
+        fetch();
+    }
+
+    //! Standard stream method.
+    const value_type& operator * () const
+    {
+        assert(!empty());
+        return m_current;
+    }
+
+    //! Standard stream method.
+    const value_type* operator -> () const
+    {
+        return &(operator * ());
+    }
+
+    //! Standard stream method.
+    pipeline& operator ++ ()
+    {
+        assert(!empty());
+        fetch();
+        return *this;
+    }
+
+    //! Standard stream method.
+    bool empty() const
+    {
+        return m_empty;
+    }
+};
+
+//! Apply a chain of pipeline stages to an input stream.
+template <typename Input, typename Stages>
+pipeline<Input, Stages> make_pipeline(Input& input, const pipeline_stage<Stages>& stages)
+{
+    return pipeline<Input, Stages>(input, static_cast<const Stages&>(stages));
+}
+
+//! Push all items of an input stream through a chain of pipeline stages into
+//! a sink functor, without materializing the items in a stream object.
+template <typename Input, typename Stages, typename Sink>
+void run_pipeline(Input& input, const pipeline_stage<Stages>& stages, Sink sink)
+{
+    Stages s = static_cast<const Stages&>(stages);
+    for ( ; !input.empty(); ++input)
+        s.push(*input, sink);
+}
+
+//! \}
+
+//! \}
+
+} // namespace stream
+} // namespace stxxl
+
+#endif // !STXXL_STREAM_PIPELINE_HEADER
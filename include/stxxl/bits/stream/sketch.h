@@ -0,0 +1,484 @@
+/***************************************************************************
+ *  include/stxxl/bits/stream/sketch.h
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#ifndef STXXL_STREAM_SKETCH_HEADER
+#define STXXL_STREAM_SKETCH_HEADER
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <tlx/math/clz.hpp>
+
+#include <foxxll/common/error_handling.hpp>
+
+#include <stxxl/bits/common/seed.h>
+
+namespace stxxl {
+
+//! Stream package subnamespace.
+namespace stream {
+
+//! \addtogroup streampack
+//! \{
+
+////////////////////////////////////////////////////////////////////////
+//     SKETCHES                                                       //
+////////////////////////////////////////////////////////////////////////
+
+//! \internal
+//! Finalizer of MurmurHash3 to spread the bits of weak hash functions (like
+//! std::hash on integers, which is the identity).
+static inline uint64_t sketch_mix_hash(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/*!
+ * HyperLogLog sketch estimating the number of distinct items.
+ *
+ * Uses 2^precision one-byte registers, the standard error of the estimate is
+ * about 1.04 / sqrt(2^precision), i.e. 0.8% for the default precision 14
+ * (16 KiB of registers). Sketches with equal precision can be merged, the
+ * result equals the sketch of the union of both inputs.
+ *
+ * \tparam ValueType type of the counted items
+ * \tparam Hash hash function object for ValueType
+ */
+template <typename ValueType, typename Hash = std::hash<ValueType> >
+class hyperloglog
+{
+public:
+    using value_type = ValueType;
+    using hash_type = Hash;
+
+protected:
+    //! number of index bits
+    unsigned m_precision;
+
+    //! maximum number of leading zeros plus one seen for each register
+    std::vector<uint8_t> m_registers;
+
+    hash_type m_hash;
+
+public:
+    //! Create an empty sketch with 2^precision registers, 4 <= precision <= 18.
+    explicit hyperloglog(unsigned precision = 14, const hash_type& hash = hash_type())
+        : m_precision(precision), m_hash(hash)
+    {
+        if (precision < 4 || precision > 18)
+            throw foxxll::bad_parameter("stream::hyperloglog: precision must be in [4,18]");
+        m_registers.resize(size_t(1) << precision, 0);
+    }
+
+    //! Add an item to the sketch.
+    void insert(const value_type& v)
+    {
+        const uint64_t h = sketch_mix_hash(static_cast<uint64_t>(m_hash(v)));
+        const size_t idx = static_cast<size_t>(h >> (64 - m_precision));
+        const uint64_t w = h << m_precision;
+
+        const uint8_t rank = static_cast<uint8_t>(
+            w == 0 ? 64 - m_precision + 1 : tlx::clz(w) + 1);
+
+        if (rank > m_registers[idx])
+            m_registers[idx] = rank;
+    }
+
+    //! Merge another sketch into this one.
+    void merge(const hyperloglog& other)
+    {
+        if (other.m_precision != m_precision)
+            throw foxxll::bad_parameter("stream::hyperloglog: cannot merge sketches of different precision");
+
+        for (size_t i = 0; i < m_registers.size(); ++i)
+            m_registers[i] = std::max(m_registers[i], other.m_registers[i]);
+    }
+
+    //! Estimate the number of distinct items inserted.
+    double estimate() const
+    {
+        const double m = static_cast<double>(m_registers.size());
+
+        double sum = 0;
+        size_t zeros = 0;
+        for (const uint8_t& r : m_registers) {
+            sum += std::ldexp(1.0, -static_cast<int>(r));
+            if (r == 0) ++zeros;
+        }
+
+        double alpha;
+        if (m_registers.size() == 16) alpha = 0.673;
+        else if (m_registers.size() == 32) alpha = 0.697;
+        else if (m_registers.size() == 64) alpha = 0.709;
+        else alpha = 0.7213 / (1.0 + 1.079 / m);
+
+        const double e = alpha * m * m / sum;
+
+        // small range correction: linear counting
+        if (e <= 2.5 * m && zeros != 0)
+            return m * std::log(m / static_cast<double>(zeros));
+
+        return e;
+    }
+
+    //! Reset to an empty sketch.
+    void clear()
+    {
+        std::fill(m_registers.begin(), m_registers.end(), 0);
+    }
+
+    //! Number of index bits.
+    unsigned precision() const { return m_precision; }
+};
+
+/*!
+ * Count-min sketch estimating the frequency of items, optionally tracking the
+ * k most frequent items (heavy hitters).
+ *
+ * The estimate never underestimates; with width w and depth d it
+ * overestimates by more than e/w * N (N = total count) with probability at
+ * most exp(-d). Sketches with equal dimensions can be merged by adding the
+ * counters, the heavy hitter candidates are re-ranked using the merged
+ * counters.
+ *
+ * \tparam ValueType type of the counted items
+ * \tparam Hash hash function object for ValueType
+ */
+template <typename ValueType, typename Hash = std::hash<ValueType> >
+class count_min
+{
+public:
+    using value_type = ValueType;
+    using hash_type = Hash;
+    using counter_type = uint64_t;
+    using heavy_hitter_type = std::pair<value_type, counter_type>;
+
+protected:
+    //! number of counters per row
+    size_t m_width;
+
+    //! number of rows
+    size_t m_depth;
+
+    //! m_depth rows of m_width counters
+    std::vector<counter_type> m_counters;
+
+    //! total count of all inserted items
+    counter_type m_total;
+
+    //! maximum number of tracked heavy hitters
+    size_t m_num_heavy;
+
+    //! heavy hitter candidates with their estimates
+    std::vector<heavy_hitter_type> m_heavy;
+
+    hash_type m_hash;
+
+    //! index of the counter of the item with hash h in row i
+    size_t cell(uint64_t h, size_t i) const
+    {
+        // derive the row hashes from two halves (Kirsch and Mitzenmacher)
+        const uint64_t h1 = h & 0xFFFFFFFF, h2 = h >> 32;
+        return i * m_width + static_cast<size_t>((h1 + i * h2) % m_width);
+    }
+
+    counter_type estimate_hash(uint64_t h) const
+    {
+        counter_type est = std::numeric_limits<counter_type>::max();
+        for (size_t i = 0; i < m_depth; ++i)
+            est = std::min(est, m_counters[cell(h, i)]);
+        return est;
+    }
+
+    //! update the heavy hitter candidates with a new estimate of v
+    void update_heavy(const value_type& v, counter_type est)
+    {
+        if (m_num_heavy == 0)
+            return;
+
+        size_t min_pos = 0;
+        for (size_t j = 0; j < m_heavy.size(); ++j)
+        {
+            if (m_heavy[j].first == v) {
+                m_heavy[j].second = est;
+                return;
+            }
+            if (m_heavy[j].second < m_heavy[min_pos].second)
+                min_pos = j;
+        }
+
+        if (m_heavy.size() < m_num_heavy)
+            m_heavy.emplace_back(v, est);
+        else if (est > m_heavy[min_pos].second)
+            m_heavy[min_pos] = heavy_hitter_type(v, est);
+    }
+
+public:
+    //! Create an empty sketch.
+    //! \param width number of counters per row, determines the error
+    //! \param depth number of rows, determines the error probability
+    //! \param num_heavy number of heavy hitters to track (0 disables tracking)
+    explicit count_min(size_t width = 2048, size_t depth = 4, size_t num_heavy = 0,
+                       const hash_type& hash = hash_type())
+        : m_width(width), m_depth(depth),
+          m_counters(width * depth, 0), m_total(0),
+          m_num_heavy(num_heavy), m_hash(hash)
+    {
+        if (width == 0 || depth == 0)
+            throw foxxll::bad_parameter("stream::count_min: width and depth must be positive");
+        m_heavy.reserve(num_heavy);
+    }
+
+    //! Add count occurrences of an item to the sketch.
+    void insert(const value_type& v, counter_type count = 1)
+    {
+        const uint64_t h = sketch_mix_hash(static_cast<uint64_t>(m_hash(v)));
+
+        counter_type est = std::numeric_limits<counter_type>::max();
+        for (size_t i = 0; i < m_depth; ++i) {
+            counter_type& c = m_counters[cell(h, i)];
+            c += count;
+            est = std::min(est, c);
+        }
+        m_total += count;
+
+        update_heavy(v, est);
+    }
+
+    //! Estimate the number of occurrences of an item.
+    counter_type estimate(const value_type& v) const
+    {
+        return estimate_hash(sketch_mix_hash(static_cast<uint64_t>(m_hash(v))));
+    }
+
+    //! Merge another sketch into this one.
+    void merge(const count_min& other)
+    {
+        if (other.m_width != m_width || other.m_depth != m_depth)
+            throw foxxll::bad_parameter("stream::count_min: cannot merge sketches of different dimensions");
+
+        for (size_t i = 0; i < m_counters.size(); ++i)
+            m_counters[i] += other.m_counters[i];
+        m_total += other.m_total;
+
+        // re-estimate all candidates with the merged counters
+        std::vector<heavy_hitter_type> candidates;
+        candidates.swap(m_heavy);
+        candidates.insert(candidates.end(), other.m_heavy.begin(), other.m_heavy.end());
+        for (const heavy_hitter_type& c : candidates)
+            update_heavy(c.first, estimate(c.first));
+    }
+
+    //! Tracked heavy hitters with their estimated counts, most frequent first.
+    std::vector<heavy_hitter_type> heavy_hitters() const
+    {
+        std::vector<heavy_hitter_type> res = m_heavy;
+        std::sort(res.begin(), res.end(),
+                  [](const heavy_hitter_type& a, const heavy_hitter_type& b) {
+                      return a.second > b.second;
+                  });
+        return res;
+    }
+
+    //! Total count of all inserted items.
+    counter_type total() const { return m_total; }
+
+    //! Reset to an empty sketch.
+    void clear()
+    {
+        std::fill(m_counters.begin(), m_counters.end(), 0);
+        m_total = 0;
+        m_heavy.clear();
+    }
+};
+
+/*!
+ * Uniform random sample of fixed size of all inserted items (reservoir
+ * sampling, Vitter's algorithm R).
+ *
+ * Two reservoirs can be merged, the result is a uniform sample of the union
+ * of both inputs.
+ *
+ * \tparam ValueType type of the sampled items
+ */
+template <typename ValueType>
+class reservoir_sample
+{
+public:
+    using value_type = ValueType;
+    using size_type = uint64_t;
+
+protected:
+    //! maximum number of samples
+    size_t m_capacity;
+
+    //! number of items seen
+    size_type m_seen;
+
+    //! the samples
+    std::vector<value_type> m_samples;
+
+    std::mt19937_64 m_rng;
+
+public:
+    //! Create an empty reservoir holding up to capacity samples.
+    explicit reservoir_sample(size_t capacity,
+                              unsigned seed = seed_sequence::get_ref().get_next_seed())
+        : m_capacity(capacity), m_seen(0), m_rng(seed)
+    {
+        m_samples.reserve(capacity);
+    }
+
+    //! Offer an item to the reservoir.
+    void insert(const value_type& v)
+    {
+        ++m_seen;
+        if (m_samples.size() < m_capacity) {
+            m_samples.push_back(v);
+            return;
+        }
+
+        std::uniform_int_distribution<size_type> dist(0, m_seen - 1);
+        const size_type r = dist(m_rng);
+        if (r < m_capacity)
+            m_samples[static_cast<size_t>(r)] = v;
+    }
+
+    //! Merge another reservoir into this one. Each sample is drawn from
+    //! either input with a probability proportional to the number of items
+    //! the input has seen and not yet been accounted for.
+    void merge(const reservoir_sample& other)
+    {
+        std::vector<value_type> a, b;
+        a.swap(m_samples);
+        b = other.m_samples;
+
+        size_type seen_a = m_seen, seen_b = other.m_seen;
+        m_seen += other.m_seen;
+
+        const size_t k = std::min<size_t>(m_capacity, a.size() + b.size());
+        m_samples.reserve(m_capacity);
+
+        while (m_samples.size() < k)
+        {
+            std::uniform_int_distribution<size_type> dist(0, seen_a + seen_b - 1);
+            std::vector<value_type>& src = (dist(m_rng) < seen_a) ? a : b;
+            size_type& seen = (&src == &a) ? seen_a : seen_b;
+
+            assert(!src.empty());
+            std::uniform_int_distribution<size_t> pick(0, src.size() - 1);
+            const size_t j = pick(m_rng);
+            m_samples.push_back(src[j]);
+            std::swap(src[j], src.back());
+            src.pop_back();
+
+            // each remaining sample represents seen / (size + 1) items
+            seen = src.empty() ? 0 : seen - seen / (src.size() + 1);
+        }
+    }
+
+    //! The current samples.
+    const std::vector<value_type>& samples() const { return m_samples; }
+
+    //! Number of items seen.
+    size_type seen() const { return m_seen; }
+
+    //! Reset to an empty reservoir.
+    void clear()
+    {
+        m_samples.clear();
+        m_seen = 0;
+    }
+};
+
+/*!
+ * Pass-through stream which inserts every item of the input stream into a
+ * sketch (or any object with an insert(const value_type&) method) while
+ * forwarding it unchanged.
+ *
+ * Chaining sketches in front of e.g. a \c runs_creator gathers statistics
+ * about the data without an extra pass, which can be used to size the
+ * memory of later phases. The sketch is held by reference and remains valid
+ * after the stream is consumed.
+ *
+ * \tparam Input type of the input stream
+ * \tparam Sketch type of the sketch, e.g. \c hyperloglog, \c count_min or \c
+ * reservoir_sample
+ */
+template <class Input, class Sketch>
+class sketch
+{
+public:
+    //! Standard stream typedef.
+    using value_type = typename Input::value_type;
+    using sketch_type = Sketch;
+
+protected:
+    Input& m_input;
+    sketch_type& m_sketch;
+
+public:
+    sketch(Input& input, sketch_type& sk)
+        : m_input(input), m_sketch(sk)
+    {
+        if (!m_input.empty())
+            m_sketch.insert(*m_input);
+    }
+
+    //! Standard stream method, returns whatever the input stream returns.
+    decltype(auto) operator * () const
+    {
+        return *m_input;
+    }
+
+    //! Standard stream method.
+    sketch& operator ++ ()
+    {
+        ++m_input;
+        if (!m_input.empty())
+            m_sketch.insert(*m_input);
+        return *this;
+    }
+
+    //! Standard stream method.
+    bool empty() const
+    {
+        return m_input.empty();
+    }
+
+    //! Returns the sketch.
+    sketch_type& get_sketch() const { return m_sketch; }
+};
+
+//! Convenience function creating a pass-through \c sketch stream.
+template <class Input, class Sketch>
+sketch<Input, Sketch> make_sketch(Input& input, Sketch& sk)
+{
+    return sketch<Input, Sketch>(input, sk);
+}
+
+//! \}
+
+} // namespace stream
+} // namespace stxxl
+
+#endif // !STXXL_STREAM_SKETCH_HEADER
@@ -19,6 +19,7 @@
 #include <algorithm>
 #include <cassert>
 #include <functional>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -27,6 +28,8 @@
 #include <tlx/logger/core.hpp>
 
 #include <foxxll/mng/block_manager.hpp>
+#include <foxxll/mng/config.hpp>
+#include <foxxll/mng/write_pool.hpp>
 
 #include <stxxl/bits/algo/losertree.h>
 #include <stxxl/bits/algo/run_cursor.h>
@@ -1329,6 +1332,37 @@ public:
         return m_elements_remaining;
     }
 
+    //! Returns true if the current buffer block has not been consumed yet,
+    //! i.e. the next items can be taken as whole blocks via
+    //! swap_buffer_block().
+    bool is_block_aligned() const
+    {
+        return !empty() && m_current_ptr == m_buffer_block->elem;
+    }
+
+    //! Hand out the buffer block holding the next merged items and merge the
+    //! following items directly into \c blk, which becomes the new buffer
+    //! block of the merger. This allows writing the merger's output without
+    //! copying it.
+    //! \param blk in: an unused block, out: block holding the merged items
+    //! \return number of valid items in the returned block
+    //! \pre is_block_aligned()
+    size_t swap_buffer_block(out_block_type*& blk)
+    {
+        assert(is_block_aligned());
+
+        const size_t n = static_cast<size_t>(m_current_end - m_current_ptr);
+        std::swap(blk, m_buffer_block);
+        m_elements_remaining -= n;
+
+        if (!empty())
+            fill_buffer_block();
+        else
+            m_current_ptr = m_current_end = m_buffer_block->elem;
+
+        return n;
+    }
+
     //! Standard stream method.
     const value_type& operator * () const
     {
@@ -1415,6 +1449,7 @@ void basic_runs_merger<RunsType, CompareType, AllocStr>::merge_recursively()
         // m_sruns
 
         sorted_runs_data_type new_runs;
+        new_runs.file = m_sruns->file;
         new_runs.runs.resize(new_nruns);
         new_runs.runs_sizes.resize(new_nruns);
         new_runs.elements = m_sruns->elements;
@@ -1452,6 +1487,7 @@ void basic_runs_merger<RunsType, CompareType, AllocStr>::merge_recursively()
                 // This sorted_runs is copied a subset of the over-large set of runs, which
                 // will be deallocated from external memory once the runs are merged.
                 sorted_runs_type cur_runs(new sorted_runs_data_type);
+                cur_runs->file = m_sruns->file;
                 cur_runs->runs.resize(runs2merge);
                 cur_runs->runs_sizes.resize(runs2merge);
 
@@ -1567,6 +1603,95 @@ public:
     { }
 };
 
+//! \internal
+//! Stores the merger's items via the vector's buffered output stream.
+template <typename RunsMerger, typename VectorType>
+bool materialize_runs_merger(RunsMerger& in, VectorType& out,
+                             size_t nbuffers, std::false_type)
+{
+    out.clear();
+    out.resize(in.size());
+    materialize(in, out.begin(), nbuffers);
+    return false;
+}
+
+//! \internal
+//! Writes the merger's buffer blocks directly as the blocks of the vector.
+template <typename RunsMerger, typename VectorType>
+bool materialize_runs_merger(RunsMerger& in, VectorType& out,
+                             size_t nbuffers, std::true_type)
+{
+    using block_type = typename VectorType::block_type;
+    using bid_type = typename VectorType::bids_container_type::bid_type;
+
+    // file-backed vectors cannot adopt blocks, and a partially consumed
+    // merger is no longer block aligned.
+    if (out.get_file() || (!in.empty() && !in.is_block_aligned()))
+        return materialize_runs_merger(in, out, nbuffers, std::false_type());
+
+    const typename VectorType::size_type n = in.size();
+
+    out.clear();
+
+    std::vector<bid_type> bids(foxxll::div_ceil(n, block_type::size));
+    foxxll::block_manager::get_instance()->new_blocks(
+        typename VectorType::alloc_strategy_type(), bids.begin(), bids.end());
+
+    if (nbuffers == 0)
+        nbuffers = 2 * foxxll::config::get_instance()->disks_number();
+
+    {
+        foxxll::write_pool<block_type> pool(nbuffers);
+        block_type* blk = pool.steal();
+
+        for (size_t i = 0; !in.empty(); ++i)
+        {
+            in.swap_buffer_block(blk);
+            pool.write(blk, bids[i]);
+            blk = pool.steal();
+        }
+
+        pool.add(blk);
+        // write_pool's destructor waits for all writes to complete
+    }
+
+    out.set_content(bids.begin(), bids.end(), n);
+    return true;
+}
+
+//! Stores the content of a runs_merger into an stxxl::vector, replacing the
+//! vector's previous content.
+//!
+//! If the vector uses the same block type as the sorted runs, the merger
+//! merges directly into blocks, which are written out as the vector's blocks
+//! and adopted with vector::set_content(). This avoids copying each item into
+//! the vector's write buffers. Otherwise, or if the merger was already
+//! partially consumed, or the vector is backed by a file, the items are
+//! copied as in the other materialize() variants.
+//!
+//! \param in runs_merger used as source, is empty afterwards
+//! \param out vector to store the items in
+//! \param nbuffers number of blocks used for overlapped writing (0 is
+//! default, which equals to (2 * number of disks))
+//! \return true if the vector adopted the merged blocks, false if the items
+//! were copied
+template <typename RunsType, typename CompareType, typename AllocStr,
+          typename ValueType, unsigned PageSize, typename PagerType,
+          size_t BlockSize, typename VectorAllocStr>
+bool materialize(
+    runs_merger<RunsType, CompareType, AllocStr>& in,
+    stxxl::vector<ValueType, PageSize, PagerType, BlockSize, VectorAllocStr>& out,
+    size_t nbuffers = 0)
+{
+    using merger_type = runs_merger<RunsType, CompareType, AllocStr>;
+    using vector_type = stxxl::vector<ValueType, PageSize, PagerType, BlockSize, VectorAllocStr>;
+
+    return materialize_runs_merger(
+        in, out, nbuffers,
+        std::is_same<typename merger_type::block_type,
+                     typename vector_type::block_type>());
+}
+
 ////////////////////////////////////////////////////////////////////////
 //     SORT                                                           //
 ////////////////////////////////////////////////////////////////////////
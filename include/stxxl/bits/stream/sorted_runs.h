@@ -16,15 +16,19 @@
 #define STXXL_STREAM_SORTED_RUNS_HEADER
 
 #include <algorithm>
+#include <cassert>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include <tlx/counting_ptr.hpp>
+#include <tlx/simple_vector.hpp>
 
 #include <foxxll/mng/block_manager.hpp>
 #include <foxxll/mng/typed_block.hpp>
 
 #include <stxxl/bits/algo/trigger_entry.h>
+#include <stxxl/bits/common/manifest.h>
 
 namespace stxxl {
 namespace stream {
@@ -66,6 +70,9 @@ struct sorted_runs : public tlx::reference_counter
     // array "small_run"
     small_run_type small_run;
 
+    //! data file of runs reopened by open(), its blocks are not deallocated
+    foxxll::file_ptr file;
+
 public:
     sorted_runs()
         : elements(0)
@@ -90,6 +97,7 @@ public:
         runs.clear();
         runs_sizes.clear();
         small_run.clear();
+        file = foxxll::file_ptr();
     }
 
     //! Add a new run with given number of elements
@@ -108,6 +116,102 @@ public:
         std::swap(runs, b.runs);
         std::swap(runs_sizes, b.runs_sizes);
         std::swap(small_run, b.small_run);
+        std::swap(file, b.file);
+    }
+
+    //! Saves the runs to the data file of a manifest, see stxxl::manifest.
+    //! The blocks of the runs are copied, followed by blocks holding the
+    //! trigger values and the small run.
+    void save(manifest& m)
+    {
+        using trigger_value_type = typename trigger_entry_type::value_type;
+        using trigger_block_type = foxxll::typed_block<block_type::raw_size, trigger_value_type>;
+
+        m.start_save("sorted_runs", block_type::raw_size);
+        for (size_t i = 0; i < runs.size(); ++i)
+        {
+            m.template append<block_type>(make_bid_iterator(runs[i].begin()),
+                                          make_bid_iterator(runs[i].end()));
+            m.set("run_blocks." + std::to_string(i), runs[i].size());
+            m.set("run_size." + std::to_string(i), runs_sizes[i]);
+        }
+
+        tlx::simple_vector<trigger_block_type> triggers(1);
+        size_t pos = 0;
+        for (size_t i = 0; i < runs.size(); ++i)
+        {
+            for (size_t j = 0; j < runs[i].size(); ++j)
+            {
+                triggers[0][pos++] = runs[i][j].value;
+                if (pos == trigger_block_type::size) {
+                    m.append(triggers[0]);
+                    pos = 0;
+                }
+            }
+        }
+        if (pos != 0)
+            m.append(triggers[0]);
+
+        if (!small_run.empty())
+        {
+            assert(small_run.size() <= block_type::size);
+            tlx::simple_vector<block_type> block(1);
+            std::copy(small_run.begin(), small_run.end(), block[0].begin());
+            m.append(block[0]);
+        }
+
+        m.set("elements", elements);
+        m.set("runs", runs.size());
+        m.set("small_run", small_run.size());
+        m.finish_save();
+    }
+
+    //! Opens runs saved to a manifest into an empty object. The blocks of the
+    //! runs are read in place from the data file, only the trigger values and
+    //! the small run are loaded.
+    void open(manifest& m)
+    {
+        using trigger_value_type = typename trigger_entry_type::value_type;
+        using trigger_block_type = foxxll::typed_block<block_type::raw_size, trigger_value_type>;
+
+        assert(runs.empty() && small_run.empty());
+        file = m.start_open("sorted_runs", block_type::raw_size);
+
+        size_t index = 0;
+        runs.resize(static_cast<size_t>(m.get("runs")));
+        runs_sizes.resize(runs.size());
+        for (size_t i = 0; i < runs.size(); ++i)
+        {
+            runs[i].resize(static_cast<size_t>(m.get("run_blocks." + std::to_string(i))));
+            runs_sizes[i] = m.get("run_size." + std::to_string(i));
+            for (size_t j = 0; j < runs[i].size(); ++j)
+                runs[i][j].bid = m.template bid<typename block_type::bid_type>(index++);
+        }
+
+        tlx::simple_vector<trigger_block_type> triggers(1);
+        size_t pos = trigger_block_type::size;
+        for (size_t i = 0; i < runs.size(); ++i)
+        {
+            for (size_t j = 0; j < runs[i].size(); ++j)
+            {
+                if (pos == trigger_block_type::size) {
+                    m.read_block(index++, triggers[0]);
+                    pos = 0;
+                }
+                runs[i][j].value = triggers[0][pos++];
+            }
+        }
+
+        const size_t small_size = static_cast<size_t>(m.get("small_run"));
+        if (small_size != 0)
+        {
+            tlx::simple_vector<block_type> block(1);
+            m.read_block(index, block[0]);
+            small_run.assign(block[0].begin(), block[0].begin() + small_size);
+        }
+
+        elements = m.get("elements");
+        m.finish_open();
     }
 
 private:
@@ -118,11 +222,10 @@ private:
     //! object, then this function can be used to clear its state.
     void deallocate_blocks()
     {
-        foxxll::block_manager* bm = foxxll::block_manager::get_instance();
         for (size_t i = 0; i < runs.size(); ++i)
         {
-            bm->delete_blocks(make_bid_iterator(runs[i].begin()),
-                              make_bid_iterator(runs[i].end()));
+            delete_blocks_except(file, make_bid_iterator(runs[i].begin()),
+                                 make_bid_iterator(runs[i].end()));
         }
     }
 };
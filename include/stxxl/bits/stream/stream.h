@@ -121,23 +121,36 @@ class vector_iterator2stream
     using buf_istream_unique_ptr_type = std::unique_ptr<buf_istream_type>;
     mutable buf_istream_unique_ptr_type in;
 
+public:
+    //! Standard stream typedef.
+    using value_type = typename std::iterator_traits<InputIterator>::value_type;
+
+private:
+    //! current item if the vector is memory mapped, then no stream is used
+    const value_type* m_mapped;
+
     void delete_stream()
     {
         in.reset();      // delete object
     }
 
 public:
-    //! Standard stream typedef.
-    using value_type = typename std::iterator_traits<InputIterator>::value_type;
-
     vector_iterator2stream(InputIterator begin, InputIterator end,
                            size_t nbuffers = 0)
         : m_current(begin), m_end(end),
-          in(static_cast<buf_istream_type*>(nullptr))
+          in(static_cast<buf_istream_type*>(nullptr)),
+          m_mapped(nullptr)
     {
         if (empty())
             return;
 
+        // read a memory mapped vector directly
+        if (begin.parent_vector()->mapped()) {
+            m_mapped = begin.parent_vector()->mapped_data() +
+                       (begin - begin.parent_vector()->begin());
+            return;
+        }
+
         begin.flush();         // flush container
         typename InputIterator::bids_container_iterator end_iter
             = end.bid() + ((end.block_offset()) ? 1 : 0);
@@ -168,12 +181,14 @@ public:
     //! Standard stream method.
     const value_type& operator * () const
     {
+        if (m_mapped)
+            return *m_mapped;
         return **in;
     }
 
     const value_type* operator -> () const
     {
-        return &(**in);
+        return &(operator * ());
     }
 
     //! Standard stream method.
@@ -181,6 +196,10 @@ public:
     {
         assert(m_end != m_current);
         ++m_current;
+        if (m_mapped) {
+            ++m_mapped;
+            return *this;
+        }
         ++(*in);
         if (TLX_UNLIKELY(empty()))
             delete_stream();
@@ -616,6 +635,10 @@ public:
 
 #include <stxxl/bits/stream/choose.h>
 #include <stxxl/bits/stream/materialize.h>
+#include <stxxl/bits/stream/parse_lines.h>
+#include <stxxl/bits/stream/pipeline.h>
+#include <stxxl/bits/stream/sketch.h>
 #include <stxxl/bits/stream/unique.h>
+#include <stxxl/bits/stream/window.h>
 
 #endif // !STXXL_STREAM_STREAM_HEADER
@@ -0,0 +1,373 @@
+/***************************************************************************
+ *  include/stxxl/bits/stream/window.h
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#ifndef STXXL_STREAM_WINDOW_HEADER
+#define STXXL_STREAM_WINDOW_HEADER
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <foxxll/common/error_handling.hpp>
+
+#include <stxxl/bits/containers/sequence.h>
+
+namespace stxxl {
+
+//! Stream package subnamespace.
+namespace stream {
+
+//! \addtogroup streampack
+//! \{
+
+////////////////////////////////////////////////////////////////////////
+//     WINDOW                                                         //
+////////////////////////////////////////////////////////////////////////
+
+/*!
+ * FIFO buffer used by windowed stream stages: an in-memory ring buffer of
+ * fixed capacity holding the oldest items. Once the ring is full, newer items
+ * are appended to an external \c sequence, which is created on demand, and
+ * moved back into the ring as it drains.
+ *
+ * \tparam ValueType type of the buffered items
+ * \tparam BlockSize block size of the external sequence
+ */
+template <typename ValueType,
+          size_t BlockSize = STXXL_DEFAULT_BLOCK_SIZE(ValueType)>
+class window_buffer
+{
+public:
+    using value_type = ValueType;
+    using size_type = external_size_type;
+    using sequence_type = stxxl::sequence<value_type, BlockSize>;
+
+protected:
+    //! in-memory ring of the oldest items
+    std::vector<value_type> m_ring;
+
+    //! position of the front item in m_ring
+    size_t m_head;
+
+    //! number of items in m_ring
+    size_t m_ring_size;
+
+    //! newer items which did not fit into m_ring
+    std::unique_ptr<sequence_type> m_spill;
+
+    //! move items from the external sequence into the empty ring
+    void refill()
+    {
+        assert(m_ring_size == 0);
+        m_head = 0;
+        while (m_ring_size < m_ring.size() && !m_spill->empty())
+        {
+            m_ring[m_ring_size++] = m_spill->front();
+            m_spill->pop_front();
+        }
+    }
+
+public:
+    //! Create a buffer keeping up to capacity items in internal memory.
+    explicit window_buffer(size_t capacity)
+        : m_ring(capacity), m_head(0), m_ring_size(0)
+    {
+        if (capacity == 0)
+            throw foxxll::bad_parameter("stream::window_buffer: capacity must be positive");
+    }
+
+    //! non-copyable: delete copy-constructor
+    window_buffer(const window_buffer&) = delete;
+    //! non-copyable: delete assignment operator
+    window_buffer& operator = (const window_buffer&) = delete;
+    //! move-constructor: default
+    window_buffer(window_buffer&&) = default;
+    //! move-assignment operator: default
+    window_buffer& operator = (window_buffer&&) = default;
+
+    //! Append an item at the back.
+    void push_back(const value_type& v)
+    {
+        if (m_ring_size < m_ring.size() && (!m_spill || m_spill->empty()))
+        {
+            m_ring[(m_head + m_ring_size) % m_ring.size()] = v;
+            ++m_ring_size;
+            return;
+        }
+
+        if (!m_spill)
+            m_spill.reset(new sequence_type);
+        m_spill->push_back(v);
+    }
+
+    //! The oldest item.
+    const value_type& front() const
+    {
+        assert(!empty());
+        return m_ring[m_head];
+    }
+
+    //! Remove the oldest item.
+    void pop_front()
+    {
+        assert(!empty());
+        m_head = (m_head + 1) % m_ring.size();
+        if (--m_ring_size == 0 && m_spill && !m_spill->empty())
+            refill();
+    }
+
+    //! Number of items.
+    size_type size() const
+    {
+        return m_ring_size + (m_spill ? m_spill->size() : 0);
+    }
+
+    //! Returns true if no items are buffered.
+    bool empty() const
+    {
+        return m_ring_size == 0;
+    }
+
+    //! Returns true if items were spilled to external memory.
+    bool spilled() const
+    {
+        return m_spill && !m_spill->empty();
+    }
+};
+
+/*!
+ * A model of stream that passes the input through and exposes the last N
+ * items of it.
+ *
+ * operator[](0) is the current item (equal to operator*), operator[](i) is
+ * the item i positions before. Near the start of the stream, fewer than N
+ * items are available, see size(). The items are kept in an internal ring
+ * buffer, which in contrast to window_buffer never spills: N is a
+ * compile-time constant, so the memory of the window is fixed, and
+ * operator[] needs random access to all N items, which the sequential spill
+ * of window_buffer does not provide. Windows of data dependent length are
+ * handled by rolling_aggregate.
+ *
+ * \tparam Input type of the input stream
+ * \tparam N length of the window
+ */
+template <class Input, size_t N>
+class window
+{
+    static_assert(N > 0, "window length must be positive");
+
+public:
+    //! Standard stream typedef.
+    using value_type = typename Input::value_type;
+
+protected:
+    Input& m_input;
+
+    //! the last N items
+    std::vector<value_type> m_ring;
+
+    //! position of the current item in m_ring
+    size_t m_pos;
+
+    //! number of valid items in m_ring
+    size_t m_size;
+
+    void append()
+    {
+        m_pos = (m_pos + 1 == N) ? 0 : m_pos + 1;
+        m_ring[m_pos] = *m_input;
+        if (m_size < N) ++m_size;
+    }
+
+public:
+    explicit window(Input& input)
+        : m_input(input), m_ring(N), m_pos(N - 1), m_size(0)
+    {
+        if (!m_input.empty())
+            append();
+    }
+
+    //! Standard stream method.
+    const value_type& operator * () const
+    {
+        assert(!empty());
+        return m_ring[m_pos];
+    }
+
+    //! Standard stream method.
+    const value_type* operator -> () const
+    {
+        return &(operator * ());
+    }
+
+    //! Returns the item i positions before the current one.
+    const value_type& operator [] (size_t i) const
+    {
+        assert(i < m_size);
+        return m_ring[(m_pos + N - i) % N];
+    }
+
+    //! Number of items in the window, at most N.
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    //! Standard stream method.
+    window& operator ++ ()
+    {
+        ++m_input;
+        if (!m_input.empty())
+            append();
+        return *this;
+    }
+
+    //! Standard stream method.
+    bool empty() const
+    {
+        return m_input.empty();
+    }
+};
+
+/*!
+ * A model of stream that computes an aggregate over a sliding key range of a
+ * stream sorted by key, e.g. over a time window.
+ *
+ * For each input item x, the stage emits the pair of x and the aggregate over
+ * all items y seen so far with key(y) + width > key(x), which includes x
+ * itself. The items inside the window are kept in a \c window_buffer, hence
+ * windows holding more items than fit into internal memory are supported.
+ *
+ * The aggregate must be invertible and provide the following interface:
+ * \code
+ * struct Agg {
+ *     using value_type = ...;                  // type of the result
+ *     void add(const input_value_type& x);     // x enters the window
+ *     void remove(const input_value_type& x);  // x leaves the window
+ *     value_type result() const;
+ * };
+ * \endcode
+ *
+ * \tparam Input type of the input stream, must be sorted by key
+ * \tparam KeyFn functor returning the key of an item
+ * \tparam Agg type of the aggregate
+ */
+template <class Input, class KeyFn, class Agg>
+class rolling_aggregate
+{
+public:
+    using input_value_type = typename Input::value_type;
+    using key_type = typename std::decay<
+              decltype(std::declval<KeyFn>()(std::declval<input_value_type>()))>::type;
+    using aggregate_type = Agg;
+    using result_type = typename Agg::value_type;
+
+    //! Standard stream typedef.
+    using value_type = std::pair<input_value_type, result_type>;
+
+protected:
+    Input& m_input;
+    KeyFn m_key;
+    key_type m_width;
+    aggregate_type m_agg;
+
+    //! items inside the current window
+    window_buffer<input_value_type> m_window;
+
+    value_type m_current;
+
+    void append()
+    {
+        const input_value_type& x = *m_input;
+        const key_type k = m_key(x);
+
+        assert(m_window.empty() || !(k < m_key(m_current.first)));
+
+        // evict items which left the window
+        while (!m_window.empty() && !(k < m_key(m_window.front()) + m_width))
+        {
+            m_agg.remove(m_window.front());
+            m_window.pop_front();
+        }
+
+        m_agg.add(x);
+        m_window.push_back(x);
+
+        m_current.first = x;
+        m_current.second = m_agg.result();
+    }
+
+public:
+    //! Create a rolling aggregate stage.
+    //! \param input input stream sorted by key
+    //! \param key functor returning the key of an item
+    //! \param width width of the window in key units
+    //! \param agg initial (empty) aggregate
+    //! \param memory_items number of window items kept in internal memory
+    rolling_aggregate(Input& input, const KeyFn& key, const key_type& width,
+                      const aggregate_type& agg = aggregate_type(),
+                      size_t memory_items = 1024 * 1024)
+        : m_input(input), m_key(key), m_width(width), m_agg(agg),
+          m_window(memory_items)
+    {
+        if (!m_input.empty())
+            append();
+    }
+
+    //! Standard stream method.
+    const value_type& operator * () const
+    {
+        assert(!empty());
+        return m_current;
+    }
+
+    //! Standard stream method.
+    const value_type* operator -> () const
+    {
+        return &(operator * ());
+    }
+
+    //! Standard stream method.
+    rolling_aggregate& operator ++ ()
+    {
+        ++m_input;
+        if (!m_input.empty())
+            append();
+        return *this;
+    }
+
+    //! Standard stream method.
+    bool empty() const
+    {
+        return m_input.empty();
+    }
+
+    //! Number of items in the current window.
+    external_size_type window_size() const
+    {
+        return m_window.size();
+    }
+
+    //! Returns the aggregate of the current window.
+    const aggregate_type& aggregate() const
+    {
+        return m_agg;
+    }
+};
+
+//! \}
+
+} // namespace stream
+} // namespace stxxl
+
+#endif // !STXXL_STREAM_WINDOW_HEADER
@@ -35,6 +35,10 @@ using cmp = stxxl::comparator<int>;
 
 // forced instantiation
 template class stxxl::unordered_map<int, int, hash_int, cmp, 4* 1024, 4>;
+template class stxxl::unordered_map<
+        int, int, hash_int, cmp, 4* 1024, 4,
+        std::allocator<std::pair<const int, int> >, stxxl::clock_pager<>
+        >;
 
 struct structA
 {
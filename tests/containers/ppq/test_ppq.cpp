@@ -29,6 +29,10 @@
 #include <key_with_padding.h>
 #include <test_helpers.h>
 
+#if STXXL_PARALLEL
+#include <omp.h>
+#endif
+
 using foxxll::scoped_print_timer;
 
 using KeyType = int32_t;
@@ -229,6 +233,85 @@ void test_bulk_limit(const size_t bulk_size)
     die_unless(ppq.empty());
 }
 
+//! push from all threads in one bulk, with insertion heaps small enough to be
+//! flushed several times during the bulk, then pop all elements. If
+//! end_in_parallel, the pushes run as tasks and bulk_push_end() is called
+//! inside the parallel region.
+void test_parallel_bulk_push(bool end_in_parallel)
+{
+#if STXXL_PARALLEL
+    const size_t num_heaps = static_cast<size_t>(omp_get_max_threads());
+#else
+    const size_t num_heaps = 1;
+#endif
+    const uint64_t heap_ram = 64 * 1024;
+    const size_t heap_capacity = heap_ram / sizeof(my_type);
+
+    ppq_type ppq(my_cmp(), 128L * 1024L * 1024L, 1.5f, 14,
+                 static_cast<unsigned>(num_heaps), heap_ram);
+
+    // each insertion heap is flushed about 8 times
+    const size_t nelements = 8 * num_heaps * heap_capacity + 123;
+
+    LOG1 << "Running test_parallel_bulk_push(" << end_in_parallel << ") with "
+         << num_heaps << " insertion heaps";
+
+    if (!end_in_parallel)
+    {
+        ppq.bulk_push_begin(nelements);
+#if STXXL_PARALLEL
+#pragma omp parallel
+#endif
+        {
+#if STXXL_PARALLEL
+            const size_t p = static_cast<size_t>(omp_get_thread_num());
+            const size_t num_threads = static_cast<size_t>(omp_get_num_threads());
+#else
+            const size_t p = 0, num_threads = 1;
+#endif
+            for (size_t i = p; i < nelements; i += num_threads)
+                ppq.bulk_push(my_type(int(nelements - i)), p);
+        }
+        ppq.bulk_push_end();
+    }
+    else
+    {
+#if STXXL_PARALLEL
+#pragma omp parallel
+#pragma omp single
+#endif
+        {
+            ppq.bulk_push_begin(nelements);
+            // the taskgroup waits for the pushing tasks and the flushes they
+            // spawned
+#if STXXL_PARALLEL
+#pragma omp taskgroup
+#endif
+            {
+                for (size_t p = 0; p < num_heaps; ++p)
+                {
+#if STXXL_PARALLEL
+#pragma omp task firstprivate(p)
+#endif
+                    for (size_t i = p; i < nelements; i += num_heaps)
+                        ppq.bulk_push(my_type(int(nelements - i)), p);
+                }
+            }
+            ppq.bulk_push_end();
+        }
+    }
+
+    die_unequal(ppq.size(), nelements);
+
+    for (size_t i = 0; i < nelements; ++i)
+    {
+        die_unless(!ppq.empty());
+        die_unequal(ppq.top().key, int(i + 1));
+        ppq.pop();
+    }
+    die_unless(ppq.empty());
+}
+
 int main()
 {
     foxxll::stats* stats = foxxll::stats::get_instance();
@@ -244,5 +327,9 @@ int main()
     stats_begin = *foxxll::stats::get_instance();
     test_bulk_limit(1024 * 1024);
     std::cout << "Stats after bulk_limit_1M: " << (foxxll::stats_data(*stats) - stats_begin);
+    stats_begin = *foxxll::stats::get_instance();
+    test_parallel_bulk_push(false);
+    test_parallel_bulk_push(true);
+    std::cout << "Stats after parallel_bulk_push: " << (foxxll::stats_data(*stats) - stats_begin);
     return 0;
 }
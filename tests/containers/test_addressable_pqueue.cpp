@@ -0,0 +1,112 @@
+/***************************************************************************
+ *  tests/containers/test_addressable_pqueue.cpp
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#define STXXL_DEFAULT_BLOCK_SIZE(T) 4096
+
+//! \example containers/test_addressable_pqueue.cpp
+//! This is an example of how to use \c stxxl::addressable_priority_queue
+
+#include <functional>
+#include <limits>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <tlx/die.hpp>
+#include <tlx/logger.hpp>
+
+#include <stxxl/addressable_priority_queue>
+
+using key_type = uint32_t;
+
+//! top() is the smallest key
+struct cmp_type : public std::greater<key_type>
+{
+    key_type min_value() const { return std::numeric_limits<key_type>::max(); }
+};
+
+using pq_type = stxxl::addressable_priority_queue<key_type, cmp_type, 16* 1024* 1024, 1024* 1024>;
+
+// forced instantiation
+template class stxxl::addressable_priority_queue<key_type, cmp_type, 16* 1024* 1024, 1024* 1024>;
+
+int main()
+{
+    const size_t ops = 1000000;
+
+    pq_type q(4 * 1024 * 1024, 4 * 1024 * 1024);
+
+    // reference: (key, handle) of the items in the queue and the current
+    // key of each handle
+    std::set<std::pair<key_type, uint64_t> > ref;
+    std::vector<key_type> keys;
+
+    std::mt19937 randgen;
+    std::uniform_int_distribution<key_type> distr_key(0, 1u << 30);
+
+    for (size_t i = 0; i < ops; ++i)
+    {
+        const unsigned op = randgen() % 8;
+        if (op < 3 || ref.empty())
+        {
+            const key_type k = distr_key(randgen);
+            const uint64_t h = q.push(k);
+            die_unless(h == keys.size());
+            keys.push_back(k);
+            ref.emplace(k, h);
+        }
+        else if (op < 5)
+        {
+            const uint64_t h = randgen() % keys.size();
+            if (!q.contains(h)) {
+                die_unless(ref.count(std::make_pair(keys[h], h)) == 0);
+                continue;
+            }
+            const key_type k = keys[h] / 2;
+            ref.erase(std::make_pair(keys[h], h));
+            ref.emplace(k, h);
+            keys[h] = k;
+            q.decrease_key(h, k);
+        }
+        else if (op < 6)
+        {
+            const uint64_t h = randgen() % keys.size();
+            if (!q.contains(h)) continue;
+            ref.erase(std::make_pair(keys[h], h));
+            q.erase(h);
+            die_unless(!q.contains(h));
+        }
+        else
+        {
+            die_unless(q.top() == ref.begin()->first);
+            const uint64_t h = q.top_handle();
+            die_unless(keys[h] == ref.begin()->first);
+            ref.erase(std::make_pair(keys[h], h));
+            q.pop();
+            die_unless(!q.contains(h));
+        }
+        die_unless(q.size() == ref.size());
+    }
+
+    LOG1 << "stale entries before draining: " << q.stale();
+
+    while (!ref.empty())
+    {
+        die_unless(q.top() == ref.begin()->first);
+        ref.erase(std::make_pair(q.top(), q.top_handle()));
+        q.pop();
+    }
+    die_unless(q.empty());
+
+    LOG1 << "Test passed.";
+
+    return 0;
+}
@@ -0,0 +1,118 @@
+/***************************************************************************
+ *  tests/containers/test_block_deque.cpp
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#include <deque>
+#include <random>
+
+#include <tlx/die.hpp>
+#include <tlx/logger.hpp>
+
+#include <foxxll/common/utils.hpp>
+
+#include <stxxl/block_deque>
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2) {
+        LOG1 << "Usage: " << argv[0] << " #ops";
+        return -1;
+    }
+
+    // small blocks to get many external blocks
+    using deque_type = stxxl::block_deque<unsigned, 4096>;
+
+    deque_type XXLDeque;
+    std::deque<unsigned> STDDeque;
+
+    std::mt19937 randgen;
+    std::uniform_int_distribution<unsigned> distr_op(0, 7);
+    std::uniform_int_distribution<unsigned> distr_value;
+
+    uint64_t ops = foxxll::atouint64(argv[1]);
+    for (uint64_t i = 0; i < ops; ++i)
+    {
+        unsigned curOP = distr_op(randgen);
+        unsigned value = distr_value(randgen);
+
+        // alternate between phases of growing and shrinking
+        const bool grow = (i / 200000) % 2 == 0;
+
+        switch (curOP)
+        {
+        case 0:
+        case 1:
+            if (grow || curOP == 0) {
+                XXLDeque.push_front(value);
+                STDDeque.push_front(value);
+            }
+            break;
+        case 2:
+        case 3:
+            if (grow || curOP == 2) {
+                XXLDeque.push_back(value);
+                STDDeque.push_back(value);
+            }
+            break;
+        case 4:
+            if (!XXLDeque.empty())
+            {
+                XXLDeque.pop_front();
+                STDDeque.pop_front();
+            }
+            break;
+        case 5:
+            if (!XXLDeque.empty())
+            {
+                XXLDeque.pop_back();
+                STDDeque.pop_back();
+            }
+            break;
+        case 6:
+            if (!XXLDeque.empty())
+            {
+                const size_t pos = value % XXLDeque.size();
+                XXLDeque.set(pos, value);
+                STDDeque[pos] = value;
+            }
+            break;
+        case 7:
+            if (!XXLDeque.empty())
+            {
+                const size_t pos = value % XXLDeque.size();
+                die_unless(XXLDeque[pos] == STDDeque[pos]);
+            }
+            break;
+        }
+
+        die_unless(XXLDeque.empty() == STDDeque.empty());
+        die_unless(XXLDeque.size() == STDDeque.size());
+        if (XXLDeque.size() > 0)
+        {
+            die_unless(XXLDeque.back() == STDDeque.back());
+            die_unless(XXLDeque.front() == STDDeque.front());
+        }
+
+        if (!(i % 100000))
+        {
+            for (size_t j = 0; j < STDDeque.size(); ++j)
+                die_unless(XXLDeque[j] == STDDeque[j]);
+            LOG1 << "Operations done: " << i << " size: " << STDDeque.size()
+                 << " external blocks: " << XXLDeque.external_blocks();
+        }
+    }
+
+    XXLDeque.clear();
+    die_unless(XXLDeque.empty() && XXLDeque.external_blocks() == 0);
+
+    return 0;
+}
+
+// forced instantiation
+template class stxxl::block_deque<int>;
@@ -0,0 +1,80 @@
+/***************************************************************************
+ *  tests/containers/test_compressed_vector.cpp
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#include <random>
+#include <vector>
+
+#include <tlx/die.hpp>
+#include <tlx/logger.hpp>
+
+#include <stxxl/compressed_vector>
+
+//! fill a compressed vector, update random items and check the contents
+//! after evictions, flush and resize
+template <typename Codec, typename ValueType>
+void test(size_t n, bool compressible)
+{
+    using vector_type = stxxl::compressed_vector<
+              ValueType, Codec, stxxl::lru_pager<4>, 64 * 1024>;
+
+    std::mt19937_64 randgen(n);
+    auto next = [&](size_t i) {
+                    // sparse counters, or random items which do not compress
+                    return compressible ? ValueType(i % 8 == 0 ? i : 0) : ValueType(randgen());
+                };
+
+    vector_type v;
+    std::vector<ValueType> ref;
+
+    for (size_t i = 0; i < n; ++i) {
+        const ValueType x = next(i);
+        v.push_back(x);
+        ref.push_back(x);
+    }
+
+    for (size_t k = 0; k < 2000; ++k) {
+        const size_t i = randgen() % n;
+        v[i] = ref[i] = next(i);
+    }
+
+    const vector_type& cv = v;
+    for (size_t i = 0; i < n; ++i)
+        die_unless(cv[i] == ref[i]);
+
+    v.flush();
+    LOG1 << "compressed_vector: " << n * sizeof(ValueType) << " bytes compressed to "
+         << v.compressed_bytes() << " bytes, " << v.raw_capacity() << " bytes allocated";
+
+    if (compressible)
+        die_unless(v.compressed_bytes() < n * sizeof(ValueType) / 2);
+
+    // shrink, then grow with value-initialized items
+    v.resize(n / 3);
+    ref.resize(n / 3);
+    v.resize(n / 2);
+    ref.resize(n / 2, ValueType());
+
+    for (size_t i = 0; i < n / 2; ++i)
+        die_unless(cv[i] == ref[i]);
+
+    v.clear();
+    die_unless(v.compressed_bytes() == 0);
+}
+
+int main()
+{
+    test<stxxl::delta_codec, uint64_t>(1000000, true);
+    test<stxxl::delta_codec, int32_t>(200000, false);
+    test<stxxl::lz_codec, uint64_t>(1000000, true);
+    test<stxxl::lz_codec, uint32_t>(200000, false);
+    test<stxxl::raw_codec, uint64_t>(200000, false);
+
+    return 0;
+}
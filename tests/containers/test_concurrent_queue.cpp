@@ -0,0 +1,100 @@
+/***************************************************************************
+ *  tests/containers/test_concurrent_queue.cpp
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <tlx/die.hpp>
+#include <tlx/logger.hpp>
+
+#include <stxxl/concurrent_queue>
+
+int main()
+{
+    // small blocks and a small memory limit to write blocks to disk
+    using queue_type = stxxl::concurrent_queue<uint64_t, 4096>;
+
+    const size_t num_producers = 4, num_consumers = 4;
+    const uint64_t per_producer = 1000000;
+
+    queue_type q(4, 2);
+    std::atomic<size_t> producers_done(0);
+    std::vector<std::vector<uint64_t> > popped(num_consumers);
+
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < num_producers; ++p)
+    {
+        threads.emplace_back(
+            [&, p]() {
+                queue_type::producer prod(q);
+                for (uint64_t i = 0; i < per_producer; ++i) {
+                    prod.push(p * per_producer + i);
+                    // publish partial blocks now and then
+                    if (i % 100000 == 99999) prod.flush();
+                }
+                prod.flush();
+                ++producers_done;
+            });
+    }
+    for (size_t c = 0; c < num_consumers; ++c)
+    {
+        threads.emplace_back(
+            [&, c]() {
+                queue_type::consumer cons(q);
+                uint64_t x;
+                while (true) {
+                    // check before popping, to drain the queue after the
+                    // last producer finished
+                    const bool done = (producers_done == num_producers);
+                    if (cons.pop(x))
+                        popped[c].push_back(x);
+                    else if (done)
+                        break;
+                    else
+                        std::this_thread::yield();
+                }
+            });
+    }
+    for (std::thread& t : threads)
+        t.join();
+
+    die_unless(q.empty());
+
+    // each element was popped exactly once
+    std::vector<uint64_t> all;
+    for (size_t c = 0; c < num_consumers; ++c) {
+        LOG1 << "consumer " << c << " popped " << popped[c].size() << " elements";
+        all.insert(all.end(), popped[c].begin(), popped[c].end());
+    }
+    std::sort(all.begin(), all.end());
+    die_unless(all.size() == num_producers * per_producer);
+    for (uint64_t i = 0; i < all.size(); ++i)
+        die_unless(all[i] == i);
+
+    // single thread: blocks are FIFO
+    {
+        queue_type::producer prod(q);
+        for (uint64_t i = 0; i < 100000; ++i)
+            prod.push(i);
+        prod.flush();
+
+        queue_type::consumer cons(q);
+        uint64_t x;
+        for (uint64_t i = 0; i < 100000; ++i) {
+            die_unless(cons.pop(x));
+            die_unless(x == i);
+        }
+        die_unless(!cons.pop(x));
+    }
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+/***************************************************************************
+ *  tests/containers/test_dynamic_pqueue.cpp
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+//! \example containers/test_dynamic_pqueue.cpp
+//! This is an example of how to use \c stxxl::dynamic_priority_queue
+
+#include <functional>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+#include <tlx/die.hpp>
+#include <tlx/logger.hpp>
+
+#include <stxxl/priority_queue>
+
+using my_type = uint64_t;
+
+//! top() is the smallest element
+struct cmp_type : public std::greater<my_type>
+{
+    my_type min_value() const { return std::numeric_limits<my_type>::max(); }
+};
+
+// up to 64 Gi elements
+using pq_type = stxxl::dynamic_priority_queue<my_type, cmp_type, 64 * 1024 * 1024>;
+// up to 1 Mi elements
+using small_pq_type = stxxl::dynamic_priority_queue<my_type, cmp_type, 1024>;
+
+// forced instantiation
+template class stxxl::dynamic_priority_queue<my_type, cmp_type, 64 * 1024 * 1024>;
+
+int main()
+{
+    const size_t mib = 1024 * 1024;
+    {
+        LOG1 << "Testing configuration choice";
+        pq_type small(256 * mib);
+        die_unless(small.config() == 0);
+
+        pq_type large(256 * mib, 10 * mib);
+        die_unless(large.config() == 1);
+        LOG1 << "configuration 1: " << large.config_mem() << " bytes, "
+             << large.mem_cons() << " bytes used";
+    }
+    {
+        LOG1 << "Testing growth";
+        pq_type pq(256 * mib);
+
+        // the smallest configuration grows at 8 Mi elements
+        const size_t n = 9 * mib;
+        std::mt19937_64 randgen;
+        for (size_t i = 0; i < n; ++i)
+        {
+            pq.push(randgen());
+            if (i % 1024 == 0) {
+                // interleave some pops, which must not disturb growing
+                my_type t = pq.top();
+                pq.pop();
+                pq.push(t);
+            }
+        }
+        die_unless(pq.size() == n);
+        die_unless(pq.config() == 1);
+
+        my_type last = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            die_unless(pq.top() >= last);
+            last = pq.top();
+            pq.pop();
+        }
+        die_unless(pq.empty());
+    }
+    {
+        LOG1 << "Testing external volume beyond the memory budget";
+        pq_type pq(32 * mib);
+
+        // the budget allows only the smallest configuration, which takes 16
+        // times its memory of elements
+        const size_t n = 32 * mib;
+        for (size_t i = 0; i < n; ++i)
+            pq.push(n - i);
+        die_unless(pq.config() == 0);
+        die_unless(pq.size() == n);
+
+        for (size_t i = 1; i <= n; ++i)
+        {
+            die_unless(pq.top() == i);
+            pq.pop();
+        }
+        die_unless(pq.empty());
+    }
+    {
+        LOG1 << "Testing overflow beyond MaxItems";
+        small_pq_type pq(256 * mib);
+
+        const size_t n = 1 * mib;
+        for (size_t i = 0; i < n; ++i)
+            pq.push(i);
+        die_unless(pq.config() == 0);
+
+        bool caught = false;
+        try {
+            pq.push(n);
+        }
+        catch (std::runtime_error& e) {
+            LOG1 << "Caught exception: " << e.what();
+            caught = true;
+        }
+        die_unless(caught);
+        die_unless(pq.size() == n);
+    }
+
+    LOG1 << "Test passed.";
+
+    return 0;
+}
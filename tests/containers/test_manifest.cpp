@@ -0,0 +1,177 @@
+/***************************************************************************
+ *  tests/containers/test_manifest.cpp
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#define STXXL_DEFAULT_BLOCK_SIZE(T) 4096
+
+//! \example containers/test_manifest.cpp
+//! This is an example of how to save containers with \c stxxl::manifest and
+//! reopen them without re-streaming their elements.
+
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <string>
+
+#include <tlx/die.hpp>
+#include <tlx/logger.hpp>
+
+#include <stxxl/queue>
+#include <stxxl/sequence>
+#include <stxxl/stack>
+#include <stxxl/stream>
+
+using my_type = unsigned;
+
+struct cmp_type : public std::less<my_type>
+{
+    my_type min_value() const { return std::numeric_limits<my_type>::min(); }
+    my_type max_value() const { return std::numeric_limits<my_type>::max(); }
+};
+
+//! save a container, store the manifest and return the path of the manifest
+template <typename Container>
+std::string save(Container& c, const std::string& prefix)
+{
+    stxxl::manifest m(prefix + ".dat");
+    c.save(m);
+    m.write(prefix + ".manifest");
+    return prefix + ".manifest";
+}
+
+//! load a manifest and reopen a container from it
+template <typename Container>
+void open(Container& c, const std::string& path)
+{
+    stxxl::manifest m;
+    m.read(path);
+    c.open(m);
+}
+
+void test_queue(const std::string& prefix, size_t n)
+{
+    LOG1 << "Testing queue with " << n << " elements";
+    stxxl::queue<my_type> q;
+    for (size_t i = 0; i < n + 100; ++i)
+        q.push(static_cast<my_type>(i));
+    for (size_t i = 0; i < 100; ++i)
+        q.pop();
+
+    std::string path = save(q, prefix);
+
+    stxxl::queue<my_type> r;
+    open(r, path);
+    die_unless(r.size() == n);
+    for (size_t i = 0; i < n; ++i) {
+        die_unless(r.front() == q.front());
+        die_unless(r.back() == q.back());
+        r.pop(), q.pop();
+        if (i % 1000 == 0)
+            r.push(static_cast<my_type>(n + i)), q.push(static_cast<my_type>(n + i));
+    }
+    while (!r.empty()) {
+        die_unless(r.front() == q.front());
+        r.pop(), q.pop();
+    }
+    die_unless(q.empty());
+}
+
+void test_sequence(const std::string& prefix, size_t n)
+{
+    LOG1 << "Testing sequence with " << n << " elements";
+    stxxl::sequence<my_type> s;
+    for (size_t i = 0; i < n; ++i) {
+        if (i % 2) s.push_back(static_cast<my_type>(i));
+        else s.push_front(static_cast<my_type>(i));
+    }
+
+    std::string path = save(s, prefix);
+
+    stxxl::sequence<my_type> r;
+    open(r, path);
+    die_unless(r.size() == n);
+    for (size_t i = 0; i < n; ++i) {
+        die_unless(r.front() == s.front() && r.back() == s.back());
+        if (i % 2) r.pop_back(), s.pop_back();
+        else r.pop_front(), s.pop_front();
+    }
+    die_unless(r.empty());
+}
+
+void test_stack(const std::string& prefix, size_t n)
+{
+    LOG1 << "Testing normal_stack with " << n << " elements";
+    using stack_type = stxxl::STACK_GENERATOR<my_type, stxxl::external, stxxl::normal, 4, 4096>::result;
+    stack_type s;
+    for (size_t i = 0; i < n; ++i)
+        s.push(static_cast<my_type>(i));
+
+    std::string path = save(s, prefix);
+
+    stack_type r;
+    open(r, path);
+    die_unless(r.size() == n);
+    for (size_t i = 0; i < n; ++i) {
+        die_unless(r.top() == s.top());
+        r.pop(), s.pop();
+    }
+    die_unless(r.empty());
+}
+
+void test_sorted_runs(const std::string& prefix, size_t n)
+{
+    LOG1 << "Testing sorted_runs with " << n << " elements";
+    using input_type = stxxl::stream::from_sorted_sequences<my_type>;
+    using runs_creator_type = stxxl::stream::runs_creator<input_type, cmp_type, 4096>;
+    using sorted_runs_type = runs_creator_type::sorted_runs_type;
+    using sorted_runs_data_type = sorted_runs_type::element_type;
+
+    runs_creator_type creator(cmp_type(), 16 * 1024 * 1024);
+    for (size_t r = 0; r < 5; ++r) {
+        for (size_t i = 0; i < n; ++i)
+            creator.push(static_cast<my_type>(5 * i + r));
+        creator.finish();
+    }
+
+    std::string path = save(*creator.result(), prefix);
+
+    sorted_runs_type runs(new sorted_runs_data_type);
+    open(*runs, path);
+    die_unless(runs->elements == 5 * n);
+    die_unless(check_sorted_runs(runs, cmp_type()));
+
+    stxxl::stream::runs_merger<sorted_runs_type, cmp_type> merger(runs, cmp_type(), 16 * 1024 * 1024);
+    for (size_t i = 0; i < 5 * n; ++i, ++merger)
+        die_unless(*merger == static_cast<my_type>(i));
+    die_unless(merger.empty());
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        LOG1 << "Usage: " << argv[0] << " path";
+        return -1;
+    }
+    const std::string prefix = argv[1];
+
+    for (size_t n : { 0, 10, 100000 })
+    {
+        test_queue(prefix, n);
+        test_sequence(prefix, n);
+        test_stack(prefix, n);
+    }
+    test_sorted_runs(prefix, 100000);
+
+    std::remove((prefix + ".dat").c_str());
+    std::remove((prefix + ".manifest").c_str());
+
+    LOG1 << "Test passed.";
+
+    return 0;
+}
@@ -34,6 +34,8 @@ using map_type = stxxl::map<key_type, data_type, cmp, BLOCK_SIZE, BLOCK_SIZE>;
 
 // forced instantiation
 template class stxxl::map<key_type, data_type, cmp, BLOCK_SIZE, BLOCK_SIZE>;
+template class stxxl::map<key_type, data_type, cmp, BLOCK_SIZE, BLOCK_SIZE,
+                          foxxll::simple_random, stxxl::arc_pager<> >;
 
 int main(int argc, char** argv)
 {
@@ -0,0 +1,142 @@
+/***************************************************************************
+ *  tests/containers/test_migr_containers.cpp
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#define STXXL_DEFAULT_BLOCK_SIZE(T) 4096
+
+//! \example containers/test_migr_containers.cpp
+//! This is an example of how to use \c stxxl::migrating_queue,
+//! \c stxxl::migrating_deque and \c stxxl::migrating_priority_queue
+
+#include <deque>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include <tlx/die.hpp>
+#include <tlx/logger.hpp>
+
+#include <stxxl/comparator>
+#include <stxxl/deque>
+#include <stxxl/priority_queue>
+#include <stxxl/queue>
+
+using my_type = int;
+constexpr size_t critical_size = 4 * 4096;
+
+using migrating_queue_type = stxxl::migrating_queue<my_type, critical_size>;
+using migrating_deque_type = stxxl::migrating_deque<my_type, critical_size>;
+
+using pq_type = stxxl::PRIORITY_QUEUE_GENERATOR<
+          my_type, stxxl::comparator<my_type>, 16* 1024* 1024, 1024* 1024
+          >::result;
+using migrating_pq_type = stxxl::migrating_priority_queue<pq_type, critical_size>;
+
+// forced instantiation
+template class stxxl::migrating_queue<my_type, critical_size>;
+template class stxxl::migrating_deque<my_type, critical_size>;
+template class stxxl::migrating_priority_queue<pq_type, critical_size>;
+
+//! grow the container beyond critical_size, shrink it below the demote size
+//! and check it against the reference in each step
+template <typename Container, typename Reference, typename Push, typename Pop>
+void test_cycle(Container& c, Reference& ref, Push push, Pop pop)
+{
+    std::mt19937 randgen;
+    std::uniform_int_distribution<my_type> distr;
+
+    for (size_t round = 0; round < 2; ++round)
+    {
+        die_unless(c.internal());
+        while (ref.size() < 3 * critical_size)
+            push(distr(randgen));
+        die_unless(c.external());
+
+        while (ref.size() > critical_size / 8)
+            pop();
+        die_unless(c.internal());
+    }
+
+    while (!ref.empty())
+        pop();
+    die_unless(c.empty() && c.internal());
+}
+
+int main()
+{
+    {
+        LOG1 << "Testing migrating_queue";
+        migrating_queue_type q;
+        q.set_demote_size(critical_size / 4);
+        std::queue<my_type> ref;
+
+        test_cycle(
+            q, ref,
+            [&](my_type v) { q.push(v); ref.push(v); },
+            [&]() {
+                die_unless(q.size() == ref.size());
+                die_unless(q.front() == ref.front() && q.back() == ref.back());
+                q.pop(), ref.pop();
+            });
+    }
+    {
+        LOG1 << "Testing migrating_queue with a shared pool";
+        foxxll::read_write_pool<migrating_queue_type::ext_queue_type::block_type> pool(2, 4);
+        std::vector<migrating_queue_type*> queues;
+        for (size_t i = 0; i < 1000; ++i) {
+            queues.push_back(new migrating_queue_type(pool));
+            queues.back()->push(static_cast<my_type>(i));
+        }
+        for (size_t i = 0; i < queues.size(); ++i) {
+            die_unless(queues[i]->internal() && queues[i]->size() == 1);
+            die_unless(queues[i]->front() == static_cast<my_type>(i));
+            delete queues[i];
+        }
+    }
+    {
+        LOG1 << "Testing migrating_deque";
+        migrating_deque_type d;
+        d.set_demote_size(critical_size / 4);
+        std::deque<my_type> ref;
+        size_t op = 0;
+
+        test_cycle(
+            d, ref,
+            [&](my_type v) {
+                if (++op % 2) d.push_back(v), ref.push_back(v);
+                else d.push_front(v), ref.push_front(v);
+            },
+            [&]() {
+                die_unless(d.size() == ref.size());
+                die_unless(d.front() == ref.front() && d.back() == ref.back());
+                die_unless(d[ref.size() / 2] == ref[ref.size() / 2]);
+                if (++op % 2) d.pop_back(), ref.pop_back();
+                else d.pop_front(), ref.pop_front();
+            });
+    }
+    {
+        LOG1 << "Testing migrating_priority_queue";
+        migrating_pq_type p(4 * 1024 * 1024, 4 * 1024 * 1024);
+        p.set_demote_size(critical_size / 4);
+        std::priority_queue<my_type> ref;
+
+        test_cycle(
+            p, ref,
+            [&](my_type v) { p.push(v); ref.push(v); },
+            [&]() {
+                die_unless(p.size() == ref.size());
+                die_unless(p.top() == ref.top());
+                p.pop(), ref.pop();
+            });
+    }
+
+    LOG1 << "Test passed.";
+
+    return 0;
+}
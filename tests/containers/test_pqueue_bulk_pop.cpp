@@ -0,0 +1,90 @@
+/***************************************************************************
+ *  tests/containers/test_pqueue_bulk_pop.cpp
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#define STXXL_DEFAULT_BLOCK_SIZE(T) 4096
+
+//! \example containers/test_pqueue_bulk_pop.cpp
+//! This is an example of how to use \c stxxl::priority_queue::bulk_pop()
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include <tlx/die.hpp>
+#include <tlx/logger.hpp>
+
+#include <stxxl/priority_queue>
+
+using my_type = uint64_t;
+
+//! top() is the smallest element
+struct cmp_type : public std::greater<my_type>
+{
+    my_type min_value() const { return std::numeric_limits<my_type>::max(); }
+};
+
+using pq_type = stxxl::PRIORITY_QUEUE_GENERATOR<
+          my_type, cmp_type, 16* 1024* 1024, 64* 1024* 1024 / 1024>::result;
+
+int main()
+{
+    pq_type pq(16 * 1024 * 1024, 16 * 1024 * 1024);
+    std::priority_queue<my_type, std::vector<my_type>, std::greater<my_type> > ref;
+
+    std::mt19937_64 randgen;
+    std::vector<my_type> out;
+
+    LOG1 << "Testing bulk_pop with interleaved pushes and pops";
+    for (size_t round = 0; round < 64; ++round)
+    {
+        // grow the queue more in the first half, then shrink it
+        const size_t pushes = (round < 32) ? randgen() % (1024 * 1024) : randgen() % 1024;
+        for (size_t i = 0; i < pushes; ++i) {
+            const my_type v = randgen() >> 1;
+            pq.push(v);
+            ref.push(v);
+        }
+
+        // single pops must agree with bulk_pop
+        for (size_t i = 0; i < 100 && !ref.empty(); ++i) {
+            die_unless(pq.top() == ref.top());
+            pq.pop(), ref.pop();
+        }
+
+        const size_t batch = randgen() % (256 * 1024);
+        out.clear();
+        const size_t popped = pq.bulk_pop(out, batch);
+        die_unless(popped == std::min<size_t>(batch, ref.size()));
+        die_unless(out.size() == popped);
+        for (size_t i = 0; i < popped; ++i) {
+            die_unless(out[i] == ref.top());
+            ref.pop();
+        }
+        die_unless(pq.size() == ref.size());
+    }
+
+    LOG1 << "Draining " << pq.size() << " elements";
+    out.clear();
+    die_unless(pq.bulk_pop(out, std::numeric_limits<size_t>::max()) == out.size());
+    for (size_t i = 0; i < out.size(); ++i) {
+        die_unless(out[i] == ref.top());
+        ref.pop();
+    }
+    die_unless(ref.empty());
+    die_unless(pq.empty());
+    die_unless(pq.bulk_pop(out, 10) == 0);
+
+    LOG1 << "Test passed.";
+
+    return 0;
+}
@@ -16,8 +16,11 @@
 // stxxl::queue contains deprecated funtions
 #define STXXL_NO_DEPRECATED 1
 
+#include <algorithm>
+#include <deque>
 #include <queue>
 #include <random>
+#include <vector>
 
 #include <tlx/die.hpp>
 #include <tlx/logger.hpp>
@@ -40,6 +43,17 @@ void check(const q1type& q1, const q2type& q2)
     }
 }
 
+//! stream of consecutive numbers
+struct counting_stream
+{
+    using value_type = my_type;
+    my_type m_curr, m_end;
+    counting_stream(my_type first, my_type n) : m_curr(first), m_end(first + n) { }
+    const value_type& operator * () const { return m_curr; }
+    counting_stream& operator ++ () { ++m_curr; return *this; }
+    bool empty() const { return m_curr == m_end; }
+};
+
 // forced instantiation
 template class stxxl::queue<my_type>;
 
@@ -164,6 +178,90 @@ int main()
         }
     }
 
+    {
+        // batches of random size against a std::deque
+        stxxl::queue<my_type> bqueue(3, 2);
+        std::deque<my_type> ref;
+        std::vector<my_type> buf;
+        my_type next = 0;
+
+        for (size_t round = 0; round < 2000; ++round)
+        {
+            const size_t n = distr(randgen) % 3000;
+            buf.resize(n);
+            if (distr02(randgen) > 0 || ref.size() < n) {
+                for (my_type& x : buf) x = next++;
+                bqueue.push_bulk(buf.data(), n);
+                ref.insert(ref.end(), buf.begin(), buf.end());
+            }
+            else {
+                bqueue.pop_bulk(buf.data(), n);
+                die_unless(std::equal(buf.begin(), buf.end(), ref.begin()));
+                ref.erase(ref.begin(), ref.begin() + n);
+            }
+            die_unless(bqueue.size() == ref.size());
+            if (!ref.empty())
+                die_unless(bqueue.front() == ref.front() && bqueue.back() == ref.back());
+        }
+
+        // append from a stream, then drain blockwise in place
+        counting_stream in(next, 100000);
+        bqueue.push_bulk(in);
+        for (my_type i = 0; i < 100000; ++i)
+            ref.push_back(next + i);
+
+        while (!bqueue.empty())
+        {
+            stxxl::span<my_type> s = bqueue.front_span();
+            die_unless(!s.empty() && s.size() <= ref.size());
+            die_unless(std::equal(s.begin(), s.end(), ref.begin()));
+            ref.erase(ref.begin(), ref.begin() + s.size());
+            bqueue.pop_bulk(nullptr, s.size());
+        }
+        die_unless(ref.empty());
+    }
+
+    {
+        // queues sharing a pool and a prefetch budget
+        using queue_type = stxxl::queue<my_type>;
+        foxxll::read_write_pool<queue_type::block_type> pool(4, 8);
+        stxxl::prefetch_budget budget(pool);
+
+        std::vector<queue_type*> queues;
+        std::vector<std::queue<my_type> > refs(4);
+        for (size_t i = 0; i < refs.size(); ++i) {
+            queues.push_back(new queue_type(pool));
+            queues.back()->set_adaptive_prefetch(&budget);
+        }
+
+        for (size_t round = 0; round < 100000; ++round)
+        {
+            const size_t i = distr(randgen) % refs.size();
+            for (size_t j = 0; j < 64; ++j) {
+                if (distr02(randgen) > 0 || refs[i].empty()) {
+                    const my_type val = distr(randgen);
+                    queues[i]->push(val);
+                    refs[i].push(val);
+                }
+                else {
+                    die_unless(queues[i]->front() == refs[i].front());
+                    queues[i]->pop();
+                    refs[i].pop();
+                }
+            }
+            die_unless(budget.used() <= budget.total());
+        }
+
+        size_t depths = 0;
+        for (size_t i = 0; i < refs.size(); ++i)
+            depths += queues[i]->get_prefetch_aggr();
+        die_unless(depths == budget.used());
+
+        for (queue_type* q : queues)
+            delete q;
+        die_unless(budget.used() == 0);
+    }
+
     {
         // test proper destruction of a single-block queue
         stxxl::queue<int> q;
@@ -0,0 +1,85 @@
+/***************************************************************************
+ *  tests/containers/test_radix_heap.cpp
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#define STXXL_DEFAULT_BLOCK_SIZE(T) 4096
+
+//! \example containers/test_radix_heap.cpp
+//! This is an example of how to use \c stxxl::radix_heap
+
+#include <functional>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <tlx/die.hpp>
+#include <tlx/logger.hpp>
+
+#include <stxxl/radix_heap>
+
+// forced instantiation
+template class stxxl::radix_heap<uint64_t, uint32_t>;
+template class stxxl::radix_heap<uint32_t, uint64_t>;
+
+template <typename KeyType>
+void test_monotone(size_t n, KeyType max_step)
+{
+    LOG1 << "Testing radix_heap with " << sizeof(KeyType) << " byte keys, "
+         << n << " rounds, max step " << max_step;
+
+    using heap_type = stxxl::radix_heap<KeyType, uint64_t>;
+    using entry = std::pair<KeyType, uint64_t>;
+
+    heap_type h;
+    std::priority_queue<entry, std::vector<entry>, std::greater<entry> > ref;
+
+    std::mt19937_64 randgen;
+    std::uniform_int_distribution<KeyType> distr_step(0, max_step);
+
+    KeyType least = 0;
+    uint64_t id = 0;
+
+    // grow and shrink the heap with pushes relative to the last minimum
+    for (size_t i = 0; i < n; ++i)
+    {
+        const size_t pushes = (i < n / 2) ? 2 : (i % 2);
+        for (size_t j = 0; j < pushes; ++j) {
+            const KeyType k = static_cast<KeyType>(least + distr_step(randgen));
+            h.push(k, id);
+            ref.emplace(k, id++);
+        }
+
+        die_unless(h.size() == ref.size());
+        if (ref.empty()) continue;
+
+        // the order of equal keys is not specified
+        die_unless(h.top().first == ref.top().first);
+        least = h.top().first;
+        h.pop(), ref.pop();
+    }
+
+    while (!ref.empty())
+    {
+        die_unless(h.top().first == ref.top().first);
+        h.pop(), ref.pop();
+    }
+    die_unless(h.empty());
+}
+
+int main()
+{
+    test_monotone<uint64_t>(1000000, 1000000);
+    test_monotone<uint64_t>(100000, uint64_t(1) << 40);
+    test_monotone<uint32_t>(1000000, 15);
+
+    LOG1 << "Test passed.";
+
+    return 0;
+}
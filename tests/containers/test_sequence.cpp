@@ -12,9 +12,11 @@
 
 #define STXXL_DEFAULT_BLOCK_SIZE(T) 4096
 
+#include <algorithm>
 #include <iostream>
 #include <iterator>
 #include <random>
+#include <vector>
 
 #include <tlx/die.hpp>
 
@@ -112,5 +114,49 @@ int main(int argc, char* argv[])
         }
     }
 
+    // bulk operations at both ends
+    std::vector<my_type> buf;
+    for (uint64_t i = 0; i < ops / 100; ++i)
+    {
+        const size_t n = distr_value(randgen) % 3000;
+        buf.resize(n);
+
+        switch (distr_op(randgen) % 3)
+        {
+        case 0:
+            for (my_type& x : buf) x = distr_value(randgen);
+            XXLDeque.push_back_bulk(buf.data(), n);
+            STDDeque.insert(STDDeque.end(), buf.begin(), buf.end());
+            break;
+        case 1:
+            if (STDDeque.size() < n) break;
+            XXLDeque.pop_front_bulk(buf.data(), n);
+            die_unless(std::equal(buf.begin(), buf.end(), STDDeque.begin()));
+            STDDeque.erase(STDDeque.begin(), STDDeque.begin() + n);
+            break;
+        case 2:
+            if (STDDeque.size() < n) break;
+            XXLDeque.pop_back_bulk(buf.data(), n);
+            die_unless(std::equal(buf.begin(), buf.end(), STDDeque.rbegin()));
+            STDDeque.erase(STDDeque.end() - n, STDDeque.end());
+            break;
+        }
+
+        die_unless(XXLDeque.size() == STDDeque.size());
+        if (!STDDeque.empty())
+            die_unless(XXLDeque.front() == STDDeque.front() && XXLDeque.back() == STDDeque.back());
+    }
+
+    // drain blockwise in place from the back
+    while (!XXLDeque.empty())
+    {
+        stxxl::span<my_type> s = XXLDeque.back_span();
+        die_unless(!s.empty() && s.size() <= STDDeque.size());
+        die_unless(std::equal(s.begin(), s.end(), STDDeque.end() - s.size()));
+        STDDeque.erase(STDDeque.end() - s.size(), STDDeque.end());
+        XXLDeque.pop_back_bulk(nullptr, s.size());
+    }
+    die_unless(STDDeque.empty());
+
     return 0;
 }
@@ -19,6 +19,9 @@
 //! with \c stxxl::grow_shrink_stack implementation, \b four blocks per page,
 //! block size \b STXXL_DEFAULT_BLOCK_SIZE(T) bytes
 
+#include <random>
+#include <vector>
+
 #include <tlx/die.hpp>
 #include <tlx/logger.hpp>
 
@@ -116,6 +119,51 @@ void simple_test(stack_type& my_stack, size_t test_size)
     test_lvalue_correctness(my_stack, 4 * STXXL_DEFAULT_BLOCK_SIZE(size_t) / 4 * 2, 4 * STXXL_DEFAULT_BLOCK_SIZE(size_t) / 4 * 2 * 20);
 }
 
+//! push and pop batches of random size and compare with a std::vector
+template <typename stack_type>
+void test_bulk(stack_type& my_stack, size_t test_size)
+{
+    std::mt19937 randgen(static_cast<unsigned>(test_size));
+    std::vector<size_t> ref, buf;
+    size_t next = 0;
+
+    while (next < 4 * test_size)
+    {
+        const size_t n = randgen() % 5000;
+        buf.resize(n);
+        if (randgen() % 3 != 0 || ref.size() < n) {
+            for (size_t& x : buf) x = next++;
+            my_stack.push_bulk(buf.data(), n);
+            ref.insert(ref.end(), buf.begin(), buf.end());
+        }
+        else {
+            my_stack.pop_bulk(buf.data(), n);
+            for (size_t i = 0; i < n; ++i) {
+                die_unless(buf[i] == ref.back());
+                ref.pop_back();
+            }
+        }
+        die_unless(my_stack.size() == ref.size());
+        if (!ref.empty())
+            die_unless(my_stack.top() == ref.back());
+    }
+
+    // drain the stack blockwise in place
+    while (!my_stack.empty())
+    {
+        stxxl::span<size_t> s = my_stack.top_span();
+        die_unless(!s.empty() && s.size() <= my_stack.size());
+        for (size_t i = s.size(); i > 0; --i) {
+            die_unless(s[i - 1] == ref.back());
+            ref.pop_back();
+        }
+        my_stack.pop_bulk(nullptr, s.size());
+    }
+    die_unless(ref.empty());
+
+    LOG1 << "Bulk test passed.";
+}
+
 int main(int argc, char* argv[])
 {
     using ext_normal_stack_type = stxxl::STACK_GENERATOR<
@@ -139,6 +187,7 @@ int main(int argc, char* argv[])
     {
         ext_normal_stack_type my_stack;
         simple_test(my_stack, atoi(argv[1]) * STXXL_DEFAULT_BLOCK_SIZE(int) / sizeof(int));
+        test_bulk(my_stack, atoi(argv[1]) * STXXL_DEFAULT_BLOCK_SIZE(int) / sizeof(int));
     }
     {
         ext_migrating_stack_type my_stack;
@@ -147,6 +196,7 @@ int main(int argc, char* argv[])
     {
         ext_stack_type my_stack;
         simple_test(my_stack, atoi(argv[1]) * STXXL_DEFAULT_BLOCK_SIZE(int) / sizeof(int));
+        test_bulk(my_stack, atoi(argv[1]) * STXXL_DEFAULT_BLOCK_SIZE(int) / sizeof(int));
     }
     {
         // prefetch/write pool with 10 blocks prefetching and 10 block write cache (> D is recommended)
@@ -193,6 +243,9 @@ int main(int argc, char* argv[])
         LOG1 << "Test 2 passed.";
 
         test_lvalue_correctness(my_stack, 4 * STXXL_DEFAULT_BLOCK_SIZE(size_t) / 4 * 2, 4 * STXXL_DEFAULT_BLOCK_SIZE(size_t) / 4 * 2 * 20);
+
+        my_stack.set_prefetch_aggr(2);
+        test_bulk(my_stack, test_size);
     }
 
     return 0;
@@ -0,0 +1,72 @@
+/***************************************************************************
+ *  tests/containers/test_varlen_vector.cpp
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <tlx/die.hpp>
+#include <tlx/logger.hpp>
+
+#include <stxxl/varlen_vector>
+
+int main()
+{
+    using vector_type = stxxl::varlen_vector<64 * 1024, stxxl::lru_pager<4> >;
+
+    std::mt19937_64 randgen(42);
+    std::vector<std::string> ref;
+
+    // mostly short strings, some empty ones and a few spanning several blocks
+    auto next = [&](size_t i) {
+                    size_t len = randgen() % 40;
+                    if (i % 1000 == 999) len = 0;
+                    if (i % 20000 == 7) len = 200 * 1024 + randgen() % 1000;
+                    std::string s(len, ' ');
+                    for (char& c : s) c = static_cast<char>('a' + randgen() % 26);
+                    return s;
+                };
+
+    vector_type v;
+    for (size_t i = 0; i < 100000; ++i)
+        ref.push_back(next(i));
+
+    // push_back, then bulk append
+    for (size_t i = 0; i < ref.size() / 2; ++i)
+        v.push_back(ref[i]);
+    v.append(ref.begin() + ref.size() / 2, ref.end());
+
+    die_unless(v.size() == ref.size());
+    LOG1 << "varlen_vector: " << v.size() << " records, " << v.bytes()
+         << " bytes, " << v.raw_capacity() << " bytes allocated";
+
+    // random access
+    for (size_t k = 0; k < 20000; ++k) {
+        const size_t i = randgen() % ref.size();
+        die_unless(v[i] == ref[i]);
+    }
+
+    // sequential scans from the beginning and from some positions
+    for (size_t begin : { size_t(0), size_t(7), size_t(12345), ref.size() - 3 })
+    {
+        size_t i = begin;
+        for (vector_type::bufreader r(v, begin); !r.empty(); ++r, ++i)
+            die_unless(*r == ref[i]);
+        die_unless(i == ref.size());
+    }
+
+    v.clear();
+    die_unless(v.empty() && v.raw_capacity() == 0);
+
+    v.push_back("abc");
+    die_unless(v[0] == "abc");
+
+    return 0;
+}
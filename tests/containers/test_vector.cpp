@@ -21,12 +21,19 @@
 #include <cassert>
 #include <functional>
 #include <iostream>
+#include <limits>
+#include <numeric>
 #include <random>
+#include <thread>
+#include <vector>
 
 #include <tlx/die.hpp>
 #include <tlx/logger.hpp>
 
+#include <stxxl/ksort>
 #include <stxxl/scan>
+#include <stxxl/sort>
+#include <stxxl/stream>
 #include <stxxl/vector>
 
 using key_type = uint64_t;
@@ -165,10 +172,473 @@ void test_resize_shrink()
     vector.flush();
 }
 
+//! check asynchronous write-back and read-ahead with spare pages
+void test_spare_pages(size_t spare_pages)
+{
+    using vector_type = stxxl::vector<uint64_t, 2, stxxl::lru_pager<4>, 4096>;
+
+    const size_t n = 64 * 4096 / sizeof(uint64_t);
+    vector_type v(n);
+    v.set_spare_pages(spare_pages);
+    die_unless(v.spare_pages() == spare_pages);
+
+    std::vector<uint64_t> ref(n);
+    std::mt19937_64 randgen(spare_pages);
+
+    for (size_t i = 0; i < n; ++i)
+        v[i] = ref[i] = i;
+
+    for (size_t round = 0; round < 3; ++round)
+    {
+        // random updates evict dirty pages
+        for (size_t k = 0; k < n / 4; ++k) {
+            const size_t i = randgen() % n;
+            v[i] = ref[i] = randgen();
+        }
+
+        // sequential scans trigger read-ahead
+        const vector_type& cv = v;
+        for (size_t i = 0; i < n; ++i)
+            die_unless(cv[i] == ref[i]);
+        for (size_t i = n; i-- > 0; )
+            die_unless(cv[i] == ref[i]);
+    }
+
+    v.flush();
+    for (size_t i = 0; i < n; ++i)
+        die_unless(v[i] == ref[i]);
+
+    v.resize(n / 3, true);
+    vector_type v_copy(v);
+    for (size_t i = 0; i < n / 3; ++i)
+        die_unless(v_copy[i] == ref[i]);
+}
+
+//! check bulk append() and assign() which bypass the page cache
+void test_bulk()
+{
+    using vector_type = stxxl::vector<uint64_t, 2, stxxl::lru_pager<4>, 4096>;
+    const size_t block_items = 4096 / sizeof(uint64_t);
+
+    std::vector<uint64_t> ref(13 * block_items + 17);
+    for (size_t i = 0; i < ref.size(); ++i)
+        ref[i] = i * 7 + 3;
+
+    vector_type v;
+    // partial block, then whole blocks
+    v.append(ref.begin(), ref.begin() + 100);
+    v.append(ref.begin() + 100, ref.begin() + 5 * block_items + 3);
+
+    auto input = stxxl::stream::streamify(ref.begin() + 5 * block_items + 3, ref.end());
+    v.append(input);
+
+    die_unless(v.size() == ref.size());
+    for (size_t i = 0; i < ref.size(); ++i)
+        die_unless(v[i] == ref[i]);
+
+    // overwrite a range covering cached and uncached pages
+    std::vector<uint64_t> data(7 * block_items + 5);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = ~uint64_t(i);
+
+    const size_t offset = 2 * block_items - 11;
+    v[offset + 3 * block_items] = 0;
+    v.assign(offset, data.data(), data.size());
+    std::copy(data.begin(), data.end(), ref.begin() + offset);
+
+    v.flush();
+    const vector_type& cv = v;
+    for (size_t i = 0; i < ref.size(); ++i)
+        die_unless(cv[i] == ref[i]);
+}
+
+//! check copy-on-write snapshots
+void test_snapshot()
+{
+    using vector_type = stxxl::vector<uint64_t, 2, stxxl::lru_pager<4>, 4096>;
+
+    const size_t n = 64 * 4096 / sizeof(uint64_t);
+    vector_type v(n);
+    std::vector<uint64_t> ref(n);
+    for (size_t i = 0; i < n; ++i)
+        v[i] = ref[i] = i;
+
+    vector_type snap = v.snapshot();
+    const std::vector<uint64_t> snap_ref = ref;
+
+    // read the snapshot in another thread while the vector is updated
+    std::thread reader(
+        [&snap, &snap_ref]() {
+            const vector_type& cs = snap;
+            for (size_t i = 0; i < snap_ref.size(); ++i)
+                die_unless(cs[i] == snap_ref[i]);
+        });
+
+    for (size_t i = 0; i < n; i += 100)
+        v[i] = ref[i] = i + 42;
+
+    std::vector<uint64_t> data(3 * 4096 / sizeof(uint64_t) + 5, 7);
+    v.assign(1000, data.data(), data.size());
+    std::copy(data.begin(), data.end(), ref.begin() + 1000);
+
+    v.append(data.begin(), data.end());
+    ref.insert(ref.end(), data.begin(), data.end());
+
+    reader.join();
+
+    v.flush();
+    for (size_t i = 0; i < ref.size(); ++i)
+        die_unless(v[i] == ref[i]);
+
+    // writes to the snapshot do not affect the vector
+    snap[1] = 0;
+    die_unless(v[1] == ref[1]);
+
+    snap.unshare();
+    v.resize(n / 2, true);
+    const vector_type& cs = snap;
+    for (size_t i = 2; i < n; ++i)
+        die_unless(cs[i] == snap_ref[i]);
+}
+
+//! key extractor for ksort() of plain integers
+struct uint64_key
+{
+    using key_type = uint64_t;
+    key_type operator () (const uint64_t& x) const { return x; }
+    key_type min_value() const { return std::numeric_limits<key_type>::min(); }
+    key_type max_value() const { return std::numeric_limits<key_type>::max(); }
+};
+
+//! check that algorithms which write blocks directly leave snapshots intact
+void test_snapshot_algorithms()
+{
+    using vector_type = stxxl::vector<uint64_t, 2, stxxl::lru_pager<4>, 4096>;
+
+    const size_t n = 64 * 4096 / sizeof(uint64_t);
+    // less than the vector, such that sort() and ksort() use external runs
+    const size_t memory = 64 * 4096;
+
+    vector_type v(n);
+    std::mt19937_64 randgen(3);
+    for (size_t i = 0; i < n; ++i)
+        v[i] = randgen() >> 1;
+
+    auto check_snapshot = [](const vector_type& snap, const std::vector<uint64_t>& ref) {
+                              die_unless(snap.size() == ref.size());
+                              for (size_t i = 0; i < ref.size(); ++i)
+                                  die_unless(snap[i] == ref[i]);
+                          };
+
+    // sort a range which starts and ends within blocks
+    std::vector<uint64_t> ref(v.cbegin(), v.cend());
+    {
+        const vector_type snap = v.snapshot();
+        stxxl::sort(v.begin() + 100, v.end() - 100, stxxl::comparator<uint64_t>(), memory);
+        check_snapshot(snap, ref);
+
+        std::sort(ref.begin() + 100, ref.end() - 100);
+        check_snapshot(v, ref);
+    }
+
+    // ksort the whole vector
+    {
+        const vector_type snap = v.snapshot();
+        stxxl::ksort(v.begin(), v.end(), uint64_key(), memory);
+        check_snapshot(snap, ref);
+
+        std::sort(ref.begin(), ref.end());
+        check_snapshot(v, ref);
+    }
+
+    // materialize a stream into the vector, with and without output end
+    {
+        const vector_type snap = v.snapshot();
+        std::vector<uint64_t> input(n / 2);
+        for (size_t i = 0; i < input.size(); ++i)
+            input[i] = i;
+
+        auto in1 = stxxl::stream::streamify(input.begin(), input.end());
+        stxxl::stream::materialize(in1, v.begin() + 3);
+        auto in2 = stxxl::stream::streamify(input.begin(), input.end());
+        stxxl::stream::materialize(in2, v.begin() + n / 2, v.end() - 5);
+        check_snapshot(snap, ref);
+
+        std::copy(input.begin(), input.end(), ref.begin() + 3);
+        std::copy(input.begin(), input.end() - 5, ref.begin() + n / 2);
+        check_snapshot(v, ref);
+    }
+
+    // write with a bufwriter, which copies only the blocks it reaches
+    {
+        const vector_type snap = v.snapshot();
+        const size_t begin = 4 * vector_type::block_size / sizeof(uint64_t);
+        {
+            vector_type::bufwriter_type writer(v.begin() + begin);
+            for (size_t i = 0; i < n / 4; ++i)
+                writer << i;
+        }
+        check_snapshot(snap, ref);
+
+        std::iota(ref.begin() + begin, ref.begin() + begin + n / 4, uint64_t(0));
+        check_snapshot(v, ref);
+        die_unless(*v.cbegin().bid() == *snap.cbegin().bid());
+        die_unless(*(v.cend() - 1).bid() == *(snap.cend() - 1).bid());
+    }
+}
+
+//! check a vector using the given pager with random and sequential access
+template <typename PagerType>
+void test_pager()
+{
+    using vector_type = stxxl::vector<uint64_t, 2, PagerType, 4096>;
+
+    const size_t n = 32 * 4096 / sizeof(uint64_t);
+    vector_type v(n);
+
+    std::vector<uint64_t> ref(n);
+    std::mt19937_64 randgen(1);
+
+    for (size_t i = 0; i < n; ++i)
+        v[i] = ref[i] = i;
+
+    for (size_t round = 0; round < 3; ++round)
+    {
+        // a hot set of two pages mixed with random updates
+        for (size_t k = 0; k < n / 4; ++k) {
+            const size_t i = (k % 3 == 0) ? randgen() % n : randgen() % 1024;
+            v[i] = ref[i] = randgen();
+        }
+
+        const vector_type& cv = v;
+        for (size_t i = 0; i < n; ++i)
+            die_unless(cv[i] == ref[i]);
+    }
+
+    v.flush();
+    for (size_t i = 0; i < n; ++i)
+        die_unless(v[i] == ref[i]);
+}
+
+//! check that a scan over pages used once does not evict a hot page
+template <typename PagerType>
+void test_pager_scan_resistance()
+{
+    const size_t npages = 8, hot = 3;
+    PagerType pager(npages);
+
+    // all pages are used; the hot page twice
+    for (size_t i = 0; i < npages; ++i)
+        pager.hit(i);
+    pager.hit(hot);
+    pager.hit(0);
+    pager.hit(hot);
+
+    for (size_t k = 0; k < 4 * npages; ++k)
+    {
+        const size_t i = pager.kick();
+        die_unless(i < npages);
+        die_unless(i != hot);
+        stxxl::pager_load(pager, i, 1000 + k);
+        pager.hit(i);
+    }
+}
+
+//! check parallel access in the concurrent mode
+void test_concurrent()
+{
+    using vector_type = stxxl::vector<uint64_t, 2, stxxl::lru_pager<4>, 4096>;
+
+    const size_t num_threads = 4;
+    const size_t page_elements = 2 * 4096 / sizeof(uint64_t);
+    const size_t num_pages = 32;
+    const size_t n = num_pages * page_elements;
+
+    vector_type v(n);
+    v.set_concurrent(true);
+    die_unless(v.concurrent());
+
+    // each thread fills every num_threads-th page through write pins
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t)
+    {
+        threads.emplace_back(
+            [&v, t]() {
+                for (size_t p = t; p < num_pages; p += num_threads)
+                {
+                    vector_type::page_pin pin = v.pin_page(p, true);
+                    for (size_t i = 0; i < page_elements; ++i)
+                        pin[i] = pin.first() + i;
+                }
+            });
+    }
+    for (std::thread& t : threads) t.join();
+    threads.clear();
+
+    // all threads read all pages, through read pins and operator[]
+    for (size_t t = 0; t < num_threads; ++t)
+    {
+        threads.emplace_back(
+            [&v, t]() {
+                const vector_type& cv = v;
+                const vector_type::access_scope scope(cv);
+                for (size_t k = 0; k < num_pages; ++k)
+                {
+                    const size_t p = (k + t * 7) % num_pages;
+                    const vector_type::page_pin pin = cv.pin_page(p);
+                    for (size_t i = 0; i < page_elements; ++i) {
+                        die_unless(pin[i] == pin.first() + i);
+                        die_unless(cv[pin.first() + i] == pin.first() + i);
+                    }
+                }
+            });
+    }
+    for (std::thread& t : threads) t.join();
+
+    v.set_concurrent(false);
+    for (size_t i = 0; i < n; ++i)
+        die_unless(v[i] == i);
+}
+
+//! check parallel writes through operator[] and iterators in the concurrent
+//! mode, over more pages than the cache holds
+void test_concurrent_elements()
+{
+    using vector_type = stxxl::vector<uint64_t, 2, stxxl::lru_pager<12>, 4096>;
+
+    const size_t num_threads = 4;
+    const size_t page_elements = 2 * 4096 / sizeof(uint64_t);
+    const size_t num_pages = 64;
+    const size_t n = num_pages * page_elements;
+    const size_t chunk = 100;
+
+    vector_type v(n);
+    v.set_concurrent(true);
+
+    // threads write interleaved chunks, which straddle pages
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t)
+    {
+        threads.emplace_back(
+            [&v, t, n]() {
+                const vector_type::access_scope scope(v);
+                for (size_t round = 0; round < 3; ++round)
+                {
+                    for (size_t c = t; c * chunk < n; c += num_threads)
+                    {
+                        for (size_t i = c * chunk; i < std::min(n, (c + 1) * chunk); ++i)
+                            v[i] = 3 * i + round;
+                    }
+                }
+            });
+    }
+    for (std::thread& t : threads) t.join();
+    threads.clear();
+
+    // copy between elements of different pages: v[i] = v[j]
+    for (size_t t = 0; t < num_threads; ++t)
+    {
+        threads.emplace_back(
+            [&v, t, n]() {
+                const vector_type::access_scope scope(v);
+                for (size_t i = t; i < n / 2; i += num_threads)
+                    v[i] = v[n / 2 + i] - 3 * (n / 2);
+            });
+    }
+    for (std::thread& t : threads) t.join();
+    threads.clear();
+
+    // read through iterators in parallel
+    for (size_t t = 0; t < num_threads; ++t)
+    {
+        threads.emplace_back(
+            [&v, t, n]() {
+                const vector_type& cv = v;
+                const vector_type::access_scope scope(cv);
+                size_t i = t * (n / num_threads);
+                for (vector_type::const_iterator it = cv.begin() + i;
+                     it != cv.begin() + (t + 1) * (n / num_threads); ++it, ++i)
+                    die_unless(*it == 3 * i + 2);
+            });
+    }
+    for (std::thread& t : threads) t.join();
+
+    v.set_concurrent(false);
+    for (size_t i = 0; i < n; ++i)
+        die_unless(v[i] == 3 * i + 2);
+}
+
+//! check that the access pins of many short-lived threads are released when
+//! they leave their access scope, with a cache holding only the pins of a
+//! few threads
+void test_concurrent_short_threads()
+{
+    using vector_type = stxxl::vector<uint64_t, 2, stxxl::lru_pager<12>, 4096>;
+
+    const size_t num_threads = 4;
+    const size_t page_elements = 2 * 4096 / sizeof(uint64_t);
+    const size_t num_pages = 64;
+    const size_t n = num_pages * page_elements;
+
+    vector_type v(n);
+    std::fill(v.begin(), v.end(), 0);
+    std::vector<uint64_t> ref(n, 0);
+    v.set_concurrent(true);
+
+    // each round starts new threads, which write to different pages
+    for (size_t round = 0; round < 64; ++round)
+    {
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < num_threads; ++t)
+        {
+            threads.emplace_back(
+                [&v, round, t]() {
+                    const vector_type::access_scope scope(v);
+                    for (size_t k = 0; k < 8; ++k)
+                    {
+                        const size_t p = (round * 5 + k * num_threads + t) % num_pages;
+                        const size_t i = p * page_elements + round;
+                        v[i] = i + 1;
+                    }
+                });
+
+            for (size_t k = 0; k < 8; ++k)
+            {
+                const size_t p = (round * 5 + k * num_threads + t) % num_pages;
+                ref[p * page_elements + round] = p * page_elements + round + 1;
+            }
+        }
+        for (std::thread& t : threads) t.join();
+    }
+
+    v.set_concurrent(false);
+    for (size_t i = 0; i < n; ++i)
+        die_unless(v[i] == ref[i]);
+}
+
 int main()
 {
     test_vector1();
     test_resize_shrink();
+    test_spare_pages(0);
+    test_spare_pages(1);
+    test_spare_pages(3);
+    test_bulk();
+    test_snapshot();
+    test_snapshot_algorithms();
+
+    test_pager<stxxl::random_pager<4> >();
+    test_pager<stxxl::lru_pager<4> >();
+    test_pager<stxxl::clock_pager<4> >();
+    test_pager<stxxl::twoq_pager<4> >();
+    test_pager<stxxl::arc_pager<4> >();
+
+    test_pager_scan_resistance<stxxl::twoq_pager<> >();
+    test_pager_scan_resistance<stxxl::arc_pager<> >();
+
+    test_concurrent();
+    test_concurrent_elements();
+    test_concurrent_short_threads();
 
     return 0;
 }
@@ -178,6 +648,9 @@ static_assert(std::is_same<stxxl::vector<double>, stxxl::vector<double>::const_i
 
 // forced instantiation
 template class stxxl::vector<element, 2, stxxl::lru_pager<2>, (1024* 1024), foxxll::striping>;
+template class stxxl::vector<element, 2, stxxl::clock_pager<2>, (1024* 1024), foxxll::striping>;
+template class stxxl::vector<element, 2, stxxl::twoq_pager<2>, (1024* 1024), foxxll::striping>;
+template class stxxl::vector<element, 2, stxxl::arc_pager<2>, (1024* 1024), foxxll::striping>;
 template class stxxl::vector<double>;
 template class stxxl::vector_iterator<stxxl::vector<double>::configuration_type>;
 template class stxxl::const_vector_iterator<stxxl::vector<double>::configuration_type>;
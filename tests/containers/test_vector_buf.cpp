@@ -14,6 +14,8 @@
 
 #include <algorithm>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 #include <tlx/die.hpp>
 #include <tlx/logger.hpp>
@@ -236,6 +238,37 @@ void test_vector_buf(size_t size)
 
         die_unless(reader.empty());
     }
+    {   // read overlapping ranges with cursors from several threads
+        foxxll::scoped_print_timer tm("multireader with 8 threads");
+        using multireader_type = typename vector_type::multireader_type;
+        using cursor_type = typename multireader_type::cursor;
+
+        const vector_type& cvec = vec;
+        multireader_type reader(cvec, 8);
+        std::vector<std::thread> threads;
+
+        for (size_t t = 0; t < 8; ++t)
+        {
+            threads.emplace_back(
+                [&cvec, &reader, size, t]() {
+                    const size_t begin = size * t / 10;
+                    const size_t end = std::min(size, begin + size / 3 + t);
+
+                    cursor_type cursor(reader, cvec.begin() + begin, cvec.begin() + end);
+                    for (size_t i = begin; i < end; ++i, ++cursor)
+                    {
+                        die_unless(cursor.size() == end - i);
+                        die_unless(*cursor == ValueType(i));
+                    }
+                    die_unless(cursor.empty());
+                });
+        }
+
+        for (std::thread& t : threads)
+            t.join();
+
+        die_unless(reader.cursors() == 0);
+    }
     {   // read vector using C++11 for loop construct
         foxxll::scoped_print_timer tm("C++11 for loop");
 
@@ -14,12 +14,18 @@
 //! This is an example of use of \c stxxl::vector::export_files
 
 #include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <vector>
 
 #include <tlx/die.hpp>
 #include <tlx/logger.hpp>
 
 #include <foxxll/common/timer.hpp>
+#include <foxxll/io.hpp>
 
 #include <stxxl/scan>
 #include <stxxl/vector>
@@ -28,8 +34,63 @@
 
 constexpr size_t export_size = 64 * 1024 * 1024;
 
+//! check that export_files() writes the current content of a vector which
+//! shares blocks with a snapshot and has dirty pages in its cache
+void test_snapshot_export()
+{
+    using vector_type = stxxl::vector<uint64_t, 2, stxxl::lru_pager<4>, 4096>;
+    const size_t block_items = vector_type::block_size / sizeof(uint64_t);
+
+    const size_t n = 16 * block_items + 7;
+    vector_type v(n);
+    for (size_t i = 0; i < n; ++i)
+        v[i] = i;
+
+    const vector_type snap = v.snapshot();
+    for (size_t i = 0; i < n; i += 100)
+        v[i] = i + 42;
+
+    LOG1 << "export files of snapshotted vector";
+    v.export_files("snapshot_exported_");
+
+    // the files are exported into the directory of the disk
+    for (size_t b = 0; b * block_items < n; ++b)
+    {
+        std::ostringstream name;
+        name << "/tmp/snapshot_exported_"
+             << std::setw(9) << std::setfill('0') << b;
+
+        std::vector<uint64_t> data(std::min(block_items, n - b * block_items));
+        {
+            std::ifstream file(name.str(), std::ios::binary);
+            die_unless(file.read(reinterpret_cast<char*>(data.data()),
+                                 data.size() * sizeof(uint64_t)));
+        }
+        std::remove(name.str().c_str());
+
+        for (size_t j = 0; j < data.size(); ++j)
+        {
+            const size_t i = b * block_items + j;
+            die_unequal(data[j], (i % 100 == 0) ? i + 42 : i);
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i)
+        die_unequal(snap[i], i);
+}
+
 int main()
 {
+    // export_files() moves the block files of a fileperblock disk
+    foxxll::config* config = foxxll::config::get_instance();
+
+    foxxll::disk_config disk1("/tmp/stxxl-export-$$.tmp", 128 * 1024 * 1024,
+                              "fileperblock_syscall");
+    disk1.direct = foxxll::disk_config::DIRECT_OFF;
+    config->add_disk(disk1);
+
+    test_snapshot_export();
+
     // use non-randomized striping to avoid side effects on random generator
     using vector_type = stxxl::vector<int64_t, 2, stxxl::lru_pager<2>, (2* 1024* 1024), foxxll::striping>;
     vector_type v(export_size / sizeof(int64_t));
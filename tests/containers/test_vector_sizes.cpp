@@ -19,6 +19,7 @@
 
 #include <foxxll/io.hpp>
 
+#include <stxxl/stream>
 #include <stxxl/vector>
 
 using my_type = int;
@@ -66,11 +67,59 @@ void test_rdonly(const char* fn, const char* ft, size_t sz, my_type ofs)
     }
 }
 
+void test_mapped(const char* fn, size_t sz, my_type ofs)
+{
+    const vector_type v(fn, vector_type::map_advice::sequential);
+    LOG1 << "reading " << v.size() << " elements (mapped=" << v.mapped() << ")";
+    die_unless(v.size() == sz);
+
+    size_t i = 0;
+    for (vector_type::const_iterator it = v.begin(); it != v.end(); ++it, ++i)
+        die_unless(*it == ofs + my_type(i));
+
+    auto stream = stxxl::stream::streamify(v.begin() + 1, v.end());
+    for (i = 1; !stream.empty(); ++stream, ++i)
+        die_unless(*stream == ofs + my_type(i));
+    die_unless(i == sz);
+
+    v.advise(vector_type::map_advice::random);
+    for (i = 0; i < sz; i += 997)
+        die_unless(v[i] == ofs + my_type(i));
+
+    if (!v.mapped())
+        return;
+
+    // mutable element access is rejected
+    vector_type mv(fn, vector_type::map_advice::normal);
+    bool caught = false;
+    try {
+        mv[0] = 0;
+    }
+    catch (foxxll::bad_parameter& e) {
+        LOG1 << "Caught exception: " << e.what();
+        caught = true;
+    }
+    die_unless(caught);
+
+    // mapping more elements than the file holds is rejected
+    caught = false;
+    try {
+        const vector_type big(fn, vector_type::map_advice::normal,
+                              v.size() + 2 * block_type::size);
+    }
+    catch (foxxll::bad_parameter& e) {
+        LOG1 << "Caught exception: " << e.what();
+        caught = true;
+    }
+    die_unless(caught);
+}
+
 void test(const char* fn, const char* ft, size_t sz, my_type ofs)
 {
     test_write(fn, ft, sz, ofs);
     test_rdwr<const vector_type>(fn, ft, sz, ofs);
     test_rdwr<vector_type>(fn, ft, sz, ofs);
+    test_mapped(fn, sz, ofs);
 
     // 2013-tb: there is a bug with read-only vectors on mmap backed files:
     // copying from mmapped area will fail for invalid ranges at the end,
@@ -19,6 +19,7 @@
 
 #include <stxxl/algorithm>
 #include <stxxl/bits/defines.h>
+#include <stxxl/comparator>
 #include <stxxl/stream>
 #include <stxxl/vector>
 
@@ -105,6 +106,37 @@ void check_42_fill(VectorType& v, typename VectorType::size_type length)
     std::fill(v.begin(), v.end(), value_type(0));
 }
 
+//! materialize a runs_merger into a vector, which adopts the merged blocks
+//! if expected
+template <typename VectorType>
+void test_runs_merger(size_t n, size_t skip, bool handoff)
+{
+    using cmp_type = stxxl::comparator<int>;
+    using runs_creator_type = stxxl::stream::runs_creator<
+              stxxl::stream::use_push<int>, cmp_type, 4096>;
+    using runs_merger_type = stxxl::stream::runs_merger<
+              runs_creator_type::sorted_runs_type, cmp_type>;
+
+    runs_creator_type creator(cmp_type(), 1024 * 1024);
+    for (size_t i = 0; i < n; ++i)
+        creator.push(static_cast<int>((i * 7919) % n));
+
+    runs_merger_type merger(creator.result(), cmp_type(), 1024 * 1024);
+    for (size_t i = 0; i < skip; ++i)
+        ++merger;
+
+    // previous content is replaced
+    VectorType v(1000);
+    die_unless(stxxl::stream::materialize(merger, v) == handoff);
+
+    die_unless(merger.empty());
+    die_unless(v.size() == n - skip);
+
+    auto ci = v.cbegin();
+    for (size_t i = skip; i < n; ++i, ++ci)
+        die_unless(*ci == static_cast<int>(i));
+}
+
 int main()
 {
     foxxll::config::get_instance();
@@ -160,4 +192,18 @@ int main()
         stxxl::stream::materialize(_42mill.reset(), v.begin(), v.end(), 42);
         check_42_fill(v, _42mill.len());
     }
+    {
+        // materialize runs_merger into whole stxxl vector with the block size
+        // of the runs, with block handoff
+        using vector_type = stxxl::vector<int, 4, stxxl::lru_pager<8>, 4096>;
+        test_runs_merger<vector_type>(0, 0, true);
+        test_runs_merger<vector_type>(42 * 10000, 0, true);
+        test_runs_merger<vector_type>(42 * 10000 + 17, 0, true);
+        // small run kept in internal memory, partially consumed merger
+        test_runs_merger<vector_type>(500, 0, false);
+        test_runs_merger<vector_type>(42 * 10000, 13, false);
+        // different block sizes: copying fallback
+        test_runs_merger<stxxl::vector<int> >(42 * 10000 + 17, 0, false);
+        test_runs_merger<stxxl::vector<int, 4, stxxl::lru_pager<8>, 8192> >(42 * 10000, 0, false);
+    }
 }
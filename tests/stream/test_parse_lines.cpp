@@ -0,0 +1,127 @@
+/***************************************************************************
+ *  tests/stream/test_parse_lines.cpp
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <tlx/die.hpp>
+#include <tlx/logger.hpp>
+
+#include <foxxll/io.hpp>
+
+#include <stxxl/stream>
+
+struct record
+{
+    uint64_t key;
+    uint64_t value;
+};
+
+// parses "key value" lines, skips empty lines and comments
+struct record_parser
+{
+    using value_type = record;
+
+    bool operator () (const char* begin, const char* end, record& r) const
+    {
+        if (begin == end || *begin == '#')
+            return false;
+
+        std::string line(begin, end);
+        char* next;
+        r.key = strtoull(line.c_str(), &next, 10);
+        r.value = strtoull(next, nullptr, 10);
+        return true;
+    }
+};
+
+// writes n records with varying line lengths and returns them
+std::vector<record> write_file(const char* fn, size_t n, bool final_newline)
+{
+    std::vector<record> expected;
+    std::ofstream out(fn, std::ios::trunc);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (i % 17 == 0) out << "\n";
+        if (i % 29 == 0) out << "# comment " << std::string(i % 300, 'x') << "\n";
+
+        record r = { i, i * i + 42 };
+        expected.push_back(r);
+        out << r.key << std::string(1 + i % 7, ' ') << r.value;
+        if (i + 1 != n || final_newline) out << "\n";
+    }
+
+    return expected;
+}
+
+template <size_t ChunkSize>
+void test(const char* fn, size_t n, bool final_newline, bool ordered)
+{
+    LOG1 << "parse_lines: n=" << n << " final_newline=" << final_newline
+         << " ordered=" << ordered << " ChunkSize=" << ChunkSize;
+
+    std::vector<record> expected = write_file(fn, n, final_newline);
+
+    foxxll::file_ptr f = tlx::make_counting<foxxll::syscall_file>(
+        fn, foxxll::file::RDONLY);
+
+    stxxl::stream::parse_lines<record_parser, record, ChunkSize> input(
+        f, record_parser(), 3, ordered);
+
+    std::vector<record> got;
+    for ( ; !input.empty(); ++input)
+        got.push_back(*input);
+
+    die_unless(got.size() == expected.size());
+
+    if (!ordered) {
+        std::sort(got.begin(), got.end(),
+                  [](const record& a, const record& b) { return a.key < b.key; });
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        die_unless(got[i].key == expected[i].key);
+        die_unless(got[i].value == expected[i].value);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: " << argv[0] << " file" << std::endl;
+        return -1;
+    }
+
+    foxxll::config::get_instance();
+
+    const char* fn = argv[1];
+
+    test<4096>(fn, 0, true, true);
+    test<4096>(fn, 1, false, true);
+    test<4096>(fn, 100, true, true);
+    test<4096>(fn, 100000, true, true);
+    test<4096>(fn, 100000, false, true);
+    test<4096>(fn, 100000, true, false);
+    test<64* 1024>(fn, 300000, false, true);
+    test<64* 1024>(fn, 300000, false, false);
+
+    {
+        foxxll::syscall_file f(fn, foxxll::file::RDWR);
+        f.close_remove();
+    }
+
+    return 0;
+}
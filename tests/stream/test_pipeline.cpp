@@ -0,0 +1,73 @@
+/***************************************************************************
+ *  tests/stream/test_pipeline.cpp
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <tlx/die.hpp>
+
+#include <stxxl/stream>
+
+void test_pipeline(size_t n)
+{
+    std::vector<uint64_t> input(n);
+    for (size_t i = 0; i < n; ++i)
+        input[i] = i;
+
+    // hand-written loop
+    std::vector<std::pair<uint64_t, uint64_t> > expected;
+    for (const uint64_t& x : input)
+    {
+        uint64_t y = x * 3;
+        if (y % 2 != 0) continue;
+        if (y % 5 == 0) continue;
+        expected.emplace_back(x, y + 1);
+    }
+
+    auto stages =
+        stxxl::stream::map_op([](const uint64_t& x) { return std::make_pair(x, x * 3); })
+        | stxxl::stream::filter_op([](const std::pair<uint64_t, uint64_t>& p) { return p.second % 2 == 0; })
+        | stxxl::stream::filter_op([](const std::pair<uint64_t, uint64_t>& p) { return p.second % 5 != 0; })
+        | stxxl::stream::map_op([](const std::pair<uint64_t, uint64_t>& p) {
+                                    return std::make_pair(p.first, p.second + 1);
+                                });
+
+    {
+        auto in = stxxl::stream::streamify(input.begin(), input.end());
+        auto s = stxxl::stream::make_pipeline(in, stages);
+
+        size_t i = 0;
+        for ( ; !s.empty(); ++s, ++i)
+        {
+            die_unless(i < expected.size());
+            die_unless(*s == expected[i]);
+            die_unless(s->second == expected[i].second);
+        }
+        die_unless(i == expected.size());
+    }
+    {
+        auto in = stxxl::stream::streamify(input.begin(), input.end());
+
+        std::vector<std::pair<uint64_t, uint64_t> > out;
+        stxxl::stream::run_pipeline(
+            in, stages,
+            [&out](const std::pair<uint64_t, uint64_t>& p) { out.push_back(p); });
+        die_unless(out == expected);
+    }
+}
+
+int main()
+{
+    test_pipeline(0);
+    test_pipeline(1);
+    test_pipeline(100000);
+    return 0;
+}
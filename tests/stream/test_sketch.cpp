@@ -0,0 +1,125 @@
+/***************************************************************************
+ *  tests/stream/test_sketch.cpp
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <tlx/die.hpp>
+#include <tlx/logger.hpp>
+
+#include <stxxl/stream>
+
+using value_type = uint64_t;
+
+// input with n items, every tenth item is 7
+std::vector<value_type> make_input(size_t n, size_t distinct)
+{
+    std::vector<value_type> v(n);
+    for (size_t i = 0; i < n; ++i)
+        v[i] = (i % 10 == 0) ? 7 : (i * 2654435761u) % distinct;
+    return v;
+}
+
+size_t count_distinct(std::vector<value_type> v)
+{
+    std::sort(v.begin(), v.end());
+    return static_cast<size_t>(std::unique(v.begin(), v.end()) - v.begin());
+}
+
+void test_pass_through()
+{
+    std::vector<value_type> input = make_input(100000, 5000);
+
+    stxxl::stream::hyperloglog<value_type> hll;
+    stxxl::stream::count_min<value_type> cm(1024, 4, 4);
+    stxxl::stream::reservoir_sample<value_type> rs(100);
+
+    auto s0 = stxxl::stream::streamify(input.begin(), input.end());
+    auto s1 = stxxl::stream::make_sketch(s0, hll);
+    auto s2 = stxxl::stream::make_sketch(s1, cm);
+    auto s3 = stxxl::stream::make_sketch(s2, rs);
+
+    // stream is passed through unchanged
+    size_t i = 0;
+    for ( ; !s3.empty(); ++s3, ++i)
+        die_unless(*s3 == input[i]);
+    die_unless(i == input.size());
+
+    // distinct count within 5%
+    const double distinct = static_cast<double>(count_distinct(input));
+    LOG1 << "hyperloglog estimate " << hll.estimate() << " of " << distinct;
+    die_unless(std::fabs(hll.estimate() - distinct) < 0.05 * distinct);
+
+    // frequencies are never underestimated, 7 is the heaviest hitter
+    die_unless(cm.total() == input.size());
+    die_unless(cm.estimate(7) >= input.size() / 10);
+    die_unless(!cm.heavy_hitters().empty());
+    die_unless(cm.heavy_hitters()[0].first == 7);
+
+    die_unless(rs.seen() == input.size());
+    die_unless(rs.samples().size() == 100);
+    for (const value_type& x : rs.samples())
+        die_unless(x == 7 || x < 5000);
+}
+
+void test_merge()
+{
+    const size_t n = 1000000;
+
+    stxxl::stream::hyperloglog<value_type> hll_a, hll_b, hll_all;
+    stxxl::stream::count_min<value_type> cm_a(4096, 4, 8), cm_b(4096, 4, 8);
+    stxxl::stream::reservoir_sample<value_type> rs_a(1000), rs_b(1000);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        hll_all.insert(i);
+        // every fourth item is 1000, the others are spread over 100 keys
+        if (i < n / 2) {
+            hll_a.insert(i);
+            cm_a.insert((i % 4 == 0) ? 1000 : i % 100);
+            rs_a.insert(i);
+        }
+        else {
+            hll_b.insert(i);
+            cm_b.insert((i % 4 == 0) ? 1000 : i % 100 + 50);
+            rs_b.insert(i);
+        }
+    }
+
+    hll_a.merge(hll_b);
+    LOG1 << "merged hyperloglog estimate " << hll_a.estimate() << " of " << n;
+    die_unless(hll_a.estimate() == hll_all.estimate());
+    die_unless(std::fabs(hll_a.estimate() - n) < 0.03 * n);
+
+    cm_a.merge(cm_b);
+    die_unless(cm_a.total() == n);
+    die_unless(cm_a.estimate(1000) >= n / 4);
+    die_unless(cm_a.heavy_hitters().size() == 8);
+    die_unless(cm_a.heavy_hitters()[0].first == 1000);
+
+    // roughly half of the merged samples come from each input
+    rs_a.merge(rs_b);
+    die_unless(rs_a.seen() == n);
+    die_unless(rs_a.samples().size() == 1000);
+    size_t from_a = 0;
+    for (const value_type& x : rs_a.samples())
+        from_a += (x < n / 2);
+    LOG1 << "merged reservoir: " << from_a << " samples from first half";
+    die_unless(from_a > 400 && from_a < 600);
+}
+
+int main()
+{
+    test_pass_through();
+    test_merge();
+    return 0;
+}
@@ -0,0 +1,102 @@
+/***************************************************************************
+ *  tests/stream/test_window.cpp
+ *
+ *  Part of the STXXL. See http://stxxl.org
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#define STXXL_DEFAULT_BLOCK_SIZE(T) 4096
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <tlx/die.hpp>
+#include <tlx/logger.hpp>
+
+#include <stxxl/stream>
+
+using value_type = uint64_t;
+
+struct key_fn
+{
+    // three items per time unit
+    value_type operator () (const value_type& x) const { return x / 3; }
+};
+
+struct sum_agg
+{
+    using value_type = uint64_t;
+
+    value_type sum = 0;
+
+    void add(const uint64_t& x) { sum += x; }
+    void remove(const uint64_t& x) { sum -= x; }
+    value_type result() const { return sum; }
+};
+
+void test_window(size_t n)
+{
+    std::vector<value_type> input(n);
+    for (size_t i = 0; i < n; ++i)
+        input[i] = i * i;
+
+    auto s = stxxl::stream::streamify(input.begin(), input.end());
+    stxxl::stream::window<decltype(s), 5> w(s);
+
+    size_t i = 0;
+    for ( ; !w.empty(); ++w, ++i)
+    {
+        die_unless(*w == input[i]);
+        die_unless(w.size() == std::min<size_t>(i + 1, 5));
+        for (size_t j = 0; j < w.size(); ++j)
+            die_unless(w[j] == input[i - j]);
+    }
+    die_unless(i == n);
+}
+
+void test_rolling_aggregate(size_t n, value_type width, size_t memory_items)
+{
+    LOG1 << "rolling_aggregate: n=" << n << " width=" << width
+         << " memory_items=" << memory_items;
+
+    std::vector<value_type> input(n);
+    for (size_t i = 0; i < n; ++i)
+        input[i] = i;
+
+    auto s = stxxl::stream::streamify(input.begin(), input.end());
+    stxxl::stream::rolling_aggregate<decltype(s), key_fn, sum_agg> agg(
+        s, key_fn(), width, sum_agg(), memory_items);
+
+    size_t i = 0, lo = 0;
+    value_type sum = 0;
+    for ( ; !agg.empty(); ++agg, ++i)
+    {
+        sum += input[i];
+        while (input[lo] / 3 + width <= input[i] / 3)
+            sum -= input[lo++];
+
+        die_unless(agg->first == input[i]);
+        die_unless(agg->second == sum);
+        die_unless(agg.window_size() == i + 1 - lo);
+    }
+    die_unless(i == n);
+}
+
+int main()
+{
+    test_window(0);
+    test_window(3);
+    test_window(1000);
+
+    test_rolling_aggregate(0, 10, 16);
+    test_rolling_aggregate(10000, 10, 1024);
+    // window larger than the in-memory ring: spills to a sequence
+    test_rolling_aggregate(10000, 10, 16);
+    test_rolling_aggregate(1000000, 100000, 1000);
+
+    return 0;
+}
@@ -17,6 +17,7 @@
 #include <limits>
 #include <queue>
 #include <random>
+#include <string>
 
 #include <tlx/logger.hpp>
 
@@ -32,6 +33,7 @@
 #include <foxxll/common/timer.hpp>
 
 #include <stxxl/priority_queue>
+#include <stxxl/radix_heap>
 
 const size_t mega = 1024 * 1024;
 constexpr bool debug = false;
@@ -115,6 +117,110 @@ struct my_cmp /*: public std::binary_function<my_type, my_type, bool>*/ // great
     }
 };
 
+//! run the same op-sequences on a stxxl::radix_heap
+void run_radix_heap(uint64_t nelements)
+{
+    struct my_data
+    {
+        char data[RECORD_SIZE - sizeof(my_key_type)];
+    };
+    using heap_type = stxxl::radix_heap<my_key_type, my_data>;
+
+    LOG1 << "Radix heap buckets: " << heap_type::num_buckets;
+    LOG1 << "Data type size: " << sizeof(heap_type::value_type);
+    LOG1 << "";
+
+    foxxll::stats_data sd_start(*foxxll::stats::get_instance());
+    foxxll::timer Timer;
+    Timer.start();
+
+    heap_type p;
+    my_data data;
+    my_key_type r, least = 0, last_least = 0, sum_input = 0, sum_output = 0;
+
+    std::mt19937_64 randgen;
+    std::uniform_int_distribution<my_key_type> distr_key(0, 0x10000000 - 1);
+
+    LOG1 << "op-sequence(monotonic pq): ( push, pop, push ) * n";
+    for (uint64_t i = 0; i < nelements; ++i)
+    {
+        if ((i % mega) == 0)
+            LOG1 << std::fixed << std::setprecision(2) << std::setw(5)
+                 << (100.0 * static_cast<double>(i) / nelements) << "% "
+                 << "Inserting element " << i << " top() == " << least << " @ "
+                 << std::setprecision(3) << Timer.seconds() << " s"
+                 << std::setprecision(6) << std::resetiosflags(std::ios_base::floatfield);
+
+        r = least + distr_key(randgen);
+        sum_input += r;
+        p.push(r, data);
+
+        least = p.top().first;
+        sum_output += least;
+        p.pop();
+
+        if (least < last_least)
+            LOG1 << "Wrong order at  " << i << "  " << last_least << " > " << least;
+        else
+            last_least = least;
+
+        r = least + distr_key(randgen);
+        sum_input += r;
+        p.push(r, data);
+    }
+    Timer.stop();
+    LOG1 << "Time spent for filling: " << Timer.seconds() << " s";
+
+    foxxll::stats_data sd_middle(*foxxll::stats::get_instance());
+    std::cout << sd_middle - sd_start;
+    Timer.reset();
+    Timer.start();
+
+    LOG1 << "op-sequence(monotonic pq): ( pop, push, pop ) * n";
+    for (uint64_t i = 0; i < nelements; ++i)
+    {
+        assert(!p.empty());
+
+        least = p.top().first;
+        sum_output += least;
+        p.pop();
+        if (least < last_least)
+            LOG1 << "Wrong result at " << i << "  " << last_least << " > " << least;
+        else
+            last_least = least;
+
+        r = least + distr_key(randgen);
+        sum_input += r;
+        p.push(r, data);
+
+        least = p.top().first;
+        sum_output += least;
+        p.pop();
+        if (least < last_least)
+            LOG1 << "Wrong result at " << i << "  " << last_least << " > " << least;
+        else
+            last_least = least;
+
+        if ((i % mega) == 0)
+            LOG1 << std::fixed << std::setprecision(2) << std::setw(5)
+                 << (100.0 * static_cast<double>(i) / nelements) << "% "
+                 << "Popped element " << i << " == " << least << " @ "
+                 << std::setprecision(3) << Timer.seconds() << " s"
+                 << std::setprecision(6) << std::resetiosflags(std::ios_base::floatfield);
+    }
+    LOG1 << "Last element " << nelements << " popped";
+    Timer.stop();
+
+    if (sum_input != sum_output)
+        LOG1 << "WRONG sum! " << sum_input << " - " << sum_output << " = " << (sum_output - sum_input) << " / " << (sum_input - sum_output);
+
+    LOG1 << "Time spent for removing elements: " << Timer.seconds() << " s";
+    std::cout << foxxll::stats_data(*foxxll::stats::get_instance()) - sd_middle;
+    std::cout << *foxxll::stats::get_instance();
+
+    assert(sum_input == sum_output);
+}
+
 int main(int argc, char* argv[])
 {
     if (argc < 3)
@@ -123,10 +229,19 @@ int main(int argc, char* argv[])
             #if defined(STXXL_PARALLEL)
             << " [p threads]"
             #endif
+            << " [radix]"
             << std::endl;
         return -1;
     }
 
+    if (argc > 3 && std::string(argv[3]) == "radix")
+    {
+        LOG1 << "----------------------------------------";
+        LOG1 << "radix_heap";
+        run_radix_heap(uint64_t(atoi(argv[1])) * mega / RECORD_SIZE);
+        return 0;
+    }
+
     LOG1 << "----------------------------------------";
 
     foxxll::config::get_instance();